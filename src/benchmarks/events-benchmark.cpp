@@ -0,0 +1,222 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "actor-register.h"
+#include "actor.h"
+#include "event-loop.h"
+#include "event-queue.h"
+#include "event.h"
+#include "logger.h"
+
+/**
+ * Micro-benchmarks of the events library and the logger. Results are written
+ * as JSON by the run-events-benchmark target or by
+ * events-benchmark --benchmark_out=<file> --benchmark_out_format=json
+ */
+
+namespace {
+
+using namespace sim;
+using namespace sim::events;
+
+/// Actor which does nothing, so only the loop itself is measured
+class NopActor : public IActor
+{
+ public:
+    NopActor() : IActor("Nop", kTag) {}
+
+    static constexpr ActorTag kTag = ActorTag::kNone;
+    using TagOwner = NopActor;
+
+    void HandleEvent(const Event* event) override
+    {
+        benchmark::DoNotOptimize(event);
+    }
+};
+
+enum class TimeDistribution
+{
+    kSameTick,
+    kUniform,
+    kBursty,
+};
+
+/// Turns off all log sinks, so logs of the benchmarked code cost nothing
+void
+SilenceLogger()
+{
+    auto& logger = SimulatorLogger::GetLogger();
+    logger.SetMaxConsoleSeverity(LogSeverity::kError);
+    logger.SetMaxCSVSeverity(LogSeverity::kError);
+    logger.SetTimeCallback([] { return TimeStamp{0}; });
+}
+
+/// Delays of events from the current time
+std::vector<uint32_t>
+MakeDelays(TimeDistribution distribution, size_t count)
+{
+    std::mt19937 generator{42};
+    std::vector<uint32_t> delays(count);
+
+    switch (distribution) {
+        case TimeDistribution::kSameTick: {
+            std::fill(delays.begin(), delays.end(), 1);
+            break;
+        }
+        case TimeDistribution::kUniform: {
+            std::uniform_int_distribution<uint32_t> delay{1, 10000};
+            for (auto& d : delays) {
+                d = delay(generator);
+            }
+            break;
+        }
+        case TimeDistribution::kBursty: {
+            // most events come in rare bursts, the rest are spread uniformly
+            std::uniform_int_distribution<uint32_t> burst{0, 9};
+            std::uniform_int_distribution<uint32_t> noise{1, 10000};
+            std::bernoulli_distribution in_burst{0.9};
+            for (auto& d : delays) {
+                d = in_burst(generator) ? 1 + burst(generator) * 1000
+                                        : noise(generator);
+            }
+            break;
+        }
+    }
+
+    return delays;
+}
+
+/**
+ * Inserts range(0) events with the given distribution of timestamps and
+ * simulates them all, range(1) selects the queue: 0 - calendar, 1 - map
+ */
+void
+BM_EventLoop(benchmark::State& state, TimeDistribution distribution)
+{
+    SilenceLogger();
+
+    auto count = static_cast<size_t>(state.range(0));
+    auto delays = MakeDelays(distribution, count);
+
+    ActorRegister actor_register;
+    UUID actor = actor_register.Make<NopActor>("nop")->GetUUID();
+
+    EventLoop loop{MakeEventQueue(state.range(1) == 0 ? "calendar" : "map")};
+    loop.SetActorFromUUIDCallback(
+        [&](UUID uuid) { return actor_register.GetActor<IActor>(uuid); });
+    loop.SetUpdateWorldCallback([] {});
+
+    for (auto _ : state) {
+        auto now = loop.Now();
+        for (auto delay : delays) {
+            loop.Insert(MakeEvent<Event>(actor, now + delay, nullptr));
+        }
+        loop.SimulateAll();
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetLabel(state.range(1) == 0 ? "calendar" : "map");
+}
+
+BENCHMARK_CAPTURE(BM_EventLoop, same_tick, TimeDistribution::kSameTick)
+    ->ArgsProduct({{1 << 10, 1 << 16}, {0, 1}});
+BENCHMARK_CAPTURE(BM_EventLoop, uniform, TimeDistribution::kUniform)
+    ->ArgsProduct({{1 << 10, 1 << 16}, {0, 1}});
+BENCHMARK_CAPTURE(BM_EventLoop, bursty, TimeDistribution::kBursty)
+    ->ArgsProduct({{1 << 10, 1 << 16}, {0, 1}});
+
+/// Lookup of random actors among range(0) registered ones
+void
+BM_GetActor(benchmark::State& state)
+{
+    SilenceLogger();
+
+    auto count = static_cast<size_t>(state.range(0));
+
+    ActorRegister actor_register;
+    std::vector<UUID> actors;
+    actors.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        actors.push_back(
+            actor_register.Make<NopActor>("nop-" + std::to_string(i))
+                ->GetUUID());
+    }
+
+    std::mt19937 generator{42};
+    std::shuffle(actors.begin(), actors.end(), generator);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            actor_register.GetActor<NopActor>(actors[i]));
+        if (++i == count) {
+            i = 0;
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_GetActor)->Arg(1000)->Arg(100000)->Arg(1000000);
+
+/// Event is taken from the pool and returned back
+void
+BM_MakeEvent(benchmark::State& state)
+{
+    for (auto _ : state) {
+        auto event = MakeEvent<Event>(UUID{}, 1, nullptr);
+        benchmark::DoNotOptimize(event);
+        ReleaseEvent(event);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_MakeEvent);
+
+/**
+ * Cost of a log call for the simulation thread, range(0) == 1 adds a sink
+ * accepting the message. The sink is a callback, so the console is not
+ * flooded
+ */
+void
+BM_Log(benchmark::State& state)
+{
+    SilenceLogger();
+
+    auto& logger = SimulatorLogger::GetLogger();
+    bool sinks_on = state.range(0) == 1;
+    if (sinks_on) {
+        logger.PushLoggingCallback(
+            [](TimeStamp, LogSeverity, std::string_view, std::string_view,
+               std::string_view message) {
+                benchmark::DoNotOptimize(message.data());
+            });
+    }
+
+    std::string name{"server-1"};
+    TimeStamp i = 0;
+    for (auto _ : state) {
+        logger.Log(i, LogSeverity::kInfo, "Server", name,
+                   "VM {} is hosted here, workload {}", i, i * 2);
+        ++i;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(sinks_on ? "sinks on" : "sinks off");
+
+    if (sinks_on) {
+        logger.PopLoggingCallback();
+    }
+}
+
+BENCHMARK(BM_Log)->Arg(0)->Arg(1);
+
+}   // namespace
+
+BENCHMARK_MAIN();
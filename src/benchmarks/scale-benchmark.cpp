@@ -0,0 +1,356 @@
+#include <fmt/core.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <argparse.hpp>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "event.h"
+#include "logger.h"
+#include "world.h"
+
+/**
+ * Headless end-to-end benchmark: builds a synthetic cloud of N data centers
+ * with M servers each, injects K VM operations (create, provision, stop,
+ * delete) with the given arrival process and simulates them. Reports event
+ * throughput, peak RSS and time spent in world updates and schedulers.
+ */
+
+namespace {
+
+using namespace sim;
+
+enum class OperationType
+{
+    kCreate,
+    kProvision,
+    kStop,
+    kDelete,
+};
+
+struct Operation
+{
+    TimeStamp time;
+    OperationType type;
+    uint32_t vm;
+};
+
+struct Options
+{
+    uint32_t data_centers, servers, operations, burst_size;
+    double arrival_rate, vm_lifetime;
+    std::string arrival;
+    uint64_t seed;
+};
+
+/**
+ * Arrival times of VMs: "poisson" - exponential intervals, "uniform" - equal
+ * intervals, "bursty" - groups of burst_size VMs arriving at once
+ */
+std::vector<TimeStamp>
+MakeArrivals(const Options& options, uint32_t vms_count,
+             std::mt19937_64& generator)
+{
+    std::vector<TimeStamp> arrivals(vms_count);
+    std::exponential_distribution<double> interval{options.arrival_rate};
+
+    double time = 1;
+    for (uint32_t i = 0; i < vms_count; ++i) {
+        if (options.arrival == "poisson") {
+            time += interval(generator);
+        } else if (options.arrival == "uniform") {
+            time += 1 / options.arrival_rate;
+        } else if (options.arrival == "bursty") {
+            if (i % options.burst_size == 0) {
+                time += options.burst_size / options.arrival_rate;
+            }
+        } else {
+            throw std::runtime_error("Unknown arrival process: " +
+                                     options.arrival);
+        }
+        arrivals[i] = static_cast<TimeStamp>(time);
+    }
+
+    return arrivals;
+}
+
+/**
+ * Life cycle of each VM: create, provision on the next tick (the VM should be
+ * registered first), stop after lifetime, then delete
+ */
+std::vector<Operation>
+MakeOperations(const Options& options)
+{
+    std::mt19937_64 generator{options.seed};
+    std::exponential_distribution<double> lifetime{1 / options.vm_lifetime};
+
+    uint32_t vms_count = (options.operations + 3) / 4;
+    auto arrivals = MakeArrivals(options, vms_count, generator);
+
+    std::vector<Operation> operations;
+    operations.reserve(vms_count * 4);
+    for (uint32_t vm = 0; vm < vms_count; ++vm) {
+        auto provision_time = arrivals[vm] + 1;
+        auto stop_time =
+            provision_time + 1 +
+            static_cast<TimeStamp>(std::round(lifetime(generator)));
+
+        operations.push_back({arrivals[vm], OperationType::kCreate, vm});
+        operations.push_back({provision_time, OperationType::kProvision, vm});
+        operations.push_back({stop_time, OperationType::kStop, vm});
+        operations.push_back({stop_time + 1, OperationType::kDelete, vm});
+    }
+    operations.resize(options.operations);
+
+    std::stable_sort(operations.begin(), operations.end(),
+                     [](const Operation& lhs, const Operation& rhs) {
+                         return lhs.time < rhs.time;
+                     });
+
+    return operations;
+}
+
+std::shared_ptr<core::SimulatorConfig>
+MakeConfig(const argparse::ArgumentParser& parser, const Options& options)
+{
+    auto config = std::make_shared<core::SimulatorConfig>();
+
+    config->SetLogsPath(parser.get<std::string>("--logs-folder"));
+    config->SetEventQueueType(parser.get<std::string>("--event-queue"));
+    config->SetCloudScheduler(parser.get<std::string>("--cloud-scheduler"));
+    config->SetSchedulerThreads(
+        std::stoi(parser.get<std::string>("--scheduler-threads")));
+    config->SetExecutionMode(parser.get<std::string>("--execution"));
+    config->SetExecutionThreads(
+        std::stoi(parser.get<std::string>("--execution-threads")));
+    config->SetOptimisticWindow(
+        std::stoll(parser.get<std::string>("--optimistic-window")));
+    config->SetMaxLogSeverity(LogSeverity::kError);
+
+    config->AddServerSpec(
+        "server", {RAMBytes{64}, 32, IOBandwidthMBpS{4000},
+                   std::make_shared<infra::LinearPowerModel>(100, 250)});
+
+    for (uint32_t i = 1; i <= options.data_centers; ++i) {
+        config->AddDataCenter({"dc-" + std::to_string(i),
+                               {{"server", options.servers, "greedy"}}});
+    }
+
+    return config;
+}
+
+void
+ApplyOperation(core::World& world, const Operation& operation)
+{
+    auto vm_name = "vm-" + std::to_string(operation.vm);
+
+    switch (operation.type) {
+        case OperationType::kCreate: {
+            world.CreateVM(vm_name, "constant",
+                           {{"required_ram", "4"},
+                            {"required_cpu", "10"},
+                            {"required_bandwidth", "10"}});
+            break;
+        }
+        case OperationType::kProvision: {
+            world.DoProvisionVM(vm_name);
+            break;
+        }
+        case OperationType::kStop: {
+            world.DoStopVM(vm_name);
+            break;
+        }
+        case OperationType::kDelete: {
+            world.DoDeleteVM(vm_name);
+            break;
+        }
+    }
+}
+
+double
+Seconds(std::chrono::nanoseconds duration)
+{
+    return std::chrono::duration<double>(duration).count();
+}
+
+}   // namespace
+
+int
+main(int argc, char** argv)
+{
+    argparse::ArgumentParser parser("scale-benchmark");
+
+    parser.add_argument("--data-centers")
+        .help("Count of data centers")
+        .nargs(1)
+        .default_value(std::string{"10"});
+
+    parser.add_argument("--servers")
+        .help("Count of servers in each data center")
+        .nargs(1)
+        .default_value(std::string{"100"});
+
+    parser.add_argument("--operations")
+        .help("Count of VM operations: create, provision, stop, delete")
+        .nargs(1)
+        .default_value(std::string{"100000"});
+
+    parser.add_argument("--arrival")
+        .help("Arrival process of VMs: \"poisson\", \"uniform\" or \"bursty\"")
+        .nargs(1)
+        .default_value(std::string{"poisson"});
+
+    parser.add_argument("--arrival-rate")
+        .help("Mean count of new VMs per tick")
+        .nargs(1)
+        .default_value(std::string{"10"});
+
+    parser.add_argument("--burst-size")
+        .help("Count of VMs arriving at once with \"bursty\" arrival")
+        .nargs(1)
+        .default_value(std::string{"100"});
+
+    parser.add_argument("--vm-lifetime")
+        .help("Mean count of ticks between provision and stop of a VM")
+        .nargs(1)
+        .default_value(std::string{"100"});
+
+    parser.add_argument("--seed")
+        .help("Seed of the generator of operations")
+        .nargs(1)
+        .default_value(std::string{"42"});
+
+    parser.add_argument("--logs-folder")
+        .help("Path to the folder where to write logs")
+        .nargs(1)
+        .default_value(std::string{"."});
+
+    parser.add_argument("--event-queue")
+        .help("Event queue implementation: \"calendar\" or \"map\"")
+        .nargs(1)
+        .default_value(std::string{"calendar"});
+
+    parser.add_argument("--cloud-scheduler")
+        .help("Cloud scheduler: \"greedy\", \"best-fit\" or \"worst-fit\"")
+        .nargs(1)
+        .default_value(std::string{"greedy"});
+
+    parser.add_argument("--scheduler-threads")
+        .help("Number of threads updating server schedulers")
+        .nargs(1)
+        .default_value(std::string{"1"});
+
+    parser.add_argument("--execution")
+        .help("Execution of events: \"serial\", \"conservative\" or "
+              "\"optimistic\"")
+        .nargs(1)
+        .default_value(std::string{"serial"});
+
+    parser.add_argument("--execution-threads")
+        .help("Number of threads of the parallel execution")
+        .nargs(1)
+        .default_value(std::string{"4"});
+
+    parser.add_argument("--optimistic-window")
+        .help("Ticks between world updates in the optimistic execution")
+        .nargs(1)
+        .default_value(std::string{"16"});
+
+    try {
+        parser.parse_args(argc, argv);
+
+        Options options{
+            .data_centers = static_cast<uint32_t>(
+                std::stoul(parser.get<std::string>("--data-centers"))),
+            .servers = static_cast<uint32_t>(
+                std::stoul(parser.get<std::string>("--servers"))),
+            .operations = static_cast<uint32_t>(
+                std::stoul(parser.get<std::string>("--operations"))),
+            .burst_size = static_cast<uint32_t>(
+                std::stoul(parser.get<std::string>("--burst-size"))),
+            .arrival_rate =
+                std::stod(parser.get<std::string>("--arrival-rate")),
+            .vm_lifetime =
+                std::stod(parser.get<std::string>("--vm-lifetime")),
+            .arrival = parser.get<std::string>("--arrival"),
+            .seed = std::stoull(parser.get<std::string>("--seed")),
+        };
+
+        auto operations = MakeOperations(options);
+
+        auto setup_start = std::chrono::steady_clock::now();
+
+        core::World world{MakeConfig(parser, options)};
+        world.Setup();
+        world.DoResourceAction("cloud-1", infra::ResourceEventType::kBoot);
+
+        auto start = std::chrono::steady_clock::now();
+        auto events_before = events::GetEventPoolStats().released;
+
+        for (const auto& operation : operations) {
+            if (operation.time > world.Now()) {
+                world.SimulateUntil(operation.time - 1);
+            }
+            ApplyOperation(world, operation);
+        }
+        world.SimulateAll();
+
+        auto finish = std::chrono::steady_clock::now();
+        auto events_count =
+            events::GetEventPoolStats().released - events_before;
+        if (auto time_warp = world.GetTimeWarpStats()) {
+            // cancelled speculative events are released too
+            events_count = time_warp->committed;
+        }
+
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+
+        const auto& stats = world.GetUpdateWorldStats();
+        auto run_time = Seconds(finish - start);
+
+        fmt::print("servers:                 {}\n",
+                   options.data_centers * options.servers);
+        fmt::print("operations:              {}\n", operations.size());
+        fmt::print("simulated ticks:         {}\n", world.Now());
+        fmt::print("setup time:              {:.3f} s\n",
+                   Seconds(start - setup_start));
+        fmt::print("run time:                {:.3f} s\n", run_time);
+        fmt::print("events:                  {}\n", events_count);
+        fmt::print("events/sec:              {:.0f}\n",
+                   events_count / run_time);
+        fmt::print("peak RSS:                {} MiB\n", usage.ru_maxrss / 1024);
+        fmt::print("update_world calls:      {}\n", stats.updates);
+        fmt::print("time per update_world:   {:.3f} us\n",
+                   stats.updates
+                       ? Seconds(stats.total_time) * 1e6 / stats.updates
+                       : 0.0);
+        fmt::print("server schedulers time:  {:.3f} s\n",
+                   Seconds(stats.server_schedulers_time));
+        fmt::print("cloud scheduler calls:   {}\n",
+                   stats.cloud_scheduler_updates);
+        fmt::print("cloud scheduler time:    {:.3f} s\n",
+                   Seconds(stats.cloud_scheduler_time));
+
+        if (auto time_warp = world.GetTimeWarpStats()) {
+            fmt::print("handled events:          {}\n", time_warp->handled);
+            fmt::print("rolled back events:      {}\n",
+                       time_warp->rolled_back);
+            fmt::print("stragglers:              {}\n", time_warp->stragglers);
+            fmt::print("anti-messages:           {}\n",
+                       time_warp->anti_messages);
+            fmt::print("windows / rounds:        {} / {}\n", time_warp->windows,
+                       time_warp->rounds);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
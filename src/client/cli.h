@@ -25,9 +25,10 @@ class CLI
     std::function<void(const std::string&)> process_callback;
 
     // words to be completed
-    std::vector<std::string> examples{"help",      "boot",         "shutdown",
-                                      "create-vm", "provision-vm", "delete-vm",
-                                      "stop-vm"};
+    std::vector<std::string> examples{
+        "help",      "boot",    "shutdown", "create-vm", "provision-vm",
+        "delete-vm", "stop-vm", "batch",    "stream",    "simulate-until",
+        "simulate-steps", "log-filter"};
 
     // the path to the history file
     std::string history_file{"./client_history.txt"};
@@ -65,6 +66,11 @@ class CLI
         {"provision-vm", cl::BLUE},
         {"stop-vm", cl::GRAY},
         {"create-vm", cl::YELLOW},
+        {"batch", cl::BRIGHTGREEN},
+        {"stream", cl::BRIGHTGREEN},
+        {"simulate-until", cl::BRIGHTGREEN},
+        {"simulate-steps", cl::BRIGHTGREEN},
+        {"log-filter", cl::BRIGHTGREEN},
 
         // commands
         {"help", cl::BRIGHTMAGENTA},
@@ -1,6 +1,12 @@
 #include "rpc-client.h"
 
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <unordered_set>
+#include <utility>
 
 #include "logger.h"
 
@@ -18,20 +24,113 @@ sim::client::SimulatorRPCClient::ProcessInput(const std::string& input)
     std::string command;
     iss >> command;
 
-    Empty reply;
+    if (command == "batch") {
+        std::string path;
+        iss >> path;
+
+        CallBatch(path);
+        return;
+    }
+
+    if (command == "simulate-until" || command == "simulate-steps") {
+        uint64_t bound{};
+        uint32_t period_ms{};
+        iss >> bound >> period_ms;
+
+        if (command == "simulate-until") {
+            CallSimulateUntil(bound, period_ms);
+        } else {
+            CallSimulateSteps(static_cast<uint32_t>(bound), period_ms);
+        }
+        return;
+    }
+
+    if (command == "log-filter") {
+        std::string severity, caller_type, caller_name_regex;
+        iss >> severity >> caller_type >> caller_name_regex;
+
+        log_filter_.Clear();
+        if (severity == "error") {
+            log_filter_.set_max_severity(
+                simulator_api::LogSeverity::ERROR_LOG_SEVERITY);
+        } else if (severity == "info") {
+            log_filter_.set_max_severity(
+                simulator_api::LogSeverity::INFO_LOG_SEVERITY);
+        }
+        if (!caller_type.empty() && caller_type != "*") {
+            log_filter_.add_caller_types(caller_type);
+        }
+        log_filter_.set_caller_name_regex(caller_name_regex);
+        return;
+    }
+
+    if (command == "stream") {
+        std::string path;
+        iss >> path;
+
+        CallStream(path);
+        return;
+    }
+
+    BatchItem item{};
+    if (!ParseCommand(input, &item)) {
+        return;
+    }
+
+    switch (item.item_case()) {
+        case BatchItem::kResourceAction: {
+            const auto& action = item.resource_action();
+            CallResourceAction(action.resource_action_type(),
+                               action.resource_name());
+            break;
+        }
+        case BatchItem::kVmAction: {
+            const auto& action = item.vm_action();
+            CallVMAction(action.vm_action_type(), action.vm_name());
+            break;
+        }
+        case BatchItem::kCreateVm: {
+            const auto& create_vm = item.create_vm();
+
+            std::unordered_map<std::string, std::string> params;
+            for (const auto& entry : create_vm.params()) {
+                params[entry.key()] = entry.value();
+            }
+
+            CallCreateVM(create_vm.vm_name(), create_vm.vm_workload_model(),
+                         params);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+bool
+sim::client::SimulatorRPCClient::ParseCommand(const std::string& input,
+                                              BatchItem* item)
+{
+    std::istringstream iss(input);
+
+    std::string command;
+    iss >> command;
 
     if (auto it = resource_action_mapping.find(command);
         it != resource_action_mapping.end()) {
         std::string resource_name;
         iss >> resource_name;
 
-        CallResourceAction(it->second, resource_name);
+        auto action = item->mutable_resource_action();
+        action->set_resource_name(resource_name);
+        action->set_resource_action_type(it->second);
     } else if (auto it2 = vm_action_mapping.find(command);
                it2 != vm_action_mapping.end()) {
         std::string vm_name;
         iss >> vm_name;
 
-        CallVMAction(it2->second, vm_name);
+        auto action = item->mutable_vm_action();
+        action->set_vm_name(vm_name);
+        action->set_vm_action_type(it2->second);
     } else if (command == "create-vm") {
         std::string vm_name;
         uint32_t required_ram{}, cpu_percent{}, io_bandwidth{};
@@ -40,26 +139,37 @@ sim::client::SimulatorRPCClient::ProcessInput(const std::string& input)
 
         if (!required_ram) {
             std::cerr << "Required RAM was not provided\n";
-            return;
+            return false;
         }
 
         if (!cpu_percent) {
             std::cerr << "Required CPU percent was not provided\n";
-            return;
+            return false;
         }
 
         if (!io_bandwidth) {
             std::cerr << "Required IO Bandwidth was not provided\n";
-            return;
+            return false;
         }
 
-        CallCreateVM(vm_name, "constant",
-                     {{"required_ram", std::to_string(required_ram)},
-                      {"required_cpu", std::to_string(cpu_percent)},
-                      {"required_bandwidth", std::to_string(io_bandwidth)}});
+        auto create_vm = item->mutable_create_vm();
+        create_vm->set_vm_name(vm_name);
+        create_vm->set_vm_workload_model("constant");
+
+        for (const auto& [key, value] :
+             {std::pair{"required_ram", required_ram},
+              std::pair{"required_cpu", cpu_percent},
+              std::pair{"required_bandwidth", io_bandwidth}}) {
+            auto kv_ptr = create_vm->add_params();
+            kv_ptr->set_key(key);
+            kv_ptr->set_value(std::to_string(value));
+        }
     } else {
         std::cerr << "Unknown command: " << command << "\n";
+        return false;
     }
+
+    return true;
 }
 
 void
@@ -134,23 +244,70 @@ void
 sim::client::SimulatorRPCClient::CallSimulateAll()
 {
     ClientContext cntx{};
-    Empty reply;
-    LogMessage log_message{};
-
-    std::unique_ptr<ClientReader<LogMessage>> reader(
-        stub_->SimulateAll(&cntx, reply));
-
-    while (reader->Read(&log_message)) {
-        if (auto it = severity_mapping.find(log_message.severity());
-            it != severity_mapping.end()) {
-            SimulatorLogger::GetLogger().Log(
-                TimeStamp{static_cast<int64_t>(log_message.time())}, it->second,
-                log_message.caller_type(), log_message.caller_name(),
-                log_message.text());
-        } else {
-            std::cerr << "Received invalid LogSeverity: "
-                      << log_message.severity() << "\n";
+    SimulateAllMessage request{};
+    LogBatchMessage batch{};
+
+    *request.mutable_filter() = log_filter_;
+
+    std::unique_ptr<ClientReader<LogBatchMessage>> reader(
+        stub_->SimulateAll(&cntx, request));
+
+    while (reader->Read(&batch)) {
+        for (const auto& log_message : batch.logs()) {
+            PrintLog(log_message);
         }
+        if (batch.dropped_count()) {
+            std::cerr << batch.dropped_count() << " log records dropped\n";
+        }
+    }
+
+    Status status = reader->Finish();
+    if (!status.ok()) {
+        std::cerr << "Remote procedure call failed: " << status.error_message()
+                  << "\n";
+    }
+}
+
+void
+sim::client::SimulatorRPCClient::CallSimulateUntil(uint64_t until_ts,
+                                                   uint32_t period_ms)
+{
+    ClientContext cntx{};
+
+    SimulateUntilMessage request{};
+    request.set_until_time(until_ts);
+    request.set_progress_period_ms(period_ms);
+
+    auto reader = stub_->SimulateUntil(&cntx, request);
+    PrintProgress(reader.get());
+}
+
+void
+sim::client::SimulatorRPCClient::CallSimulateSteps(uint32_t steps_count,
+                                                   uint32_t period_ms)
+{
+    ClientContext cntx{};
+
+    SimulateStepsMessage request{};
+    request.set_steps_count(steps_count);
+    request.set_progress_period_ms(period_ms);
+
+    auto reader = stub_->SimulateSteps(&cntx, request);
+    PrintProgress(reader.get());
+}
+
+void
+sim::client::SimulatorRPCClient::PrintProgress(
+    ClientReader<ProgressMessage>* reader)
+{
+    ProgressMessage progress{};
+
+    while (reader->Read(&progress)) {
+        std::cout << "Time " << progress.time() << ", handled "
+                  << progress.handled_events() << ", queued "
+                  << progress.queued_events() << ", "
+                  << static_cast<uint64_t>(progress.events_per_second())
+                  << " events/s\n";
     }
 
     Status status = reader->Finish();
@@ -159,3 +316,171 @@ sim::client::SimulatorRPCClient::CallSimulateAll()
                   << "\n";
     }
 }
+
+void
+sim::client::SimulatorRPCClient::CallBatch(const std::string& path)
+{
+    std::ifstream file{path};
+    if (!file) {
+        std::cerr << "Cannot open " << path << "\n";
+        return;
+    }
+
+    BatchMessage request{};
+    request.set_simulate(true);
+    std::unordered_set<std::string> created_vms;
+
+    auto send = [&] {
+        BatchReplyMessage reply;
+        ClientContext cntx{};
+
+        auto status = stub_->DoBatch(&cntx, request, &reply);
+        if (!status.ok()) {
+            std::cerr << "Remote procedure call failed: "
+                      << status.error_message() << "\n";
+            return false;
+        }
+
+        for (const auto& error : reply.errors()) {
+            std::cerr << "Command " << error.index() + 1
+                      << " of the batch failed: " << error.text() << "\n";
+        }
+        std::cout << "Applied " << reply.applied_count() << " of "
+                  << request.items_size() << " commands, time is "
+                  << reply.time() << "\n";
+
+        request.clear_items();
+        created_vms.clear();
+        return true;
+    };
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty()) {
+            continue;
+        }
+
+        BatchItem item{};
+        if (!ParseCommand(line, &item)) {
+            continue;
+        }
+
+        // the VM is known to the simulator only after the simulation
+        if (item.has_vm_action() &&
+            created_vms.count(item.vm_action().vm_name()) && !send()) {
+            return;
+        }
+        if (item.has_create_vm()) {
+            created_vms.insert(item.create_vm().vm_name());
+        }
+
+        *request.add_items() = std::move(item);
+    }
+
+    if (request.items_size()) {
+        send();
+    }
+}
+
+void
+sim::client::SimulatorRPCClient::CallStream(const std::string& path)
+{
+    std::ifstream file{path};
+    if (!file) {
+        std::cerr << "Cannot open " << path << "\n";
+        return;
+    }
+
+    ClientContext cntx{};
+    auto stream = stub_->StreamCommands(&cntx);
+
+    std::mutex mutex;
+    std::condition_variable acknowledged;
+    uint64_t sent_count = 0, done_count = 0;
+    bool reading = true;
+
+    // commands are written by another thread, so results are read while the
+    // writer waits for the stream
+    std::thread writer([&] {
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream iss(line);
+            uint64_t time{};
+            std::string command;
+            if (!(iss >> time) || !std::getline(iss, command)) {
+                continue;
+            }
+
+            StreamCommandMessage request{};
+            request.set_time(time);
+            if (!ParseCommand(command, request.mutable_command())) {
+                continue;
+            }
+
+            {
+                std::unique_lock lock{mutex};
+                acknowledged.wait(lock, [&] {
+                    return !reading ||
+                           sent_count - done_count < kMaxCommandsInFlight;
+                });
+                if (!reading) {
+                    break;
+                }
+                ++sent_count;
+            }
+
+            if (!stream->Write(request)) {
+                break;
+            }
+        }
+
+        stream->WritesDone();
+    });
+
+    StreamReplyMessage reply{};
+    while (stream->Read(&reply)) {
+        if (reply.has_log()) {
+            PrintLog(reply.log());
+            continue;
+        }
+
+        const auto& result = reply.result();
+        if (result.code() != grpc::StatusCode::OK) {
+            std::cerr << "Command " << result.index() + 1
+                      << " failed at time " << result.time() << ": "
+                      << result.text() << "\n";
+        }
+
+        std::lock_guard lock{mutex};
+        ++done_count;
+        acknowledged.notify_one();
+    }
+
+    {
+        std::lock_guard lock{mutex};
+        reading = false;
+        acknowledged.notify_one();
+    }
+    writer.join();
+
+    Status status = stream->Finish();
+    if (!status.ok()) {
+        std::cerr << "Remote procedure call failed: " << status.error_message()
+                  << "\n";
+    }
+}
+
+void
+sim::client::SimulatorRPCClient::PrintLog(const LogMessage& log_message)
+{
+    if (auto it = severity_mapping.find(log_message.severity());
+        it != severity_mapping.end()) {
+        SimulatorLogger::GetLogger().Log(
+            TimeStamp{static_cast<int64_t>(log_message.time())}, it->second,
+            log_message.caller_type(), log_message.caller_name(), "{}",
+            log_message.text());
+    } else {
+        std::cerr << "Received invalid LogSeverity: " << log_message.severity()
+                  << "\n";
+    }
+}
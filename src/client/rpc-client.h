@@ -14,13 +14,25 @@ using grpc::Channel;
 using grpc::ChannelInterface;
 using grpc::ClientContext;
 using grpc::ClientReader;
+using grpc::ClientReaderWriter;
 using grpc::Status;
 
+using simulator_api::BatchItem;
+using simulator_api::BatchMessage;
+using simulator_api::BatchReplyMessage;
 using simulator_api::CreateVMMessage;
+using simulator_api::LogBatchMessage;
+using simulator_api::LogFilter;
 using simulator_api::LogMessage;
+using simulator_api::ProgressMessage;
 using simulator_api::ResourceActionMessage;
 using simulator_api::ResourceActionType;
+using simulator_api::SimulateAllMessage;
+using simulator_api::SimulateStepsMessage;
+using simulator_api::SimulateUntilMessage;
 using simulator_api::Simulator;
+using simulator_api::StreamCommandMessage;
+using simulator_api::StreamReplyMessage;
 using simulator_api::VMActionMessage;
 using simulator_api::VMActionType;
 
@@ -72,6 +84,35 @@ class SimulatorRPCClient
 
     void CallSimulateAll();
 
+    /// Logs of the following simulations, all by default
+    LogFilter log_filter_{};
+
+    /// until_ts 0 simulates all events, progress is printed every period
+    void CallSimulateUntil(uint64_t until_ts, uint32_t period_ms);
+    void CallSimulateSteps(uint32_t steps_count, uint32_t period_ms);
+
+    void PrintProgress(ClientReader<ProgressMessage>* reader);
+
+    /**
+     * Sends commands of the file, one per line, in batches. A batch is sent
+     * with simulation before an action on a VM created by it
+     */
+    void CallBatch(const std::string& path);
+
+    /**
+     * Streams commands of the file, one per line prefixed with the time to
+     * apply at, and prints results and logs as they come. At most
+     * kMaxCommandsInFlight commands are sent ahead of their results
+     */
+    void CallStream(const std::string& path);
+
+    static constexpr uint64_t kMaxCommandsInFlight = 64;
+
+    void PrintLog(const LogMessage& log_message);
+
+    /// Returns false and prints the reason if the command is invalid
+    bool ParseCommand(const std::string& input, BatchItem* item);
+
     std::unique_ptr<Simulator::Stub> stub_;
 };
 
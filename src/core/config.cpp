@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <argparse.hpp>
+#include <thread>
 
 #include "cloud.h"
 #include "custom-code.h"
@@ -32,6 +33,57 @@ sim::core::SimulatorConfig::ParseArgs(int argc, char** argv)
         .nargs(1)
         .required();
 
+    parser.add_argument("--event-queue")
+        .help("Event queue implementation: \"calendar\" or \"map\"")
+        .nargs(1)
+        .default_value(std::string{"calendar"});
+
+    parser.add_argument("--cloud-scheduler")
+        .help("Cloud scheduler: \"greedy\", \"best-fit\" or \"worst-fit\"")
+        .nargs(1)
+        .default_value(std::string{"greedy"});
+
+    parser.add_argument("--execution")
+        .help("Execution of events: \"serial\", \"conservative\" or "
+              "\"optimistic\" parallel with a partition per data center")
+        .nargs(1)
+        .default_value(std::string{"serial"});
+
+    parser.add_argument("--execution-threads")
+        .help("Number of threads of the parallel execution, 0 - all cores")
+        .nargs(1)
+        .default_value(std::string{"0"});
+
+    parser.add_argument("--optimistic-window")
+        .help("Ticks between world updates in the optimistic execution")
+        .nargs(1)
+        .default_value(std::string{"16"});
+
+    parser.add_argument("--scheduler-threads")
+        .help("Number of threads updating server schedulers, 1 - serial mode")
+        .nargs(1)
+        .default_value(std::string{"1"});
+
+    parser.add_argument("--seed")
+        .help("Seed of random workloads of VM-s")
+        .nargs(1)
+        .default_value(std::string{"0"});
+
+    parser.add_argument("--log-format")
+        .help("Format of the log file: \"csv\" text log or binary \"trace\"")
+        .nargs(1)
+        .default_value(std::string{"csv"});
+
+    parser.add_argument("--log-level")
+        .help("Most verbose logged severity: \"error\", \"info\" or \"debug\"")
+        .nargs(1)
+        .default_value(std::string{"debug"});
+
+    parser.add_argument("--log-overflow")
+        .help("Behaviour on full log buffer: \"block\" or \"drop\"")
+        .nargs(1)
+        .default_value(std::string{"block"});
+
     try {
         parser.parse_args(argc, argv);
     } catch (const std::runtime_error& re) {
@@ -43,6 +95,60 @@ sim::core::SimulatorConfig::ParseArgs(int argc, char** argv)
     config_path_ = parser.get<std::string>("--config");
     logs_path_ = parser.get<std::string>("--logs-folder");
     port_ = std::stoi(parser.get<std::string>("--port"));
+    event_queue_type_ = parser.get<std::string>("--event-queue");
+    cloud_scheduler_ = parser.get<std::string>("--cloud-scheduler");
+
+    scheduler_threads_ =
+        std::stoi(parser.get<std::string>("--scheduler-threads"));
+    if (scheduler_threads_ == 0) {
+        throw std::runtime_error("Scheduler threads count should be positive");
+    }
+
+    execution_mode_ = parser.get<std::string>("--execution");
+    if (execution_mode_ != "serial" && execution_mode_ != "conservative" &&
+        execution_mode_ != "optimistic") {
+        throw std::runtime_error("Unknown execution mode: " + execution_mode_);
+    }
+
+    execution_threads_ =
+        std::stoi(parser.get<std::string>("--execution-threads"));
+    if (execution_threads_ == 0) {
+        execution_threads_ = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+
+    optimistic_window_ =
+        std::stoll(parser.get<std::string>("--optimistic-window"));
+    if (optimistic_window_ <= 0) {
+        throw std::runtime_error("Optimistic window should be positive");
+    }
+
+    seed_ = std::stoull(parser.get<std::string>("--seed"));
+
+    log_format_ = parser.get<std::string>("--log-format");
+    if (log_format_ != "csv" && log_format_ != "trace") {
+        throw std::runtime_error("Unknown log format: " + log_format_);
+    }
+
+    auto log_level = parser.get<std::string>("--log-level");
+    if (log_level == "error") {
+        max_log_severity_ = LogSeverity::kError;
+    } else if (log_level == "info") {
+        max_log_severity_ = LogSeverity::kInfo;
+    } else if (log_level == "debug") {
+        max_log_severity_ = LogSeverity::kDebug;
+    } else {
+        throw std::runtime_error("Unknown log level: " + log_level);
+    }
+
+    auto log_overflow = parser.get<std::string>("--log-overflow");
+    if (log_overflow == "block") {
+        log_overflow_policy_ = LogOverflowPolicy::kBlock;
+    } else if (log_overflow == "drop") {
+        log_overflow_policy_ = LogOverflowPolicy::kDrop;
+    } else {
+        throw std::runtime_error("Unknown log overflow policy: " +
+                                 log_overflow);
+    }
 }
 
 #define CHECK(condition, ...)                        \
@@ -58,9 +164,30 @@ sim::core::SimulatorConfig::ParseResources(
     sim::UUID cloud_handle, events::ActorRegister* actor_register,
     ServerSchedulerManager* server_scheduler_manager)
 {
-    ParseSpecs(config_path_ + "/specs.yaml");
-    ParseCloud(config_path_ + "/cloud.yaml", cloud_handle, actor_register,
-               server_scheduler_manager);
+    // without a config folder the cloud is described by the caller
+    if (!config_path_.empty()) {
+        ParseSpecs(config_path_ + "/specs.yaml");
+        ParseCloud(config_path_ + "/cloud.yaml");
+    }
+
+    MakeResources(cloud_handle, actor_register, server_scheduler_manager);
+}
+
+void
+sim::core::SimulatorConfig::AddServerSpec(const std::string& name,
+                                          infra::ServerSpec spec)
+{
+    auto it = server_specs_.find(name);
+    CHECK(it == server_specs_.end(), "Name {} is already in use", name);
+
+    server_specs_.emplace(name, spec);
+    servers_count_[name] = 0;
+}
+
+void
+sim::core::SimulatorConfig::AddDataCenter(DataCenterConfig data_center)
+{
+    data_centers_.push_back(std::move(data_center));
 }
 
 void
@@ -93,27 +220,84 @@ sim::core::SimulatorConfig::ParseSpecs(const std::string& specs_file_name)
         CHECK(spec_cores_count.IsScalar(),
               "Field \"cores-count\" is not a single value");
 
-        auto name = spec_name.as<std::string>();
-
         infra::ServerSpec server_spec{};
         server_spec.ram = RAMBytes{spec_ram.as<uint32_t>()};
         server_spec.io_bandwidth =
             IOBandwidthMBpS{spec_io_bandwidth.as<uint32_t>()};
         server_spec.cores_count = spec_cores_count.as<uint32_t>();
 
-        auto it = server_specs_.find(name);
-        CHECK(it == server_specs_.end(), "Name {} is already in use", name);
+        if (auto spec_power = spec["power"]) {
+            server_spec.power_model = ParsePowerModel(spec_power);
+        }
+
+        AddServerSpec(spec_name.as<std::string>(), server_spec);
+    }
+}
+
+std::shared_ptr<const sim::infra::IPowerModel>
+sim::core::SimulatorConfig::ParsePowerModel(const YAML::Node& power_config)
+{
+    CHECK(power_config.IsMap(), "Field \"power\" is not a map");
+
+    auto model_config = power_config["model"];
+    CHECK(model_config, "Field \"model\" not found");
+    CHECK(model_config.IsScalar(), "Field \"model\" is not a single value");
+
+    auto model = model_config.as<std::string>();
+
+    if (model == "linear") {
+        auto idle_config = power_config["idle"];
+        auto max_config = power_config["max"];
+
+        CHECK(idle_config, "Field \"idle\" not found");
+        CHECK(idle_config.IsScalar(), "Field \"idle\" is not a single value");
+
+        CHECK(max_config, "Field \"max\" not found");
+        CHECK(max_config.IsScalar(), "Field \"max\" is not a single value");
+
+        return std::make_shared<infra::LinearPowerModel>(
+            idle_config.as<double>(), max_config.as<double>());
+    }
+
+    if (model == "table") {
+        auto values_config = power_config["values"];
+
+        CHECK(values_config, "Field \"values\" not found");
+        CHECK(values_config.IsSequence() && values_config.size() >= 2,
+              "\"values\" is not a sequence of at least 2 values");
+
+        return std::make_shared<infra::TablePowerModel>(
+            values_config.as<std::vector<double>>());
+    }
+
+    if (model == "piecewise") {
+        auto points_config = power_config["points"];
+
+        CHECK(points_config, "Field \"points\" not found");
+        CHECK(points_config.IsSequence() && points_config.size() > 0,
+              "\"points\" is not a non-empty sequence");
+
+        std::vector<std::pair<double, double>> points;
+        for (const auto& point_config : points_config) {
+            CHECK(point_config.IsSequence() && point_config.size() == 2,
+                  "Power curve point is not [utilization, power]");
+
+            points.emplace_back(point_config[0].as<double>(),
+                                point_config[1].as<double>());
+        }
+
+        CHECK(std::is_sorted(points.begin(), points.end()),
+              "Power curve points are not in increasing utilization");
 
-        server_specs_.emplace(name, server_spec);
-        servers_count_[name] = 0;
+        return std::make_shared<infra::PiecewisePowerModel>(std::move(points));
     }
+
+    CHECK(false, "Unknown power model {}", model);
+    return nullptr;
 }
 
 void
-sim::core::SimulatorConfig::ParseCloud(
-    const std::string& cloud_file_name, sim::UUID cloud_handle,
-    events::ActorRegister* actor_register,
-    ServerSchedulerManager* server_scheduler_manager)
+sim::core::SimulatorConfig::ParseCloud(const std::string& cloud_file_name)
 {
     auto cloud_config = YAML::LoadFile(cloud_file_name);
 
@@ -122,8 +306,6 @@ sim::core::SimulatorConfig::ParseCloud(
     CHECK(dc_configs, "Field \"data-centers\" not found");
     CHECK(dc_configs.IsSequence(), "\"data-centers\" is not a sequence");
 
-    auto cloud = actor_register->GetActor<infra::Cloud>(cloud_handle);
-
     for (const auto& dc_config : dc_configs) {
         auto name_config = dc_config["name"];
         auto servers_config = dc_config["servers"];
@@ -134,10 +316,8 @@ sim::core::SimulatorConfig::ParseCloud(
         CHECK(servers_config, "Field \"servers\" not found");
         CHECK(servers_config.IsSequence(), "\"servers\" is not a sequence");
 
-        auto data_center = actor_register->Make<infra::DataCenter>(
-            name_config.as<std::string>());
-
-        cloud->AddDataCenter(data_center->GetUUID());
+        DataCenterConfig data_center{.name = name_config.as<std::string>(),
+                                     .servers = {}};
 
         for (const auto& server_config : servers_config) {
             auto server_name_config = server_config["name"];
@@ -156,17 +336,43 @@ sim::core::SimulatorConfig::ParseCloud(
             CHECK(server_scheduler_config.IsScalar(),
                   "Field \"scheduler\" is not a single value");
 
-            auto server_name = server_name_config.as<std::string>();
-            auto servers_count = server_count_config.as<uint32_t>();
-            auto server_scheduler = server_scheduler_config.as<std::string>();
+            data_center.servers.push_back(
+                {server_name_config.as<std::string>(),
+                 server_count_config.as<uint32_t>(),
+                 server_scheduler_config.as<std::string>()});
+        }
+
+        AddDataCenter(std::move(data_center));
+    }
+}
+
+void
+sim::core::SimulatorConfig::MakeResources(
+    sim::UUID cloud_handle, events::ActorRegister* actor_register,
+    ServerSchedulerManager* server_scheduler_manager)
+{
+    auto cloud = actor_register->GetActor<infra::Cloud>(cloud_handle);
+
+    for (const auto& dc_config : data_centers_) {
+        auto data_center =
+            actor_register->Make<infra::DataCenter>(dc_config.name);
+
+        cloud->AddDataCenter(data_center->GetUUID());
+
+        for (const auto& servers_config : dc_config.servers) {
+            const auto& server_name = servers_config.spec_name;
+            const auto& server_scheduler = servers_config.scheduler;
             auto it = server_specs_.find(server_name);
 
             CHECK(it != server_specs_.end(),
                   "Server name {} is not found in specs", server_name);
 
+            CHECK(server_scheduler == "greedy", "Unknown server scheduler {}",
+                  server_scheduler);
+
             auto& server_spec = it->second;
 
-            for (uint32_t i = 1; i <= servers_count; ++i) {
+            for (uint32_t i = 1; i <= servers_config.count; ++i) {
                 auto& serial = servers_count_[server_name];
 
                 auto server = actor_register->Make<infra::Server>(
@@ -174,9 +380,6 @@ sim::core::SimulatorConfig::ParseCloud(
 
                 server->SetSpec(server_spec);
 
-                CHECK(server_scheduler == "greedy",
-                      "Unknown server scheduler {}", server_scheduler);
-
                 server_scheduler_manager->Make<custom::GreedyServerScheduler>(
                     server->GetUUID());
 
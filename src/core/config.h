@@ -1,14 +1,41 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "actor-register.h"
+#include "logger.h"
 #include "resource-scheduler.h"
 #include "server.h"
 
+namespace YAML {
+class Node;
+}
+
 namespace sim::core {
 
+/// Servers of one spec in a data center
+struct ServersConfig
+{
+    std::string spec_name;
+    uint32_t count{};
+    std::string scheduler;
+};
+
+struct DataCenterConfig
+{
+    std::string name;
+    std::vector<ServersConfig> servers;
+};
+
+/**
+ * Options of the simulator. They are parsed from the command line and the
+ * config folder, or set by the code which runs the simulator without RPC
+ * (e.g., benchmarks), then resources are described by AddServerSpec and
+ * AddDataCenter
+ */
 class SimulatorConfig
 {
  public:
@@ -19,8 +46,54 @@ class SimulatorConfig
                         events::ActorRegister* actor_register,
                         ServerSchedulerManager* server_scheduler_manager);
 
+    void AddServerSpec(const std::string& name, infra::ServerSpec spec);
+    void AddDataCenter(DataCenterConfig data_center);
+
+    /// Folder with specs.yaml and cloud.yaml
+    void SetConfigPath(std::string config_path)
+    {
+        config_path_ = std::move(config_path);
+    }
+    void SetLogsPath(std::string logs_path)
+    {
+        logs_path_ = std::move(logs_path);
+    }
+    void SetEventQueueType(std::string event_queue_type)
+    {
+        event_queue_type_ = std::move(event_queue_type);
+    }
+    void SetCloudScheduler(std::string cloud_scheduler)
+    {
+        cloud_scheduler_ = std::move(cloud_scheduler);
+    }
+    void SetSchedulerThreads(uint32_t threads) { scheduler_threads_ = threads; }
+    void SetExecutionMode(std::string mode)
+    {
+        execution_mode_ = std::move(mode);
+    }
+    void SetExecutionThreads(uint32_t threads) { execution_threads_ = threads; }
+    void SetOptimisticWindow(TimeInterval window)
+    {
+        optimistic_window_ = window;
+    }
+    void SetSeed(uint64_t seed) { seed_ = seed; }
+    void SetMaxLogSeverity(LogSeverity severity)
+    {
+        max_log_severity_ = severity;
+    }
+
     auto GetLogsPath() const { return logs_path_; }
     auto GetPort() const { return port_; }
+    auto GetEventQueueType() const { return event_queue_type_; }
+    auto GetCloudScheduler() const { return cloud_scheduler_; }
+    auto GetSchedulerThreads() const { return scheduler_threads_; }
+    auto GetExecutionMode() const { return execution_mode_; }
+    auto GetExecutionThreads() const { return execution_threads_; }
+    auto GetOptimisticWindow() const { return optimistic_window_; }
+    auto GetSeed() const { return seed_; }
+    auto GetLogFormat() const { return log_format_; }
+    auto GetLogOverflowPolicy() const { return log_overflow_policy_; }
+    auto GetMaxLogSeverity() const { return max_log_severity_; }
 
     std::string_view WhoAmI() const { return whoami_; }
 
@@ -28,15 +101,25 @@ class SimulatorConfig
     std::string whoami_{};
 
     void ParseSpecs(const std::string& specs_file_name);
-    void ParseCloud(const std::string& cloud_file_name, UUID cloud_handle,
-                    events::ActorRegister* actor_register,
-                    ServerSchedulerManager* server_scheduler_manager);
+    std::shared_ptr<const infra::IPowerModel> ParsePowerModel(
+        const YAML::Node& power_config);
+    void ParseCloud(const std::string& cloud_file_name);
+    void MakeResources(UUID cloud_handle, events::ActorRegister* actor_register,
+                       ServerSchedulerManager* server_scheduler_manager);
 
-    std::string config_path_{}, logs_path_{};
-    uint32_t port_{};
+    std::string config_path_{}, logs_path_{}, event_queue_type_{"calendar"},
+        cloud_scheduler_{"greedy"}, execution_mode_{"serial"},
+        log_format_{"csv"};
+    uint32_t port_{}, scheduler_threads_{1}, execution_threads_{1};
+    TimeInterval optimistic_window_{16};
+    uint64_t seed_{};
+    LogOverflowPolicy log_overflow_policy_{};
+    LogSeverity max_log_severity_{LogSeverity::kDebug};
 
     std::unordered_map<std::string, infra::ServerSpec> server_specs_{};
     std::unordered_map<std::string, uint32_t> servers_count_{};
+
+    std::vector<DataCenterConfig> data_centers_{};
 };
 
 }   // namespace sim::core
@@ -0,0 +1,140 @@
+#include "log-batcher.h"
+
+#include <utility>
+
+sim::core::LogBatcher::LogBatcher(const SimulateAllMessage& request)
+    : caller_types_(request.filter().caller_types().begin(),
+                    request.filter().caller_types().end()),
+      caller_name_prefix_(request.filter().caller_name_prefix()),
+      max_batch_size_(request.max_batch_size()
+                          ? static_cast<int>(request.max_batch_size())
+                          : 256),
+      max_batch_delay_(std::chrono::milliseconds{
+          request.max_batch_delay_ms() ? request.max_batch_delay_ms() : 100}),
+      max_pending_batches_(
+          request.max_pending_batches() ? request.max_pending_batches() : 16),
+      slow_client_policy_(request.slow_client_policy()),
+      sample_period_(request.sample_period() ? request.sample_period() : 10)
+{
+    if (!request.filter().caller_name_regex().empty()) {
+        caller_name_regex_.emplace(request.filter().caller_name_regex());
+    }
+}
+
+bool
+sim::core::LogBatcher::Matches(std::string_view caller_type,
+                               std::string_view caller_name) const
+{
+    if (!caller_types_.empty() &&
+        !caller_types_.count(std::string{caller_type})) {
+        return false;
+    }
+
+    if (!caller_name.starts_with(caller_name_prefix_)) {
+        return false;
+    }
+
+    return !caller_name_regex_ ||
+           std::regex_search(caller_name.begin(), caller_name.end(),
+                             *caller_name_regex_);
+}
+
+void
+sim::core::LogBatcher::Add(LogMessage&& message)
+{
+    std::unique_lock lock{mutex_};
+
+    if (CurrentFull() && pending_.size() < max_pending_batches_) {
+        Seal();
+    }
+
+    if (pending_.size() >= max_pending_batches_) {
+        switch (slow_client_policy_) {
+            case SlowClientPolicy::BLOCK_SLOW_CLIENT_POLICY:
+                batch_taken_.wait(lock, [this] {
+                    return pending_.size() < max_pending_batches_;
+                });
+                if (CurrentFull()) {
+                    Seal();
+                }
+                break;
+
+            case SlowClientPolicy::SAMPLE_SLOW_CLIENT_POLICY:
+                if (behind_count_++ % sample_period_ != 0 || CurrentFull()) {
+                    ++dropped_count_;
+                    return;
+                }
+                break;
+
+            default:
+                if (CurrentFull()) {
+                    ++dropped_count_;
+                    return;
+                }
+                break;
+        }
+    } else {
+        behind_count_ = 0;
+    }
+
+    bool first = current_.logs().empty();
+    if (first) {
+        current_start_ = Clock::now();
+    }
+    *current_.add_logs() = std::move(message);
+
+    // the writer waits without a deadline while the batch is empty
+    if (first) {
+        batch_ready_.notify_one();
+    }
+
+    if (CurrentFull() && pending_.size() < max_pending_batches_) {
+        Seal();
+    }
+}
+
+void
+sim::core::LogBatcher::Close()
+{
+    std::lock_guard lock{mutex_};
+
+    closed_ = true;
+    batch_ready_.notify_one();
+}
+
+bool
+sim::core::LogBatcher::Next(LogBatchMessage* batch)
+{
+    std::unique_lock lock{mutex_};
+
+    while (pending_.empty()) {
+        if (closed_) {
+            if (current_.logs().empty() && !dropped_count_) {
+                return false;
+            }
+            Seal();
+        } else if (current_.logs().empty()) {
+            batch_ready_.wait(lock);
+        } else if (Clock::now() >= current_start_ + max_batch_delay_) {
+            Seal();
+        } else {
+            batch_ready_.wait_until(lock, current_start_ + max_batch_delay_);
+        }
+    }
+
+    *batch = std::move(pending_.front());
+    pending_.pop_front();
+    batch_taken_.notify_one();
+
+    return true;
+}
+
+void
+sim::core::LogBatcher::Seal()
+{
+    current_.set_dropped_count(std::exchange(dropped_count_, 0));
+    pending_.push_back(std::move(current_));
+    current_.Clear();
+
+    batch_ready_.notify_one();
+}
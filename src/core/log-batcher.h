@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+// generated code
+#include "api.pb.h"
+
+namespace sim::core {
+
+using simulator_api::LogBatchMessage;
+using simulator_api::LogMessage;
+using simulator_api::SimulateAllMessage;
+using simulator_api::SlowClientPolicy;
+
+/**
+ * Filters log records of a SimulateAll call and groups them into batches.
+ *
+ * Records are added by the logger thread, batches are taken by the thread
+ * writing the stream. A batch is ready when it is full or its first record
+ * waits longer than the delay. When the client falls behind (the pending
+ * batches are full), the logger waits, or the current batch is filled with
+ * the first or sampled records and the others are dropped. Dropped records
+ * are counted in the next batch. So at most max_pending_batches + 1 batches
+ * are kept.
+ */
+class LogBatcher
+{
+ public:
+    /// Throws std::regex_error if the caller name regex is invalid
+    explicit LogBatcher(const SimulateAllMessage& request);
+
+    LogBatcher(const LogBatcher& other) = delete;
+
+    bool Matches(std::string_view caller_type,
+                 std::string_view caller_name) const;
+
+    void Add(LogMessage&& message);
+
+    /// Nothing is added after it, the remaining records make the last batch
+    void Close();
+
+    /// Waits for the next batch, returns false when all batches are taken
+    bool Next(LogBatchMessage* batch);
+
+ private:
+    using Clock = std::chrono::steady_clock;
+
+    std::unordered_set<std::string> caller_types_;
+    std::string caller_name_prefix_;
+    std::optional<std::regex> caller_name_regex_;
+
+    const int max_batch_size_;
+    const Clock::duration max_batch_delay_;
+    const size_t max_pending_batches_;
+    const SlowClientPolicy slow_client_policy_;
+    const uint64_t sample_period_;
+
+    std::mutex mutex_;
+    std::condition_variable batch_ready_, batch_taken_;
+
+    std::deque<LogBatchMessage> pending_;
+    LogBatchMessage current_;
+    Clock::time_point current_start_;
+
+    /// Since the last sealed batch
+    uint64_t dropped_count_{};
+
+    /// Records offered while the client is behind, for sampling
+    uint64_t behind_count_{};
+
+    bool closed_{};
+
+    bool CurrentFull() const
+    {
+        return current_.logs_size() >= max_batch_size_;
+    }
+
+    /// Moves the current batch to the pending ones
+    void Seal();
+};
+
+}   // namespace sim::core
@@ -0,0 +1,49 @@
+#include "progress-queue.h"
+
+#include <utility>
+
+bool
+sim::core::ProgressQueue::Push(ProgressMessage&& message)
+{
+    if (IsCancelled()) {
+        return false;
+    }
+
+    {
+        std::lock_guard lock{mutex_};
+
+        if (messages_.size() >= capacity_) {
+            messages_.pop_front();
+        }
+        messages_.push_back(std::move(message));
+    }
+    pushed_.notify_one();
+
+    return true;
+}
+
+void
+sim::core::ProgressQueue::Close()
+{
+    {
+        std::lock_guard lock{mutex_};
+        closed_ = true;
+    }
+    pushed_.notify_one();
+}
+
+bool
+sim::core::ProgressQueue::Next(ProgressMessage* message)
+{
+    std::unique_lock lock{mutex_};
+
+    pushed_.wait(lock, [this] { return closed_ || !messages_.empty(); });
+    if (messages_.empty()) {
+        return false;
+    }
+
+    *message = std::move(messages_.front());
+    messages_.pop_front();
+
+    return true;
+}
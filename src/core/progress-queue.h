@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+// generated code
+#include "api.pb.h"
+
+namespace sim::core {
+
+using simulator_api::ProgressMessage;
+
+/**
+ * Progress records of a simulation call on their way from the simulation
+ * thread to the thread writing the stream.
+ *
+ * The simulation thread never waits for the client: when the queue is full,
+ * the oldest record is dropped, as the newer one tells more. The writer
+ * cancels the queue when the stream is broken, and the simulation stops at
+ * its next record
+ */
+class ProgressQueue
+{
+ public:
+    explicit ProgressQueue(size_t capacity = 16) : capacity_(capacity) {}
+
+    ProgressQueue(const ProgressQueue& other) = delete;
+
+    /// Returns false if the queue is cancelled
+    bool Push(ProgressMessage&& message);
+
+    /// Nothing is pushed after it
+    void Close();
+
+    /// The records pushed later are not needed
+    void Cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+
+    bool IsCancelled() const
+    {
+        return cancelled_.load(std::memory_order_relaxed);
+    }
+
+    /// Waits for the next record, returns false when all records are taken
+    bool Next(ProgressMessage* message);
+
+ private:
+    const size_t capacity_;
+
+    std::mutex mutex_;
+    std::condition_variable pushed_;
+
+    std::deque<ProgressMessage> messages_;
+    bool closed_{};
+
+    std::atomic<bool> cancelled_{};
+};
+
+}   // namespace sim::core
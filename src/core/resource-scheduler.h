@@ -1,10 +1,17 @@
 #pragma once
 
+#include <functional>
+#include <queue>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include "logger.h"
 #include "observer.h"
 #include "resource.h"
 #include "server.h"
+#include "thread-pool.h"
+#include "trace-writer.h"
 #include "types.h"
 #include "vm.h"
 
@@ -39,6 +46,15 @@ class IResourceScheduler : public events::Observer
 
 using IServerScheduler = IResourceScheduler<infra::Server, infra::VM>;
 
+/**
+ * Server scheduler is updated only if its server has changed or if it has
+ * asked to wake up at this time.
+ *
+ * With several threads, schedulers are updated in parallel. Events and log
+ * records of each scheduler are collected aside and passed on in the order
+ * of the serial mode, so the results do not depend on the threads count.
+ * Server schedulers should read only their own server and its VM-s.
+ */
 class ServerSchedulerManager : public events::Observer
 {
  public:
@@ -51,6 +67,50 @@ class ServerSchedulerManager : public events::Observer
         }
     }
 
+    void MarkChanged(UUID actor)
+    {
+        if (auto it = server_schedulers_.find(actor);
+            it != server_schedulers_.end()) {
+            MarkDirty(it->second);
+        }
+    }
+
+    /// 1 means serial mode
+    void SetThreadsCount(size_t threads_count)
+    {
+        pool_ = threads_count > 1
+                    ? std::make_unique<WorkStealingPool>(threads_count)
+                    : nullptr;
+    }
+
+    bool HasChanges() const
+    {
+        return !dirty_list_.empty() ||
+               (!wake_ups_.empty() && wake_ups_.top().first <= now());
+    }
+
+    /// Updates changed and woken up schedulers
+    void ScheduleChanged()
+    {
+        while (!wake_ups_.empty() && wake_ups_.top().first <= now()) {
+            MarkDirty(wake_ups_.top().second);
+            wake_ups_.pop();
+        }
+
+        for (auto index : dirty_list_) {
+            dirty_[index] = false;
+        }
+
+        if (pool_ && dirty_list_.size() >= kMinParallelSchedulers) {
+            ScheduleParallel();
+        } else {
+            for (auto index : dirty_list_) {
+                schedulers_[index]->UpdateSchedule();
+            }
+        }
+        dirty_list_.clear();
+    }
+
     template <class ServerScheduler>
     void Make(UUID server_handle)
     {
@@ -58,18 +118,140 @@ class ServerSchedulerManager : public events::Observer
 
         auto scheduler = std::make_unique<ServerScheduler>(server_handle);
 
-        scheduler->SetScheduleFunction(schedule_event);
+        scheduler->SetScheduleFunction(
+            [this](events::Event* event, bool immediate) {
+                if (thread_output_) {
+                    thread_output_->actions.push_back({event, immediate});
+                } else {
+                    schedule_event(event, immediate);
+                }
+            });
         scheduler->SetActorRegister(actor_register_);
         scheduler->SetNowFunction(now);
 
+        auto index = schedulers_.size();
+        scheduler->SetWakeUpFunction([this, index](TimeStamp ts) {
+            if (thread_output_) {
+                thread_output_->actions.push_back({.wake_up_time = ts});
+            } else {
+                WakeUpAt(index, ts);
+            }
+        });
+
         WORLD_LOG_INFO("Server {} is scheduled using \"{}\" strategy",
                        server_handle, scheduler->GetName());
 
         schedulers_.push_back(std::move(scheduler));
+        server_schedulers_[server_handle] = index;
+        dirty_.push_back(false);
+
+        MarkDirty(index);
     }
 
  private:
+    /// Fewer schedulers are updated serially
+    static constexpr size_t kMinParallelSchedulers = 16;
+
+    /// Scheduled event or wake-up request if event is null
+    struct Action
+    {
+        events::Event* event{};
+        bool immediate{};
+        TimeStamp wake_up_time{};
+    };
+
+    /// Side effects of one scheduler update in parallel mode
+    struct Output
+    {
+        std::vector<Action> actions;
+        LogCapture log;
+        trace::TraceCapture trace;
+    };
+
+    void ScheduleParallel()
+    {
+        if (outputs_.size() < dirty_list_.size()) {
+            outputs_.resize(dirty_list_.size());
+        }
+
+        auto& logger = SimulatorLogger::GetLogger();
+        auto& writer = trace::TraceWriter::GetWriter();
+
+        pool_->ParallelFor(dirty_list_.size(), [&, this](size_t i, size_t) {
+            auto& output = outputs_[i];
+
+            // threads of the pool serve only this simulation
+            SimulatorLogger::SetThreadLogger(&logger);
+            trace::TraceWriter::SetThreadWriter(&writer);
+
+            thread_output_ = &output;
+            SimulatorLogger::SetThreadCapture(&output.log);
+            trace::TraceWriter::SetThreadCapture(&output.trace);
+
+            try {
+                schedulers_[dirty_list_[i]]->UpdateSchedule();
+            } catch (...) {
+                ResetThreadOutput();
+                throw;
+            }
+            ResetThreadOutput();
+        });
+
+        for (size_t i = 0; i < dirty_list_.size(); ++i) {
+            auto& output = outputs_[i];
+
+            logger.Replay(output.log);
+            writer.Replay(output.trace);
+
+            for (const auto& action : output.actions) {
+                if (action.event) {
+                    schedule_event(action.event, action.immediate);
+                } else {
+                    WakeUpAt(dirty_list_[i], action.wake_up_time);
+                }
+            }
+            output.actions.clear();
+        }
+    }
+
+    static void ResetThreadOutput()
+    {
+        thread_output_ = nullptr;
+        SimulatorLogger::SetThreadCapture(nullptr);
+        trace::TraceWriter::SetThreadCapture(nullptr);
+    }
+
+    void WakeUpAt(size_t index, TimeStamp ts)
+    {
+        wake_up(ts);
+        wake_ups_.emplace(ts, index);
+    }
+
+    void MarkDirty(size_t index)
+    {
+        if (!dirty_[index]) {
+            dirty_[index] = true;
+            dirty_list_.push_back(index);
+        }
+    }
+
     std::vector<std::unique_ptr<IServerScheduler>> schedulers_;
+    std::unordered_map<UUID, size_t> server_schedulers_;
+
+    std::vector<bool> dirty_;
+    std::vector<size_t> dirty_list_;
+
+    std::unique_ptr<WorkStealingPool> pool_;
+    std::vector<Output> outputs_;
+
+    /// Output of the scheduler updated by this thread in parallel mode
+    static inline thread_local Output* thread_output_{};
+
+    /// (time, scheduler index), the earliest first
+    std::priority_queue<std::pair<TimeStamp, size_t>,
+                        std::vector<std::pair<TimeStamp, size_t>>,
+                        std::greater<>>
+        wake_ups_;
 };
 
 }   // namespace sim::core
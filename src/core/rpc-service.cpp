@@ -2,21 +2,172 @@
 
 #include <fmt/core.h>
 
+#include <future>
+#include <memory>
+#include <optional>
+
 #include "actor.h"
 #include "custom-code.h"
 #include "resource.h"
 #include "scheduler.h"
 #include "vm-storage.h"
 
+/**
+ * A unary call from the request to the reply. The next call of the method is
+ * accepted as soon as this one comes, the handler runs in the simulation
+ * thread, which also sends the reply
+ */
+template <typename Request, typename Reply>
+class sim::core::SimulatorRPCService::AsyncUnaryCall : public IAsyncCall
+{
+ public:
+    using RequestFunction =
+        std::function<void(ServerContext*, Request*,
+                           ServerAsyncResponseWriter<Reply>*, void*)>;
+    using Handler = std::function<Status(const Request&, Reply*)>;
+
+    AsyncUnaryCall(World* world, RequestFunction request_call, Handler handler)
+        : world_(world),
+          request_call_(std::move(request_call)),
+          handler_(std::move(handler))
+    {
+        request_call_(&context_, &request_, &responder_, this);
+    }
+
+    void Proceed(bool ok) override
+    {
+        // the reply is sent or the server is shutting down
+        if (replied_ || !ok) {
+            delete this;
+            return;
+        }
+
+        new AsyncUnaryCall(world_, request_call_, handler_);
+
+        world_->Post([this] {
+            Reply reply{};
+            auto status = handler_(request_, &reply);
+
+            replied_ = true;
+            responder_.Finish(reply, status, this);
+        });
+    }
+
+ private:
+    World* world_;
+    RequestFunction request_call_;
+    Handler handler_;
+
+    ServerContext context_;
+    Request request_;
+    ServerAsyncResponseWriter<Reply> responder_{&context_};
+    bool replied_{};
+};
+
+void
+sim::core::SimulatorRPCService::Start(ServerCompletionQueue* queue)
+{
+    Accept<ResourceActionMessage, Empty>(
+        queue, &SimulatorRPCService::RequestDoResourceAction,
+        [this](const ResourceActionMessage& request, Empty*) {
+            return ApplyResourceAction(request);
+        });
+    Accept<CreateVMMessage, Empty>(
+        queue, &SimulatorRPCService::RequestCreateVM,
+        [this](const CreateVMMessage& request, Empty*) {
+            return ApplyCreateVM(request);
+        });
+    Accept<VMActionMessage, Empty>(
+        queue, &SimulatorRPCService::RequestDoVMAction,
+        [this](const VMActionMessage& request, Empty*) {
+            return ApplyVMAction(request);
+        });
+    Accept<BatchMessage, BatchReplyMessage>(
+        queue, &SimulatorRPCService::RequestDoBatch,
+        [this](const BatchMessage& request, BatchReplyMessage* response) {
+            return ApplyBatch(request, response);
+        });
+}
+
+void
+sim::core::SimulatorRPCService::Poll(ServerCompletionQueue* queue)
+{
+    void* tag{};
+    bool ok{};
+
+    while (queue->Next(&tag, &ok)) {
+        static_cast<IAsyncCall*>(tag)->Proceed(ok);
+    }
+}
+
+template <typename Request, typename Reply, typename RequestMethod>
+void
+sim::core::SimulatorRPCService::Accept(
+    ServerCompletionQueue* queue, RequestMethod request_method,
+    std::function<Status(const Request&, Reply*)> handler)
+{
+    new AsyncUnaryCall<Request, Reply>(
+        world_,
+        [this, queue, request_method](
+            ServerContext* context, Request* request,
+            ServerAsyncResponseWriter<Reply>* responder, void* tag) {
+            (this->*request_method)(context, request, responder, queue, queue,
+                                    tag);
+        },
+        std::move(handler));
+}
+
+std::future<grpc::Status>
+sim::core::SimulatorRPCService::Execute(std::function<Status()> command)
+{
+    auto done = std::make_shared<std::promise<Status>>();
+    auto status = done->get_future();
+
+    world_->Post([command = std::move(command), done] {
+        done->set_value(command());
+    });
+
+    return status;
+}
+
+grpc::Status
+sim::core::SimulatorRPCService::ApplyBatch(const BatchMessage& request,
+                                           BatchReplyMessage* response)
+{
+    std::unordered_set<std::string> created_vms;
+    uint32_t applied_count = 0;
+
+    for (int i = 0; i < request.items_size(); ++i) {
+        auto status = ApplyBatchItem(request.items(i), created_vms);
+
+        if (status.ok()) {
+            ++applied_count;
+        } else {
+            auto error = response->add_errors();
+            error->set_index(i);
+            error->set_code(status.error_code());
+            error->set_text(status.error_message());
+        }
+    }
+
+    if (request.simulate()) {
+        world_->SimulateAll();
+    }
+
+    response->set_applied_count(applied_count);
+    response->set_time(world_->Now());
+
+    return Status::OK;
+}
+
 grpc::Status
-sim::core::SimulatorRPCService::DoResourceAction(
-    ServerContext* context, const ResourceActionMessage* request,
-    Empty* response)
+sim::core::SimulatorRPCService::ApplyResourceAction(
+    const ResourceActionMessage& request)
 {
     try {
         infra::ResourceEventType event_type;
 
-        switch (request->resource_action_type()) {
+        switch (request.resource_action_type()) {
             case ResourceActionType::BOOT_RESOURCE_ACTION:
                 event_type = ResourceEventType::kBoot;
                 break;
@@ -29,10 +180,10 @@ sim::core::SimulatorRPCService::DoResourceAction(
             default:
                 return Status{StatusCode::INVALID_ARGUMENT,
                               fmt::format("Invalid resource_action_type: {}",
-                                          request->resource_action_type())};
+                                          request.resource_action_type())};
         }
 
-        world_->DoResourceAction(request->resource_name(), event_type);
+        world_->DoResourceAction(request.resource_name(), event_type);
 
     } catch (const std::exception& e) {
         return Status{StatusCode::INVALID_ARGUMENT, e.what()};
@@ -42,17 +193,15 @@ sim::core::SimulatorRPCService::DoResourceAction(
 }
 
 grpc::Status
-sim::core::SimulatorRPCService::CreateVM(ServerContext* context,
-                                         const CreateVMMessage* request,
-                                         Empty* response)
+sim::core::SimulatorRPCService::ApplyCreateVM(const CreateVMMessage& request)
 {
     std::unordered_map<std::string, std::string> params;
-    for (const auto& entry : request->params()) {
+    for (const auto& entry : request.params()) {
         params[entry.key()] = entry.value();
     }
 
     try {
-        world_->CreateVM(request->vm_name(), request->vm_workload_model(),
+        world_->CreateVM(request.vm_name(), request.vm_workload_model(),
                          params);
     } catch (const std::exception& e) {
         return Status{StatusCode::INVALID_ARGUMENT, e.what()};
@@ -62,16 +211,12 @@ sim::core::SimulatorRPCService::CreateVM(ServerContext* context,
 }
 
 grpc::Status
-sim::core::SimulatorRPCService::DoVMAction(ServerContext* context,
-                                           const VMActionMessage* request,
-                                           Empty* response)
+sim::core::SimulatorRPCService::ApplyVMAction(const VMActionMessage& request)
 {
     try {
-        infra::VMEventType event_type;
-
-        switch (request->vm_action_type()) {
+        switch (request.vm_action_type()) {
             case VMActionType::PROVISION_VM_ACTION:
-                world_->DoProvisionVM(request->vm_name());
+                world_->DoProvisionVM(request.vm_name());
                 break;
 
             case VMActionType::REBOOT_VM_ACTION:
@@ -79,17 +224,17 @@ sim::core::SimulatorRPCService::DoVMAction(ServerContext* context,
                               "VM reboot is not implemented yet"};
 
             case VMActionType::STOP_VM_ACTION:
-                world_->DoStopVM(request->vm_name());
+                world_->DoStopVM(request.vm_name());
                 break;
 
             case VMActionType::DELETE_VM_ACTION:
-                world_->DoDeleteVM(request->vm_name());
+                world_->DoDeleteVM(request.vm_name());
                 break;
 
             default:
                 return Status{StatusCode::INVALID_ARGUMENT,
                               fmt::format("Invalid vm_action_type: {}",
-                                          request->vm_action_type())};
+                                          request.vm_action_type())};
         }
     } catch (const std::exception& e) {
         return Status{StatusCode::INVALID_ARGUMENT, e.what()};
@@ -99,28 +244,286 @@ sim::core::SimulatorRPCService::DoVMAction(ServerContext* context,
 }
 
 grpc::Status
-sim::core::SimulatorRPCService::SimulateAll(ServerContext* context,
-                                            const Empty* request,
-                                            ServerWriter<LogMessage>* writer)
-{
-    SimulatorLogger::GetLogger().PushLoggingCallback(
-        [&writer, this](
-            TimeStamp ts, LogSeverity severity, std::string_view caller_type,
-            std::string_view caller_name, std::string_view text) {
+sim::core::SimulatorRPCService::ApplyBatchItem(
+    const BatchItem& item, std::unordered_set<std::string>& created_vms)
+{
+    switch (item.item_case()) {
+        case BatchItem::kCreateVm: {
+            auto status = ApplyCreateVM(item.create_vm());
+            if (status.ok()) {
+                created_vms.insert(item.create_vm().vm_name());
+            }
+            return status;
+        }
+
+        case BatchItem::kResourceAction:
+            return ApplyResourceAction(item.resource_action());
+
+        case BatchItem::kVmAction: {
+            const auto& vm_name = item.vm_action().vm_name();
+            if (created_vms.count(vm_name)) {
+                return Status{
+                    StatusCode::FAILED_PRECONDITION,
+                    fmt::format("VM {} is created after the last simulation",
+                                vm_name)};
+            }
+            return ApplyVMAction(item.vm_action());
+        }
+
+        default:
+            return Status{StatusCode::INVALID_ARGUMENT, "Empty batch item"};
+    }
+}
+
+grpc::Status
+sim::core::SimulatorRPCService::SimulateAll(
+    ServerContext* context, const SimulateAllMessage* request,
+    ServerWriter<LogBatchMessage>* writer)
+{
+    std::optional<LogBatcher> batcher;
+    try {
+        batcher.emplace(*request);
+    } catch (const std::regex_error& e) {
+        return Status{StatusCode::INVALID_ARGUMENT,
+                      fmt::format("Invalid caller_name_regex: {}", e.what())};
+    }
+
+    auto max_severity = LogSeverity::kDebug;
+    switch (request->filter().max_severity()) {
+        case proto_log_severity::ERROR_LOG_SEVERITY:
+            max_severity = LogSeverity::kError;
+            break;
+        case proto_log_severity::INFO_LOG_SEVERITY:
+            max_severity = LogSeverity::kInfo;
+            break;
+        default:
+            break;
+    }
+
+    // records above the severity are not even formatted, the others are
+    // filtered by the logger thread
+    auto add_log = [&batcher, this](TimeStamp ts, LogSeverity severity,
+                                    std::string_view caller_type,
+                                    std::string_view caller_name,
+                                    std::string_view text) {
+        if (!batcher->Matches(caller_type, caller_name)) {
+            return;
+        }
+
+        LogMessage log_message{};
+        FillLogMessage(&log_message, ts, severity, caller_type, caller_name,
+                       text);
+
+        batcher->Add(std::move(log_message));
+    };
+
+    // the callback is set only for this simulation, so logs of commands of
+    // other clients do not get here
+    auto simulated = Execute([&] {
+        SimulatorLogger::GetLogger().PushLoggingCallback(add_log, max_severity);
+        world_->SimulateAll();
+        SimulatorLogger::GetLogger().PopLoggingCallback();
+
+        batcher->Close();
+        return Status::OK;
+    });
+
+    // batches are taken even when the client is gone, the logger may wait
+    // for them
+    LogBatchMessage batch{};
+    bool connected = true;
+    while (batcher->Next(&batch)) {
+        connected =
+            connected && !context->IsCancelled() && writer->Write(batch);
+    }
+
+    return simulated.get();
+}
+
+grpc::Status
+sim::core::SimulatorRPCService::SimulateUntil(
+    ServerContext* context, const SimulateUntilMessage* request,
+    ServerWriter<ProgressMessage>* writer)
+{
+    auto until_ts = static_cast<TimeStamp>(request->until_time());
+
+    return SimulateWithProgress(
+        context, request->progress_period_ms(), writer, [until_ts, this] {
+            if (until_ts) {
+                world_->SimulateUntil(until_ts);
+            } else {
+                world_->SimulateAll();
+            }
+        });
+}
+
+grpc::Status
+sim::core::SimulatorRPCService::SimulateSteps(
+    ServerContext* context, const SimulateStepsMessage* request,
+    ServerWriter<ProgressMessage>* writer)
+{
+    auto steps_count = request->steps_count();
+
+    return SimulateWithProgress(
+        context, request->progress_period_ms(), writer,
+        [steps_count, this] { world_->SimulateSteps(steps_count); });
+}
+
+grpc::Status
+sim::core::SimulatorRPCService::SimulateWithProgress(
+    ServerContext* context, uint32_t period_ms,
+    ServerWriter<ProgressMessage>* writer,
+    const std::function<void()>& simulate)
+{
+    std::chrono::milliseconds period{period_ms ? period_ms : 1000};
+
+    // the simulation thread only queues records, the cancellation is noticed
+    // at the next one
+    ProgressQueue queue;
+    auto write_progress = [context,
+                           &queue](const SimulationProgress& progress) {
+        ProgressMessage message{};
+        message.set_time(progress.now);
+        message.set_handled_events(progress.handled_events);
+        message.set_queued_events(progress.queued_events);
+        message.set_events_per_second(progress.events_per_second);
+
+        return queue.Push(std::move(message)) && !context->IsCancelled();
+    };
+
+    auto status = Execute([&] {
+        world_->SimulateWithProgress(simulate, write_progress, period);
+        queue.Close();
+
+        return context->IsCancelled() || queue.IsCancelled()
+                   ? Status::CANCELLED
+                   : Status::OK;
+    });
+
+    // records are taken until the simulation ends, so it is not blocked
+    ProgressMessage message{};
+    while (queue.Next(&message)) {
+        if (!queue.IsCancelled() && !writer->Write(message)) {
+            queue.Cancel();
+        }
+    }
+
+    return status.get();
+}
+
+grpc::Status
+sim::core::SimulatorRPCService::StreamCommands(
+    ServerContext* context,
+    ServerReaderWriter<StreamReplyMessage, StreamCommandMessage>* stream)
+{
+    bool connected = true;
+
+    // the logger thread only batches the records, all writes to the stream
+    // are done by this thread
+    auto execute_logged = [&connected, stream,
+                           this](const std::function<Status()>& command) {
+        LogBatcher batcher{SimulateAllMessage{}};
+        auto add_log = [&batcher, this](TimeStamp ts, LogSeverity severity,
+                                        std::string_view caller_type,
+                                        std::string_view caller_name,
+                                        std::string_view text) {
             LogMessage log_message{};
+            FillLogMessage(&log_message, ts, severity, caller_type,
+                           caller_name, text);
 
-            log_message.set_time(ts);
-            log_message.set_severity(severity_mapping.at(severity));
-            log_message.set_caller_type(caller_type.data(), caller_type.size());
-            log_message.set_caller_name(caller_type.data(), caller_type.size());
-            log_message.set_text(text.data(), text.size());
+            batcher.Add(std::move(log_message));
+        };
 
-            writer->Write(log_message);
+        // the logger is flushed when the callback is removed, so logs of the
+        // simulation up to the command go before its result
+        auto status = Execute([&] {
+            SimulatorLogger::GetLogger().PushLoggingCallback(add_log);
+            auto applied = command();
+            SimulatorLogger::GetLogger().PopLoggingCallback();
+
+            batcher.Close();
+            return applied;
         });
 
-    world_->SimulateAll();
+        // batches are taken even when the client is gone, the logger may
+        // wait for them
+        LogBatchMessage batch{};
+        while (batcher.Next(&batch)) {
+            for (auto& log : *batch.mutable_logs()) {
+                StreamReplyMessage reply{};
+                *reply.mutable_log() = std::move(log);
+
+                connected = connected && stream->Write(reply);
+            }
+        }
 
-    SimulatorLogger::GetLogger().PopLoggingCallback();
+        return status.get();
+    };
 
-    return Status::OK;
+    std::unordered_set<std::string> created_vms;
+    StreamCommandMessage command{};
+
+    for (uint64_t index = 0; stream->Read(&command); ++index) {
+        StreamReplyMessage reply{};
+        auto result = reply.mutable_result();
+
+        auto status = execute_logged([&] {
+            auto applied = ApplyStreamCommand(command, created_vms);
+
+            result->set_time(world_->Now());
+            return applied;
+        });
+
+        result->set_index(index);
+        result->set_code(status.error_code());
+        result->set_text(status.error_message());
+
+        connected = connected && stream->Write(reply);
+    }
+
+    if (context->IsCancelled()) {
+        return Status::CANCELLED;
+    }
+
+    return execute_logged([this] {
+        world_->SimulateAll();
+
+        return Status::OK;
+    });
+}
+
+grpc::Status
+sim::core::SimulatorRPCService::ApplyStreamCommand(
+    const StreamCommandMessage& command,
+    std::unordered_set<std::string>& created_vms)
+{
+    auto time = static_cast<TimeStamp>(command.time());
+
+    if (time && time < world_->Now()) {
+        return Status{StatusCode::OUT_OF_RANGE,
+                      fmt::format("Command time {} is before the current {}",
+                                  time, world_->Now())};
+    }
+
+    if (time > world_->Now()) {
+        world_->SimulateUntil(time - 1);
+        created_vms.clear();
+    }
+
+    return ApplyBatchItem(command.command(), created_vms);
+}
+
+void
+sim::core::SimulatorRPCService::FillLogMessage(LogMessage* log_message,
+                                               TimeStamp ts,
+                                               LogSeverity severity,
+                                               std::string_view caller_type,
+                                               std::string_view caller_name,
+                                               std::string_view text)
+{
+    log_message->set_time(ts);
+    log_message->set_severity(severity_mapping.at(severity));
+    log_message->set_caller_type(caller_type.data(), caller_type.size());
+    log_message->set_caller_name(caller_name.data(), caller_name.size());
+    log_message->set_text(text.data(), text.size());
 }
@@ -1,9 +1,16 @@
 #pragma once
 
+#include <functional>
+#include <future>
+#include <string>
+#include <unordered_set>
+
 #include "actor-register.h"
 #include "actor.h"
 #include "event-loop.h"
+#include "log-batcher.h"
 #include "observer.h"
+#include "progress-queue.h"
 #include "world.h"
 
 // generated code
@@ -12,16 +19,27 @@
 
 namespace sim::core {
 
+using grpc::ServerAsyncResponseWriter;
+using grpc::ServerCompletionQueue;
 using grpc::ServerContext;
+using grpc::ServerReaderWriter;
 using grpc::ServerWriter;
 using grpc::Status;
 using grpc::StatusCode;
 
+using simulator_api::BatchItem;
+using simulator_api::BatchMessage;
+using simulator_api::BatchReplyMessage;
 using simulator_api::CreateVMMessage;
 using simulator_api::LogMessage;
+using simulator_api::ProgressMessage;
 using simulator_api::ResourceActionMessage;
 using simulator_api::ResourceActionType;
+using simulator_api::SimulateStepsMessage;
+using simulator_api::SimulateUntilMessage;
 using simulator_api::Simulator;
+using simulator_api::StreamCommandMessage;
+using simulator_api::StreamReplyMessage;
 using simulator_api::VMActionMessage;
 using simulator_api::VMActionType;
 using proto_log_severity = simulator_api::LogSeverity;
@@ -30,23 +48,92 @@ using google::protobuf::Empty;
 
 class World;
 
-class SimulatorRPCService final : public Simulator::Service
+/// Unary calls are served from the completion queue, streaming calls by
+/// gRPC handler threads
+using SimulatorServiceBase = Simulator::WithAsyncMethod_DoResourceAction<
+    Simulator::WithAsyncMethod_CreateVM<Simulator::WithAsyncMethod_DoVMAction<
+        Simulator::WithAsyncMethod_DoBatch<Simulator::Service>>>>;
+
+/**
+ * The world is touched only by the simulation thread: handlers post their
+ * work as commands to World::Post and the simulation thread applies them
+ * one by one between simulations. Unary calls do not occupy a thread while
+ * they wait, the simulation thread finishes them itself
+ */
+class SimulatorRPCService final : public SimulatorServiceBase
 {
  public:
     void SetWorld(World* world) { world_ = world; }
 
+    /// Starts accepting unary calls, then the queue should be polled
+    void Start(ServerCompletionQueue* queue);
+
+    /// Handles events of the queue until it is shut down
+    void Poll(ServerCompletionQueue* queue);
+
  private:
-    Status DoResourceAction(ServerContext* context,
-                            const ResourceActionMessage* request,
-                            Empty* response) override;
-    Status CreateVM(ServerContext* context, const CreateVMMessage* request,
-                    Empty* response) override;
-    Status DoVMAction(ServerContext* context, const VMActionMessage* request,
-                      Empty* response) override;
+    /// Tag of an asynchronous call in the completion queue
+    class IAsyncCall
+    {
+     public:
+        virtual void Proceed(bool ok) = 0;
+
+        virtual ~IAsyncCall() = default;
+    };
+
+    template <typename Request, typename Reply>
+    class AsyncUnaryCall;
+
+    /// Waits for calls of the method, the handler runs in the simulation
+    /// thread
+    template <typename Request, typename Reply, typename RequestMethod>
+    void Accept(ServerCompletionQueue* queue, RequestMethod request_method,
+                std::function<Status(const Request&, Reply*)> handler);
+
+    /// Runs the command in the simulation thread, the status is ready when
+    /// it is done
+    std::future<Status> Execute(std::function<Status()> command);
+
+    Status ApplyBatch(const BatchMessage& request, BatchReplyMessage* response);
+
+    Status StreamCommands(
+        ServerContext* context,
+        ServerReaderWriter<StreamReplyMessage, StreamCommandMessage>* stream)
+        override;
 
     // event-loop commands
-    Status SimulateAll(ServerContext* context, const Empty* request,
-                       ServerWriter<LogMessage>* writer) override;
+    Status SimulateAll(ServerContext* context,
+                       const SimulateAllMessage* request,
+                       ServerWriter<LogBatchMessage>* writer) override;
+    Status SimulateUntil(ServerContext* context,
+                         const SimulateUntilMessage* request,
+                         ServerWriter<ProgressMessage>* writer) override;
+    Status SimulateSteps(ServerContext* context,
+                         const SimulateStepsMessage* request,
+                         ServerWriter<ProgressMessage>* writer) override;
+
+    /// Runs the simulation streaming progress until the call is cancelled
+    Status SimulateWithProgress(ServerContext* context, uint32_t period_ms,
+                                ServerWriter<ProgressMessage>* writer,
+                                const std::function<void()>& simulate);
+
+    // single items, shared by the unary and batch calls
+    Status ApplyResourceAction(const ResourceActionMessage& request);
+    Status ApplyCreateVM(const CreateVMMessage& request);
+    Status ApplyVMAction(const VMActionMessage& request);
+
+    /// VM-s created since the last simulation are not known to VM storage,
+    /// so actions on them are rejected
+    Status ApplyBatchItem(const BatchItem& item,
+                          std::unordered_set<std::string>& created_vms);
+
+    /// Simulates up to the time of the command and applies it
+    Status ApplyStreamCommand(const StreamCommandMessage& command,
+                              std::unordered_set<std::string>& created_vms);
+
+    void FillLogMessage(LogMessage* log_message, TimeStamp ts,
+                        LogSeverity severity, std::string_view caller_type,
+                        std::string_view caller_name, std::string_view text);
 
     World* world_;
 
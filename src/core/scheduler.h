@@ -29,6 +29,12 @@ class IScheduler : public events::Observer
      * Output --- scheduled events for cloud_ and vm_storage_
      */
     virtual void UpdateSchedule() = 0;
+
+    /**
+     * Called before UpdateSchedule for each actor changed since the previous
+     * update, allows a scheduler to keep its own state incrementally
+     */
+    virtual void ActorChanged(UUID) {}
 };
 
 }   // namespace sim::core
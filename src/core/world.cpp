@@ -4,9 +4,12 @@
 #include <grpcpp/grpcpp.h>
 #include <grpcpp/health_check_service_interface.h>
 
+#include <thread>
+
 #include "custom-code.h"
 #include "logger.h"
 #include "scheduler.h"
+#include "trace-writer.h"
 #include "types.h"
 #include "vm-storage.h"
 #include "vm.h"
@@ -14,11 +17,40 @@
 void
 sim::core::World::Setup()
 {
-    SimulatorLogger::GetLogger().SetCSVFolder(config_->GetLogsPath());
-    SimulatorLogger::GetLogger().SetMaxCSVSeverity(LogSeverity::kDebug);
-    SimulatorLogger::GetLogger().SetMaxConsoleSeverity(LogSeverity::kDebug);
+    if (config_->GetLogFormat() == "trace") {
+        trace::TraceWriter::GetWriter().Open(
+            config_->GetLogsPath() + "/" + std::to_string(time(nullptr)) +
+            ".trace");
+    } else {
+        SimulatorLogger::GetLogger().SetCSVFolder(config_->GetLogsPath());
+    }
+    SimulatorLogger::GetLogger().SetMaxCSVSeverity(
+        config_->GetMaxLogSeverity());
+    SimulatorLogger::GetLogger().SetMaxConsoleSeverity(
+        config_->GetMaxLogSeverity());
+    SimulatorLogger::GetLogger().SetOverflowPolicy(
+        config_->GetLogOverflowPolicy());
+
+    if (config_->GetExecutionMode() == "conservative") {
+        auto loop = std::make_unique<events::ParallelEventLoop>(
+            config_->GetEventQueueType(), config_->GetExecutionThreads());
+        parallel_loop_ = loop.get();
+        event_loop_ = std::move(loop);
+    } else if (config_->GetExecutionMode() == "optimistic") {
+        auto loop = std::make_unique<events::OptimisticEventLoop>(
+            config_->GetExecutionThreads(), config_->GetOptimisticWindow());
+        parallel_loop_ = optimistic_loop_ = loop.get();
+        event_loop_ = std::move(loop);
+    } else {
+        event_loop_ = std::make_unique<events::EventLoop>(
+            events::MakeEventQueue(config_->GetEventQueueType()));
+    }
+    if (parallel_loop_) {
+        parallel_loop_->SetPartitionFunction(
+            [this](UUID uuid) { return GetPartition(uuid); });
+    }
+    seeds_ = SeedManager{config_->GetSeed()};
 
-    event_loop_ = std::make_unique<events::EventLoop>();
     auto now = [this] { return event_loop_->Now(); };
     schedule_event = [this](events::Event* event, bool immediate) {
         event_loop_->Insert(event, immediate);
@@ -29,11 +61,24 @@ sim::core::World::Setup()
     actor_register_ = std::make_unique<events::ActorRegister>();
     actor_register_->SetScheduleFunction(schedule_event);
     actor_register_->SetNowFunction(now);
+    actor_register_->SetMarkChangedFunction([this](UUID uuid) {
+        event_loop_->Defer([this, uuid] {
+            changed_ = true;
+            changed_actors_.push_back(uuid);
+            server_scheduler_manager_->MarkChanged(uuid);
+            if (parallel_loop_) {
+                parallel_loop_->UpdatePartition(uuid);
+            }
+        });
+    });
 
     server_scheduler_manager_ = std::make_unique<ServerSchedulerManager>();
     server_scheduler_manager_->SetScheduleFunction(schedule_event);
     server_scheduler_manager_->SetActorRegister(actor_register_.get());
     server_scheduler_manager_->SetNowFunction(now);
+    server_scheduler_manager_->SetThreadsCount(config_->GetSchedulerThreads());
+    server_scheduler_manager_->SetWakeUpFunction(
+        [this](TimeStamp ts) { WakeUpAt(ts); });
 
     event_loop_->SetActorFromUUIDCallback([this](UUID uuid) -> events::IActor* {
         return actor_register_->GetActor<events::IActor>(uuid);
@@ -44,27 +89,94 @@ sim::core::World::Setup()
 
     auto vm_storage = actor_register_->Make<infra::VMStorage>("vm-storage-1");
     vm_storage_handle_ = vm_storage->GetUUID();
+    vm_storage->SetRemoveActorFunction([this](UUID uuid) {
+        event_loop_->Defer([this, uuid] { actor_register_->Remove(uuid); });
+    });
 
     cloud->SetVMStorage(vm_storage_handle_);
 
-    scheduler_ = std::make_unique<custom::FirstAvailableScheduler>();
+    try {
+        scheduler_.reset(custom::GetScheduler(config_->GetCloudScheduler()));
+    } catch (const std::out_of_range&) {
+        throw std::runtime_error("Unknown cloud scheduler: " +
+                                 config_->GetCloudScheduler());
+    }
     scheduler_->SetActorRegister(actor_register_.get());
     scheduler_->SetScheduleFunction(schedule_event);
     scheduler_->SetNowFunction(now);
     scheduler_->SetMonitoredActor(cloud_handle_);
-
-    event_loop_->SetUpdateWorldCallback([this] {
-        WORLD_LOG_INFO("Updating world...");
-        server_scheduler_manager_->ScheduleAll();
-        scheduler_->UpdateSchedule();
-        WORLD_LOG_INFO("Updating world... ok");
+    scheduler_->SetWakeUpFunction([this](TimeStamp ts) {
+        WakeUpAt(ts);
+        scheduler_wake_ups_.push(ts);
     });
 
+    event_loop_->SetUpdateWorldCallback([this] { UpdateWorld(); });
+
     server_ = std::make_unique<SimulatorRPCService>();
     server_->SetWorld(this);
 
     config_->ParseResources(cloud_handle_, actor_register_.get(),
                             server_scheduler_manager_.get());
+
+    // resources tell changes of own power, the meter sums them up the tree
+    cloud->SetEnergyMeter(&energy_meter_, EnergyMeter::kNoParent);
+    for (auto dc_handle : cloud->GetDataCenters()) {
+        auto data_center =
+            actor_register_->GetActor<infra::DataCenter>(dc_handle);
+        data_center->SetEnergyMeter(&energy_meter_, cloud->GetMeterIndex());
+
+        for (auto server : data_center->GetServers()) {
+            actor_register_->GetActor<infra::Server>(server)->SetEnergyMeter(
+                &energy_meter_, data_center->GetMeterIndex());
+        }
+    }
+
+    if (parallel_loop_) {
+        SetupPartitions();
+    }
+}
+
+void
+sim::core::World::SetupPartitions()
+{
+    auto cloud = actor_register_->GetActor<infra::Cloud>(cloud_handle_);
+    const auto& data_centers = cloud->GetDataCenters();
+
+    for (uint32_t i = 0; i < data_centers.size(); ++i) {
+        partitions_[data_centers[i]] = i + 1;
+
+        auto dc = actor_register_->GetActor<infra::DataCenter>(data_centers[i]);
+        for (auto server : dc->GetServers()) {
+            partitions_[server] = i + 1;
+        }
+    }
+
+    parallel_loop_->SetPartitionsCount(data_centers.size() + 1);
+    for (auto [uuid, partition] : partitions_) {
+        parallel_loop_->UpdatePartition(uuid);
+    }
+
+    WORLD_LOG_INFO("Events are handled in {} partitions by {} threads",
+                   data_centers.size() + 1, config_->GetExecutionThreads());
+}
+
+uint32_t
+sim::core::World::GetPartition(UUID uuid) const
+{
+    if (auto it = partitions_.find(uuid); it != partitions_.end()) {
+        return it->second;
+    }
+
+    // a VM is handled together with its server
+    auto actor = actor_register_->FindActor(uuid);
+    if (actor && actor->GetTag() == events::ActorTag::kVM) {
+        if (auto it = partitions_.find(actor->GetOwner());
+            it != partitions_.end()) {
+            return it->second;
+        }
+    }
+
+    return 0;
 }
 
 void
@@ -78,19 +190,124 @@ sim::core::World::Listen()
     // Listen on the given address without any authentication mechanism.
     builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
     // Register "service" as the instance through which we'll communicate with
-    // clients. In this case it corresponds to an *synchronous* service.
+    // clients. Unary calls come to the completion queue, streaming ones to
+    // handler threads of gRPC.
     builder.RegisterService(server_.get());
+    auto queue = builder.AddCompletionQueue();
     // Finally assemble the server.
     std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
     std::cerr << "Server listening on " << server_address << std::endl;
 
+    std::thread simulation([this] { RunCommands(); });
+
+    server_->Start(queue.get());
+    std::thread poller([this, &queue] { server_->Poll(queue.get()); });
+
     // Wait for the server to shutdown. Note that some other thread must be
     // responsible for shutting down the server for this call to ever return.
     server->Wait();
 
+    queue->Shutdown();
+    poller.join();
+
+    Post({});
+    simulation.join();
+
     WORLD_LOG_INFO("Quit!");
 }
 
+void
+sim::core::World::RunCommands()
+{
+    while (auto command = commands_.Pop()) {
+        command();
+    }
+}
+
+void
+sim::core::World::UpdateWorld()
+{
+    bool woken_up = false;
+    while (!scheduler_wake_ups_.empty() &&
+           scheduler_wake_ups_.top() <= event_loop_->Now()) {
+        scheduler_wake_ups_.pop();
+        woken_up = true;
+    }
+
+    if (!changed_ && !woken_up && !server_scheduler_manager_->HasChanges()) {
+        return;
+    }
+
+    // schedulers only schedule events, so nothing changes during the update
+    bool update_scheduler = changed_ || woken_up;
+    changed_ = false;
+
+    auto start = std::chrono::steady_clock::now();
+
+    WORLD_LOG_INFO("Updating world...");
+    server_scheduler_manager_->ScheduleChanged();
+
+    auto servers_done = std::chrono::steady_clock::now();
+    update_stats_.server_schedulers_time += servers_done - start;
+
+    if (update_scheduler) {
+        for (UUID uuid : changed_actors_) {
+            UpdateMetrics(uuid);
+            scheduler_->ActorChanged(uuid);
+        }
+        changed_actors_.clear();
+        scheduler_->UpdateSchedule();
+        ++update_stats_.cloud_scheduler_updates;
+    }
+    WORLD_LOG_INFO("Updating world... ok");
+
+    auto finish = std::chrono::steady_clock::now();
+    update_stats_.cloud_scheduler_time += finish - servers_done;
+    update_stats_.total_time += finish - start;
+    ++update_stats_.updates;
+}
+
+void
+sim::core::World::UpdateMetrics(UUID uuid)
+{
+    auto it = provision_times_.find(uuid);
+    if (it == provision_times_.end()) {
+        return;
+    }
+
+    // removed VM-s have not started
+    auto actor = actor_register_->FindActor(uuid);
+    if (!actor || actor->GetTag() != events::ActorTag::kVM) {
+        return;
+    }
+
+    if (static_cast<const VM*>(actor)->GetState() == VMState::kRunning) {
+        ++metrics_.vms_started;
+        metrics_.total_wait_time += event_loop_->Now() - it->second;
+        provision_times_.erase(it);
+    }
+}
+
+sim::core::SimulationMetrics
+sim::core::World::GetMetrics() const
+{
+    auto metrics = metrics_;
+    metrics.energy =
+        actor_register_->GetActor<infra::Cloud>(cloud_handle_)->SpentEnergy();
+    return metrics;
+}
+
+void
+sim::core::World::WakeUpAt(TimeStamp ts)
+{
+    if (ts <= event_loop_->Now()) {
+        throw std::invalid_argument(
+            fmt::format("Wake-up time {} is not in the future", ts));
+    }
+
+    event_loop_->InsertWakeUp(ts);
+}
+
 sim::UUID
 sim::core::World::ResolveName(const std::string& name)
 {
@@ -127,14 +344,22 @@ sim::core::World::CreateVM(
     const std::string& vm_name, const std::string& vm_workload_model,
     const std::unordered_map<std::string, std::string>& params)
 {
-    UUID vm_uuid;
-    auto vm = actor_register_->Make<VM>(vm_name);
-    vm_uuid = vm->GetUUID();
+    // the VM is registered only when its model is valid, so a failed call
+    // changes nothing
+    std::unique_ptr<IVMWorkloadModel> workload_model;
+    try {
+        workload_model.reset(custom::GetWorkloadModel(vm_workload_model));
+    } catch (const std::out_of_range&) {
+        throw std::invalid_argument(
+            fmt::format("Unknown workload model: {}", vm_workload_model));
+    }
+    workload_model->Setup(params);
 
-    auto workload_model = custom::GetWorkloadModel(vm_workload_model);
+    auto vm = actor_register_->Make<VM>(vm_name);
+    auto vm_uuid = vm->GetUUID();
 
-    workload_model->Setup(params);
-    vm->SetWorkloadModel(workload_model);
+    workload_model->SetRandomStream(seeds_.MakeStream(vm_uuid));
+    vm->SetWorkloadModel(workload_model.release());
     vm->SetVMStorage(vm_storage_handle_);
 
     auto vmst_event = events::MakeEvent<VMStorageEvent>(
@@ -149,6 +374,87 @@ void
 sim::core::World::SimulateAll()
 {
     event_loop_->SimulateAll();
+    trace::TraceWriter::GetWriter().Flush();
+
+    const auto& stats = events::GetEventPoolStats();
+    WORLD_LOG_DEBUG("Events: {} acquired, {} released, {} slab allocations",
+                    stats.acquired, stats.released, stats.slab_allocations);
+
+    if (auto dropped = SimulatorLogger::GetLogger().GetDroppedCount()) {
+        WORLD_LOG_INFO("Log records dropped: {}", dropped);
+    }
+}
+
+void
+sim::core::World::SimulateUntil(TimeStamp until_ts)
+{
+    event_loop_->SimulateUntil(until_ts);
+}
+
+void
+sim::core::World::SimulateSteps(uint32_t steps_count)
+{
+    event_loop_->SimulateSteps(steps_count);
+}
+
+void
+sim::core::World::SimulateWithProgress(const std::function<void()>& simulate,
+                                       const ProgressFunction& progress,
+                                       std::chrono::milliseconds period)
+{
+    using Clock = std::chrono::steady_clock;
+
+    // the clock is read once in so many steps of the loop
+    constexpr uint32_t kClockCheckSteps = 64;
+
+    auto last_time = Clock::now();
+    auto last_handled = event_loop_->GetHandledCount();
+
+    auto report = [&](Clock::time_point now) {
+        auto handled = event_loop_->GetHandledCount();
+        std::chrono::duration<double> elapsed = now - last_time;
+
+        SimulationProgress record{
+            .now = event_loop_->Now(),
+            .handled_events = handled,
+            .queued_events = event_loop_->GetQueueSize(),
+            .events_per_second =
+                elapsed.count() > 0
+                    ? static_cast<double>(handled - last_handled) /
+                          elapsed.count()
+                    : 0.0};
+
+        last_time = now;
+        last_handled = handled;
+
+        return progress(record);
+    };
+
+    uint32_t steps = 0;
+    bool stopped = false;
+    event_loop_->SetInterruptCallback([&] {
+        if (++steps % kClockCheckSteps != 0) {
+            return false;
+        }
+
+        if (auto now = Clock::now(); now - last_time >= period) {
+            stopped = !report(now);
+        }
+        return stopped;
+    });
+
+    try {
+        simulate();
+    } catch (...) {
+        event_loop_->SetInterruptCallback({});
+        throw;
+    }
+    event_loop_->SetInterruptCallback({});
+    trace::TraceWriter::GetWriter().Flush();
+
+    if (!stopped) {
+        report(Clock::now());
+    }
 }
 
 void
@@ -156,6 +462,10 @@ sim::core::World::DoProvisionVM(const std::string& vm_name)
 {
     auto vm_uuid = ResolveName(vm_name);
 
+    if (provision_times_.emplace(vm_uuid, event_loop_->Now()).second) {
+        ++metrics_.vms_requested;
+    }
+
     auto vmst_event = events::MakeEvent<VMStorageEvent>(
         vm_storage_handle_, event_loop_->Now(), nullptr);
     vmst_event->type = VMStorageEventType::kVMProvisionRequested;
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <queue>
 #include <utility>
 #include <vector>
 
@@ -9,6 +12,10 @@
 #include "cloud.h"
 #include "config.h"
 #include "event-loop.h"
+#include "mpsc-queue.h"
+#include "optimistic-event-loop.h"
+#include "parallel-event-loop.h"
+#include "random.h"
 #include "resource-scheduler.h"
 #include "rpc-scheduler.h"
 #include "rpc-service.h"
@@ -19,6 +26,40 @@ namespace sim::core {
 
 class SimulatorRPCService;
 
+/// Wall-clock time spent in updates of the world
+struct UpdateWorldStats
+{
+    uint64_t updates{}, cloud_scheduler_updates{};
+    std::chrono::nanoseconds total_time{}, server_schedulers_time{},
+        cloud_scheduler_time{};
+};
+
+/// Outcome of the simulation, e.g. to compare runs with different seeds
+struct SimulationMetrics
+{
+    /// Spent by the cloud up to now
+    EnergyCount energy{};
+
+    uint64_t vms_requested{}, vms_started{};
+
+    /// Sum over started VM-s of ticks from the provision request to the start
+    TimeInterval total_wait_time{};
+};
+
+/// State of a long simulation, reported periodically
+struct SimulationProgress
+{
+    TimeStamp now{};
+    uint64_t handled_events{};
+    uint64_t queued_events{};
+
+    /// Since the previous record
+    double events_per_second{};
+};
+
+/// Receives progress records, returns false to stop the simulation
+using ProgressFunction = std::function<bool(const SimulationProgress&)>;
+
 using namespace sim::infra;
 using namespace sim::events;
 
@@ -31,8 +72,18 @@ class World
     }
 
     void Setup();
+
+    /// Serves RPC-s until the server is shut down, meanwhile the world is
+    /// changed only by the simulation thread
     void Listen();
 
+    /// Runs the command in the simulation thread between other commands,
+    /// may be called from any thread
+    void Post(std::function<void()> command)
+    {
+        commands_.Push(std::move(command));
+    }
+
     std::string_view WhoAmI() const { return whoami_; }
 
     void DoResourceAction(const std::string& resource_name,
@@ -50,13 +101,49 @@ class World
     // event-loop commands
     void SimulateAll();
 
+    /// Handles events up to the timestamp, then the time is until_ts + 1
+    void SimulateUntil(TimeStamp until_ts);
+
+    void SimulateSteps(uint32_t steps_count);
+
+    /**
+     * Runs the simulation (one of the calls above), progress is called
+     * every period and at the end. When progress returns false the
+     * simulation stops where it is, the next simulation continues it
+     */
+    void SimulateWithProgress(const std::function<void()>& simulate,
+                              const ProgressFunction& progress,
+                              std::chrono::milliseconds period);
+
+    TimeStamp Now() const { return event_loop_->Now(); }
+
+    const auto& GetUpdateWorldStats() const { return update_stats_; }
+
+    SimulationMetrics GetMetrics() const;
+
+    /// Statistics of the optimistic execution, nullptr in other modes
+    const events::TimeWarpStats* GetTimeWarpStats() const
+    {
+        return optimistic_loop_ ? &optimistic_loop_->GetStats() : nullptr;
+    }
+
  private:
     std::string whoami_{};
 
     std::unique_ptr<SimulatorRPCService> server_;
 
+    /// Commands of RPC-s to the simulation thread, an empty one stops it
+    MPSCQueue<std::function<void()>> commands_;
+
     std::unique_ptr<events::EventLoop> event_loop_;
 
+    /// Same as event_loop_ in the parallel modes, else nullptr
+    events::PartitionedEventLoop* parallel_loop_{};
+    events::OptimisticEventLoop* optimistic_loop_{};
+
+    /// Partitions of data centers and servers, VM-s follow their servers
+    std::unordered_map<UUID, uint32_t> partitions_;
+
     std::unique_ptr<events::ActorRegister> actor_register_;
 
     std::shared_ptr<SimulatorConfig> config_;
@@ -69,7 +156,41 @@ class World
 
     ScheduleFunction schedule_event;
 
+    /// Some actor has changed since the last update of the cloud scheduler
+    bool changed_{true};
+
+    /// Actors changed since the last update of the cloud scheduler
+    std::vector<UUID> changed_actors_;
+
+    /// Wake-up times requested by the cloud scheduler
+    std::priority_queue<TimeStamp, std::vector<TimeStamp>, std::greater<>>
+        scheduler_wake_ups_;
+
+    UpdateWorldStats update_stats_{};
+
+    /// Random streams of workload models of VM-s
+    SeedManager seeds_;
+
+    SimulationMetrics metrics_{};
+
+    EnergyMeter energy_meter_;
+
+    /// Provision request times of VM-s which have not started yet
+    std::unordered_map<UUID, TimeStamp> provision_times_;
+
     UUID ResolveName(const std::string& name);
+
+    /// Applies posted commands until the empty one
+    void RunCommands();
+
+    /// Partition 0 keeps the cloud, VM storage and VM-s without a server
+    uint32_t GetPartition(UUID uuid) const;
+    void SetupPartitions();
+
+    /// Runs schedulers whose input has changed or who asked to wake up now
+    void UpdateWorld();
+    void UpdateMetrics(UUID uuid);
+    void WakeUpAt(TimeStamp ts);
 };
 
 }   // namespace sim::core
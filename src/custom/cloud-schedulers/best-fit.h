@@ -0,0 +1,230 @@
+#pragma once
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "capacity-index.h"
+#include "scheduler.h"
+
+namespace sim::custom {
+
+using namespace sim::core;
+using namespace sim::infra;
+using namespace sim::events;
+
+/**
+ * Places each pending VM to a running server with enough free RAM, CPU and IO
+ * bandwidth. Free capacity of servers is kept in CapacityIndex, which is
+ * updated on placements and on changes of servers (boot, shutdown, provision
+ * and unprovision of VMs), so the cloud is never scanned after the first
+ * update. Capacity reserved for a VM which does not reach its server (the
+ * VM is deleted or rescheduled, the server fails) is released on changes of
+ * VM-Storage and of the server.
+ */
+class CapacityIndexScheduler : public IScheduler
+{
+ public:
+    enum class FitPolicy
+    {
+        kBestFit,
+        kWorstFit,
+    };
+
+    explicit CapacityIndexScheduler(FitPolicy policy) : policy_(policy) {}
+
+    void ActorChanged(UUID uuid) override
+    {
+        if (auto it = server_ids_.find(uuid); it != server_ids_.end()) {
+            UpdateServer(it->second);
+        } else if (uuid == vm_storage_) {
+            ReleaseAbandoned();
+        }
+    }
+
+    void UpdateSchedule() override
+    {
+        if (servers_.empty()) {
+            BuildIndex();
+        }
+
+        auto cloud = actor_register_->GetActor<Cloud>(monitored_);
+        auto vm_storage =
+            actor_register_->GetActor<VMStorage>(cloud->GetVMStorage());
+
+        for (const auto& [vm_uuid, vm_status] : vm_storage->GetVMs()) {
+            if (vm_status != VMStatus::kPending) {
+                continue;
+            }
+
+            auto workload =
+                actor_register_->GetActor<VM>(vm_uuid)->GetWorkload();
+            Capacity required{workload.required_ram.get(),
+                              workload.cpu_utilization.get(),
+                              workload.io_bandwidth.get()};
+
+            auto server_id = policy_ == FitPolicy::kBestFit
+                                 ? index_.FindBestFit(required)
+                                 : index_.FindWorstFit(required);
+            if (!server_id) {
+                WORLD_LOG_INFO("No running server fits VM {}", vm_uuid);
+                continue;
+            }
+
+            // reserve capacity now, the server hosts the VM a bit later
+            auto& entry = servers_[*server_id];
+            entry.used += required;
+            entry.placements.push_back({vm_uuid, required, false});
+            provisioning_.emplace(vm_uuid, *server_id);
+            index_.Update(*server_id, FreeCapacity(entry));
+
+            auto vmst_event = MakeEvent<VMStorageEvent>(cloud->GetVMStorage(),
+                                                        now(), nullptr);
+            vmst_event->type = VMStorageEventType::kVMScheduled;
+            vmst_event->vm_uuid = vm_uuid;
+
+            schedule_event(vmst_event, true);
+
+            auto server_event =
+                MakeEvent<ServerEvent>(entry.uuid, now(), nullptr);
+            server_event->type = ServerEventType::kProvisionVM;
+            server_event->vm_uuid = vm_uuid;
+
+            schedule_event(server_event, false);
+        }
+    }
+
+ private:
+    struct Placement
+    {
+        UUID vm;
+        Capacity required;
+
+        /// VM was seen in the list of hosted VMs of the server
+        bool hosted;
+    };
+
+    struct ServerEntry
+    {
+        UUID uuid;
+        Capacity total, used;
+        std::vector<Placement> placements;
+    };
+
+    const FitPolicy policy_;
+
+    /// Buffer of ReleaseAbandoned
+    std::vector<uint32_t> abandoned_;
+
+    CapacityIndex index_;
+
+    std::vector<ServerEntry> servers_;
+    std::unordered_map<UUID, uint32_t> server_ids_;
+
+    /// Server of each placement which is not hosted yet
+    std::unordered_map<UUID, uint32_t> provisioning_;
+    UUID vm_storage_;
+
+    static Capacity FreeCapacity(const ServerEntry& entry)
+    {
+        auto free = entry.total;
+        free -= entry.used;
+        return free;
+    }
+
+    void BuildIndex()
+    {
+        auto cloud = actor_register_->GetActor<Cloud>(monitored_);
+        vm_storage_ = cloud->GetVMStorage();
+
+        for (auto dc_handle : cloud->GetDataCenters()) {
+            auto dc = actor_register_->GetActor<DataCenter>(dc_handle);
+            for (auto server_handle : dc->GetServers()) {
+                auto spec = actor_register_->GetActor<Server>(server_handle)
+                                ->GetSpec();
+
+                uint32_t server_id = servers_.size();
+                servers_.push_back(
+                    {server_handle,
+                     {spec.ram.get(), spec.cores_count * 100ULL,
+                      spec.io_bandwidth.get()},
+                     {},
+                     {}});
+                server_ids_.emplace(server_handle, server_id);
+
+                UpdateServer(server_id);
+            }
+        }
+    }
+
+    /// Updates servers of VMs which may have left the provisioning status
+    void ReleaseAbandoned()
+    {
+        abandoned_.clear();
+        for (const auto& placement : provisioning_) {
+            abandoned_.push_back(placement.second);
+        }
+        std::sort(abandoned_.begin(), abandoned_.end());
+        abandoned_.erase(std::unique(abandoned_.begin(), abandoned_.end()),
+                         abandoned_.end());
+
+        for (auto server_id : abandoned_) {
+            UpdateServer(server_id);
+        }
+    }
+
+    /// Releases capacity of VMs which left the server or will never come to
+    /// it and re-indexes the server
+    void UpdateServer(uint32_t server_id)
+    {
+        auto& entry = servers_[server_id];
+        auto server = actor_register_->GetActor<Server>(entry.uuid);
+        const auto& vms = actor_register_->GetActor<VMStorage>(vm_storage_)
+                              ->GetVMs();
+
+        const auto& hosted = server->GetVMs();
+        bool running = server->IsRunning();
+        std::erase_if(entry.placements, [&](Placement& placement) {
+            if (hosted.count(placement.vm)) {
+                if (!placement.hosted) {
+                    placement.hosted = true;
+                    provisioning_.erase(placement.vm);
+                }
+                return false;
+            }
+
+            if (!placement.hosted) {
+                // the server does not accept VMs or the VM is not going to it
+                auto it = vms.find(placement.vm);
+                if (running && it != vms.end() &&
+                    it->second == VMStatus::kProvisioning) {
+                    return false;
+                }
+                provisioning_.erase(placement.vm);
+            }
+
+            entry.used -= placement.required;
+            return true;
+        });
+
+        if (server->IsRunning()) {
+            index_.Update(server_id, FreeCapacity(entry));
+        } else {
+            index_.Remove(server_id);
+        }
+    }
+};
+
+class BestFitScheduler : public CapacityIndexScheduler
+{
+ public:
+    BestFitScheduler() : CapacityIndexScheduler(FitPolicy::kBestFit) {}
+};
+
+class WorstFitScheduler : public CapacityIndexScheduler
+{
+ public:
+    WorstFitScheduler() : CapacityIndexScheduler(FitPolicy::kWorstFit) {}
+};
+
+}   // namespace sim::custom
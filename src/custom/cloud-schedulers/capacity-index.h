@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace sim::custom {
+
+/// Amount of server resources, CPU is measured in percents of one core
+struct Capacity
+{
+    uint64_t ram{};
+    uint64_t cpu{};
+    uint64_t io{};
+
+    bool Fits(const Capacity& required) const
+    {
+        return required.ram <= ram && required.cpu <= cpu && required.io <= io;
+    }
+
+    Capacity& operator+=(const Capacity& other)
+    {
+        ram += other.ram;
+        cpu += other.cpu;
+        io += other.io;
+        return *this;
+    }
+
+    Capacity& operator-=(const Capacity& other)
+    {
+        ram -= other.ram;
+        cpu -= other.cpu;
+        io -= other.io;
+        return *this;
+    }
+};
+
+/**
+ * Index of free capacity of servers, identified by dense ids.
+ *
+ * Servers are bucketed by free RAM, then by free CPU, and ordered by free IO
+ * bandwidth inside a bucket. The best (the least free resources
+ * lexicographically) and the worst (the most free resources) fitting server
+ * are found in O(log servers) when the first bucket fits. Otherwise buckets
+ * whose CPU or IO bandwidth does not fit are skipped one by one, so a search
+ * takes O(log servers + skipped buckets): the index pays off when the number
+ * of distinct free amounts is much smaller than the number of servers.
+ * Updates take O(log servers).
+ */
+class CapacityIndex
+{
+ public:
+    /// Inserts the server or moves it to the bucket of the new free capacity
+    void Update(uint32_t server, Capacity free)
+    {
+        Remove(server);
+        if (server >= entries_.size()) {
+            entries_.resize(server + 1);
+        }
+        entries_[server] = free;
+        tree_[free.ram][free.cpu].emplace(free.io, server);
+    }
+
+    void Remove(uint32_t server)
+    {
+        if (server >= entries_.size() || !entries_[server]) {
+            return;
+        }
+
+        auto free = *entries_[server];
+        entries_[server].reset();
+
+        auto ram_it = tree_.find(free.ram);
+        auto cpu_it = ram_it->second.find(free.cpu);
+        cpu_it->second.erase({free.io, server});
+        if (cpu_it->second.empty()) {
+            ram_it->second.erase(cpu_it);
+            if (ram_it->second.empty()) {
+                tree_.erase(ram_it);
+            }
+        }
+    }
+
+    bool Contains(uint32_t server) const
+    {
+        return server < entries_.size() && entries_[server];
+    }
+
+    /// Server with the least free resources which still fit the required ones
+    std::optional<uint32_t> FindBestFit(const Capacity& required) const
+    {
+        for (auto ram_it = tree_.lower_bound(required.ram);
+             ram_it != tree_.end(); ++ram_it) {
+            const auto& cpu_buckets = ram_it->second;
+            for (auto cpu_it = cpu_buckets.lower_bound(required.cpu);
+                 cpu_it != cpu_buckets.end(); ++cpu_it) {
+                auto it = cpu_it->second.lower_bound({required.io, 0});
+                if (it != cpu_it->second.end()) {
+                    return it->second;
+                }
+            }
+        }
+        return std::nullopt;
+    }
+
+    /// Server with the most free resources which fit the required ones
+    std::optional<uint32_t> FindWorstFit(const Capacity& required) const
+    {
+        for (auto ram_it = tree_.rbegin();
+             ram_it != tree_.rend() && ram_it->first >= required.ram;
+             ++ram_it) {
+            const auto& cpu_buckets = ram_it->second;
+            for (auto cpu_it = cpu_buckets.rbegin();
+                 cpu_it != cpu_buckets.rend() && cpu_it->first >= required.cpu;
+                 ++cpu_it) {
+                auto it = cpu_it->second.rbegin();
+                if (it->first >= required.io) {
+                    return it->second;
+                }
+            }
+        }
+        return std::nullopt;
+    }
+
+ private:
+    typedef std::set<std::pair<uint64_t, uint32_t>> IOBucket;
+
+    std::map<uint64_t, std::map<uint64_t, IOBucket>> tree_;
+
+    std::vector<std::optional<Capacity>> entries_;
+};
+
+}   // namespace sim::custom
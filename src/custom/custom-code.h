@@ -3,6 +3,7 @@
 #include <unordered_map>
 
 // Cloud schedulers
+#include "cloud-schedulers/best-fit.h"
 #include "cloud-schedulers/place-to-first.h"
 
 // Server schedulers
@@ -21,7 +22,9 @@ static auto
 GetScheduler(const std::string& name)
 {
     static std::unordered_map<std::string, SchedulerCreator> mapping = {
-        {"greedy", MakeScheduler<FirstAvailableScheduler>()}};
+        {"greedy", MakeScheduler<FirstAvailableScheduler>()},
+        {"best-fit", MakeScheduler<BestFitScheduler>()},
+        {"worst-fit", MakeScheduler<WorstFitScheduler>()}};
 
     return mapping.at(name)();
 }
@@ -30,7 +33,9 @@ static auto
 GetWorkloadModel(const std::string& name)
 {
     static std::unordered_map<std::string, WorkloadModelCreator> mapping = {
-        {"constant", MakeWorkloadModel<ConstantVMWorkloadModel>()}};
+        {"constant", MakeWorkloadModel<ConstantVMWorkloadModel>()},
+        {"random-uniform", MakeWorkloadModel<RandomUniformWorkloadModel>()},
+        {"trace", MakeWorkloadModel<TraceWorkloadModel>()}};
 
     return mapping.at(name)();
 }
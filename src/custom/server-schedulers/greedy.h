@@ -5,6 +5,7 @@
 // workload models
 #include "workload-models/constant.h"
 #include "workload-models/random-uniform.h"
+#include "workload-models/trace.h"
 
 namespace sim::custom {
 
@@ -27,22 +28,59 @@ class GreedyServerScheduler : public IServerScheduler
 
         RAMBytes remaining_ram = server_spec.ram;
 
+        vms_.clear();
         for (const auto& vm_handle : vm_handles) {
-            auto vm = actor_register_->GetActor<infra::VM>(vm_handle);
+            vms_.push_back(actor_register_->GetActor<infra::VM>(vm_handle));
+        }
+
+        const auto& workloads = batcher_.Evaluate(vms_, now());
+
+        // the power of the server depends on the total workload
+        uint64_t total_ram = 0, total_cpu = 0, total_io_bandwidth = 0;
+        for (size_t i = 0; i < vms_.size(); ++i) {
+            total_ram += workloads.required_ram[i];
+            total_cpu += workloads.cpu_utilization[i];
+            total_io_bandwidth += workloads.io_bandwidth[i];
+        }
+        server->SetWorkload(
+            {RAMBytes{total_ram},
+             CPUUtilizationPercent{static_cast<uint32_t>(total_cpu)},
+             IOBandwidthMBpS{static_cast<uint32_t>(total_io_bandwidth)}});
+
+        // time-varying workloads are evaluated again when they change
+        TimeStamp next_change = 0;
+        for (const auto* vm : vms_) {
+            auto change = vm->GetWorkloadModel()->GetNextChange(now());
+            if (change && (!next_change || change < next_change)) {
+                next_change = change;
+            }
+        }
+        if (next_change && next_change != wake_up_time_) {
+            wake_up_time_ = next_change;
+            wake_up(next_change);
+        }
 
-            auto vm_requirements = vm->GetWorkload();
+        for (size_t i = 0; i < vms_.size(); ++i) {
+            RAMBytes required_ram{workloads.required_ram[i]};
 
-            if (remaining_ram >= vm_requirements.required_ram) {
-                remaining_ram -= vm_requirements.required_ram;
+            if (remaining_ram >= required_ram) {
+                remaining_ram -= required_ram;
 
-                WORLD_LOG_INFO("VM {} is saturated", vm->GetName());
+                WORLD_LOG_INFO("VM {} is saturated", vms_[i]->GetName());
 
                 // TODO: notify vm that it is saturated?
             } else {
-                WORLD_LOG_INFO("VM {} is NOT saturated", vm->GetName());
+                WORLD_LOG_INFO("VM {} is NOT saturated", vms_[i]->GetName());
             }
         }
     }
+
+ private:
+    std::vector<const infra::VM*> vms_;
+    infra::WorkloadBatcher batcher_;
+
+    /// The last requested wake-up, so it is not requested twice
+    TimeStamp wake_up_time_{};
 };
 
 }   // namespace sim::custom
@@ -30,11 +30,23 @@ class ConstantVMWorkloadModel : public infra::IVMWorkloadModel
         }
     }
 
-    infra::Workload GetWorkload(TimeStamp time) override
+    infra::Workload GetWorkload(TimeStamp) override
     {
         return {required_ram_, required_cpu_, required_bandwidth_};
     }
 
+    void GetWorkloads(std::span<infra::IVMWorkloadModel* const> models,
+                      TimeStamp, infra::WorkloadBatch& batch) override
+    {
+        for (size_t i = 0; i < models.size(); ++i) {
+            const auto* model =
+                static_cast<const ConstantVMWorkloadModel*>(models[i]);
+            batch.required_ram[i] = model->required_ram_.get();
+            batch.cpu_utilization[i] = model->required_cpu_.get();
+            batch.io_bandwidth[i] = model->required_bandwidth_.get();
+        }
+    }
+
  private:
     RAMBytes required_ram_;
     CPUUtilizationPercent required_cpu_;
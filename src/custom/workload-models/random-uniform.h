@@ -1,64 +1,102 @@
 #pragma once
 
-#include <random>
+#include <span>
+#include <vector>
+
+#include "random.h"
 
 namespace sim::custom {
 
 class RandomUniformWorkloadModel : public infra::IVMWorkloadModel
 {
  public:
-    RandomUniformWorkloadModel() : generator(time(nullptr)) {}
-
     void Setup(
         const std::unordered_map<std::string, std::string>& params) override
     {
         if (auto it = params.find("required_ram"); it != params.end()) {
-            required_ram_ =
-                RAMBytes{static_cast<uint32_t>(std::stoi(it->second))};
-
-            ram_distribution =
-                std::uniform_int_distribution<uint32_t>{0, required_ram_.get()};
+            ram_bound_ = static_cast<uint32_t>(std::stoi(it->second));
         } else {
             throw std::invalid_argument("required_ram field not found");
         }
 
         if (auto it = params.find("required_cpu"); it != params.end()) {
-            required_cpu_ = CPUUtilizationPercent{
-                static_cast<uint32_t>(std::stoi(it->second))};
-
-            cpu_distribution =
-                std::uniform_int_distribution<uint32_t>{0, required_cpu_.get()};
+            cpu_bound_ = static_cast<uint32_t>(std::stoi(it->second));
         } else {
             throw std::invalid_argument("required_cpu field not found");
         }
 
         if (auto it = params.find("required_bandwidth"); it != params.end()) {
-            required_bandwidth_ =
-                IOBandwidthMBpS{static_cast<uint32_t>(std::stoi(it->second))};
-
-            bw_distribution = std::uniform_int_distribution<uint32_t>{
-                0, required_bandwidth_.get()};
+            bw_bound_ = static_cast<uint32_t>(std::stoi(it->second));
         } else {
             throw std::invalid_argument("required_bandwidth field not found");
         }
     }
 
+    void SetRandomStream(RandomStream stream) override { key_ = stream.Key(); }
+
+    /// The same time gives the same workload, however many times it is asked
     infra::Workload GetWorkload(TimeStamp time) override
     {
-        return {RAMBytes{ram_distribution(generator)},
-                CPUUtilizationPercent{cpu_distribution(generator)},
-                IOBandwidthMBpS{bw_distribution(generator)}};
+        auto counter = FirstCounter(time);
+
+        return {RAMBytes{Draw(key_, counter, ram_bound_)},
+                CPUUtilizationPercent{Draw(key_, counter + 1, cpu_bound_)},
+                IOBandwidthMBpS{Draw(key_, counter + 2, bw_bound_)}};
+    }
+
+    /// A new workload is drawn every tick
+    TimeStamp GetNextChange(TimeStamp time) const override { return time + 1; }
+
+    void GetWorkloads(std::span<infra::IVMWorkloadModel* const> models,
+                      TimeStamp time, infra::WorkloadBatch& batch) override
+    {
+        auto size = models.size();
+        auto counter = FirstCounter(time);
+        keys_.resize(size);
+
+        // bounds are read into the batch and turned into workloads in place
+        for (size_t i = 0; i < size; ++i) {
+            const auto* model =
+                static_cast<const RandomUniformWorkloadModel*>(models[i]);
+            keys_[i] = model->key_;
+
+            batch.required_ram[i] = model->ram_bound_;
+            batch.cpu_utilization[i] = model->cpu_bound_;
+            batch.io_bandwidth[i] = model->bw_bound_;
+        }
+
+        // no branches and calls, so the compiler vectorizes the loop
+        for (size_t i = 0; i < size; ++i) {
+            auto ram_bound = static_cast<uint32_t>(batch.required_ram[i]);
+            batch.required_ram[i] = Draw(keys_[i], counter, ram_bound);
+            batch.cpu_utilization[i] =
+                Draw(keys_[i], counter + 1, batch.cpu_utilization[i]);
+            batch.io_bandwidth[i] =
+                Draw(keys_[i], counter + 2, batch.io_bandwidth[i]);
+        }
     }
 
  private:
-    RAMBytes required_ram_{};
-    CPUUtilizationPercent required_cpu_{};
-    IOBandwidthMBpS required_bandwidth_{};
+    uint32_t ram_bound_{}, cpu_bound_{}, bw_bound_{};
+
+    /// Key of the stream of the VM, numbers of a time are taken from it
+    uint64_t key_{};
 
-    std::uniform_int_distribution<uint32_t> ram_distribution, cpu_distribution,
-        bw_distribution;
+    /// Buffer of keys of batches, kept by the thread
+    static inline thread_local std::vector<uint64_t> keys_;
 
-    std::mt19937 generator;
+    /// Position of the first of three numbers of the time in the stream
+    static uint64_t FirstCounter(TimeStamp time)
+    {
+        return static_cast<uint64_t>(time) * 3;
+    }
+
+    /// Uniform number in [0, bound] from the number of the stream
+    static uint32_t Draw(uint64_t key, uint64_t counter, uint32_t bound)
+    {
+        auto random = RandomStream::At(key, counter) >> 32;
+        return static_cast<uint32_t>(random * (uint64_t{bound} + 1) >> 32);
+    }
 };
 
 }   // namespace sim::custom
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <memory>
+#include <span>
+
+#include "workload-trace.h"
+
+namespace sim::custom {
+
+/**
+ * Replays utilization of a VM from a workload trace file made by
+ * csv-to-workload-trace. Params: "trace" - path to the file, "trace_vm" -
+ * name of the VM in the trace, "interpolate" - "true" for linear
+ * interpolation between samples. Models of all VM-s share one mapping of
+ * the file
+ */
+class TraceWorkloadModel : public infra::IVMWorkloadModel
+{
+ public:
+    void Setup(
+        const std::unordered_map<std::string, std::string>& params) override
+    {
+        if (auto it = params.find("trace"); it != params.end()) {
+            trace_ = trace::WorkloadTrace::Open(it->second);
+        } else {
+            throw std::invalid_argument("trace field not found");
+        }
+
+        if (auto it = params.find("trace_vm"); it != params.end()) {
+            vm_ = trace_->FindVM(it->second);
+        } else {
+            throw std::invalid_argument("trace_vm field not found");
+        }
+
+        if (auto it = params.find("interpolate"); it != params.end()) {
+            interpolate_ = it->second == "true";
+        }
+    }
+
+    infra::Workload GetWorkload(TimeStamp time) override
+    {
+        auto sample = trace_->GetSample(vm_, time, interpolate_);
+
+        return {RAMBytes{sample.ram}, CPUUtilizationPercent{sample.cpu},
+                IOBandwidthMBpS{sample.io_bandwidth}};
+    }
+
+    TimeStamp GetNextChange(TimeStamp time) const override
+    {
+        return trace_->GetNextChange(vm_, time, interpolate_);
+    }
+
+    void GetWorkloads(std::span<infra::IVMWorkloadModel* const> models,
+                      TimeStamp time, infra::WorkloadBatch& batch) override
+    {
+        for (size_t i = 0; i < models.size(); ++i) {
+            const auto* model =
+                static_cast<const TraceWorkloadModel*>(models[i]);
+            auto sample =
+                model->trace_->GetSample(model->vm_, time, model->interpolate_);
+
+            batch.required_ram[i] = sample.ram;
+            batch.cpu_utilization[i] = sample.cpu;
+            batch.io_bandwidth[i] = sample.io_bandwidth;
+        }
+    }
+
+ private:
+    std::shared_ptr<const trace::WorkloadTrace> trace_;
+    uint32_t vm_{};
+    bool interpolate_{};
+};
+
+}   // namespace sim::custom
@@ -1,24 +1,100 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <memory>
+#include <new>
+#include <stdexcept>
 #include <unordered_map>
+#include <vector>
 
 #include "actor.h"
 #include "types.h"
 
 namespace sim::events {
 
+/**
+ * Type-erased owner of actors of one concrete type
+ */
+class IActorStorage
+{
+ public:
+    virtual void Destroy(IActor* actor) = 0;
+
+    virtual ~IActorStorage() = default;
+};
+
+/**
+ * Actors of one type are placed contiguously in chunks of kChunkSize objects,
+ * places of destroyed actors are reused by new actors of the same type
+ */
+template <class Actor>
+class ActorStorage : public IActorStorage
+{
+ public:
+    Actor* Create()
+    {
+        if (free_.empty()) {
+            AllocateChunk();
+        }
+
+        void* memory = free_.back();
+        free_.pop_back();
+
+        try {
+            return new (memory) Actor();
+        } catch (...) {
+            free_.push_back(memory);
+            throw;
+        }
+    }
+
+    void Destroy(IActor* actor) override
+    {
+        auto typed_actor = static_cast<Actor*>(actor);
+        void* memory = typed_actor;
+        typed_actor->~Actor();
+
+        free_.push_back(memory);
+    }
+
+ private:
+    static constexpr size_t kChunkSize = 256;
+
+    struct alignas(Actor) Cell
+    {
+        std::byte data[sizeof(Actor)];
+    };
+
+    void AllocateChunk()
+    {
+        auto& chunk = chunks_.emplace_back(new Cell[kChunkSize]);
+
+        // the first cell of the chunk is taken first
+        for (size_t i = kChunkSize; i > 0; --i) {
+            free_.push_back(&chunk[i - 1]);
+        }
+    }
+
+    std::vector<std::unique_ptr<Cell[]>> chunks_;
+    std::vector<void*> free_;
+};
+
 /**
  * This class is responsible for owning all IActor objects in the simulator.
  *
  * It gives methods for creating new IActor instance and getting pointer from
- * UUID
+ * UUID. UUID is an index in the dense array of slots, so resolving is a
+ * bounds-checked load. Slots of removed actors are reused, their old UUIDs
+ * are detected by slot generation.
  */
 class ActorRegister
 {
  public:
     ActorRegister() : whoami_("Actor-Register") {}
 
+    ActorRegister(const ActorRegister& other) = delete;
+
     std::string_view WhoAmI() const { return whoami_; }
 
     /**
@@ -28,16 +104,43 @@ class ActorRegister
     const Actor* GetActor(UUID uuid) const
     {
         static_assert(std::is_base_of_v<IActor, Actor>);
+        static_assert(kOwnsTag<Actor>, "Actor should declare own kTag");
+
+        const IActor* actor = Resolve(uuid);
+        if (!actor->HasTag(Actor::kTag)) {
+            return nullptr;
+        }
 
-        return dynamic_cast<const Actor*>(actors_.at(uuid).get());
+        return static_cast<const Actor*>(actor);
     }
 
     template <class Actor>
     Actor* GetActor(UUID uuid)
     {
         static_assert(std::is_base_of_v<IActor, Actor>);
+        static_assert(kOwnsTag<Actor>, "Actor should declare own kTag");
 
-        return dynamic_cast<Actor*>(actors_.at(uuid).get());
+        IActor* actor = Resolve(uuid);
+        if (!actor->HasTag(Actor::kTag)) {
+            return nullptr;
+        }
+
+        return static_cast<Actor*>(actor);
+    }
+
+    /// Unlike GetActor, returns nullptr for unknown and removed actors
+    const IActor* FindActor(UUID uuid) const
+    {
+        if (!uuid || uuid.Index() >= slots_.size()) {
+            return nullptr;
+        }
+
+        const auto& slot = slots_[uuid.Index()];
+        if (slot.generation != uuid.Generation()) {
+            return nullptr;
+        }
+
+        return slot.actor;
     }
 
     UUID GetActorHandle(const std::string& name) const
@@ -49,17 +152,20 @@ class ActorRegister
     Actor* Make(std::string name)
     {
         static_assert(std::is_base_of_v<IActor, Actor>);
+        static_assert(kOwnsTag<Actor>, "Actor should declare own kTag");
+
+        if (auto it = actors_names_.find(name); it != actors_names_.end()) {
+            throw std::logic_error(fmt::format("Name {} is not unique", name));
+        }
+
+        auto actor = GetStorage<Actor>().Create();
+        actor->uuid_ = AllocateSlot(actor);
 
-        auto actor = new Actor();
         actor->SetScheduleFunction(schedule_event);
         actor->SetNowFunction(now);
-
-        actors_.emplace(actor->GetUUID(), actor);
+        actor->SetMarkChangedFunction(mark_changed);
 
         actor->SetName(name);
-        if (auto it = actors_names_.find(name); it != actors_names_.end()) {
-            throw std::logic_error(fmt::format("Name {} is not unique", name));
-        }
 
         actors_names_[name] = actor->GetUUID();
 
@@ -69,6 +175,28 @@ class ActorRegister
         return actor;
     }
 
+    /**
+     * Destroys the actor and frees its slot, the UUID becomes invalid.
+     * Should not be called from handlers of the removed actor
+     */
+    void Remove(UUID uuid)
+    {
+        auto actor = Resolve(uuid);
+
+        WORLD_LOG_INFO("Removed Actor {} with name {}", uuid, actor->GetName());
+
+        actors_names_.erase(std::string{actor->GetName()});
+
+        auto& slot = slots_[uuid.Index()];
+        slot.actor = nullptr;
+        ++slot.generation;
+        free_slots_.push_back(uuid.Index());
+
+        storages_[static_cast<size_t>(actor->GetTag())]->Destroy(actor);
+    }
+
+    size_t Size() const { return slots_.size() - 1 - free_slots_.size(); }
+
     void SetScheduleFunction(ScheduleFunction schedule_function)
     {
         schedule_event = std::move(schedule_function);
@@ -79,14 +207,84 @@ class ActorRegister
         now = std::move(now_function);
     }
 
+    void SetMarkChangedFunction(MarkChangedFunction mark_changed_function)
+    {
+        mark_changed = std::move(mark_changed_function);
+    }
+
+    ~ActorRegister()
+    {
+        for (auto& slot : slots_) {
+            if (slot.actor) {
+                storages_[static_cast<size_t>(slot.actor->GetTag())]->Destroy(
+                    slot.actor);
+            }
+        }
+    }
+
  private:
+    struct Slot
+    {
+        IActor* actor{};
+        uint32_t generation{};
+    };
+
     std::string whoami_{};
 
     ScheduleFunction schedule_event;
     NowFunction now;
+    MarkChangedFunction mark_changed;
+
+    IActor* Resolve(UUID uuid) const
+    {
+        if (!uuid || uuid.Index() >= slots_.size()) {
+            throw std::out_of_range(fmt::format("Unknown actor {}", uuid));
+        }
+
+        const auto& slot = slots_[uuid.Index()];
+        if (!slot.actor || slot.generation != uuid.Generation()) {
+            throw std::out_of_range(fmt::format("Actor {} was removed", uuid));
+        }
+
+        return slot.actor;
+    }
+
+    UUID AllocateSlot(IActor* actor)
+    {
+        uint32_t index;
+        if (free_slots_.empty()) {
+            index = static_cast<uint32_t>(slots_.size());
+            slots_.emplace_back();
+        } else {
+            index = free_slots_.back();
+            free_slots_.pop_back();
+        }
+
+        slots_[index].actor = actor;
+
+        return UUID{index, slots_[index].generation};
+    }
+
+    template <class Actor>
+    ActorStorage<Actor>& GetStorage()
+    {
+        auto& storage = storages_[static_cast<size_t>(Actor::kTag)];
+        if (!storage) {
+            storage = std::make_unique<ActorStorage<Actor>>();
+        }
+
+        return static_cast<ActorStorage<Actor>&>(*storage);
+    }
 
     std::unordered_map<std::string, UUID> actors_names_;
-    std::unordered_map<UUID, std::unique_ptr<IActor>> actors_;
+
+    /// Slot 0 is reserved for the null UUID
+    std::vector<Slot> slots_ = std::vector<Slot>(1);
+    std::vector<uint32_t> free_slots_;
+
+    std::array<std::unique_ptr<IActorStorage>,
+               static_cast<size_t>(ActorTag::kCount)>
+        storages_;
 };
 
 }   // namespace sim::events
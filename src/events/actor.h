@@ -3,15 +3,43 @@
 #include <functional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "event.h"
 #include "logger.h"
+#include "trace-writer.h"
 #include "types.h"
 
 namespace sim::events {
 
 typedef std::function<void(Event*, bool)> ScheduleFunction;
 
+/// Notifies the world that the state of the actor has changed
+typedef std::function<void(UUID)> MarkChangedFunction;
+
+/// Actions reverting changes of actors, the last one is undone first
+typedef std::vector<std::function<void()>> UndoLog;
+
+/**
+ * Tag of an actor class, used by ActorRegister instead of dynamic_cast. Each
+ * actor class, abstract ones too, declares own kTag and TagOwner, an actor
+ * keeps tags of its class and of all its bases
+ */
+enum class ActorTag : uint8_t
+{
+    kNone,   // IActor
+    kResource,
+    kCloud,
+    kDataCenter,
+    kServer,
+    kVM,
+    kVMStorage,
+
+    kCount,   // number of tags
+};
+
+class ActorRegister;
+
 /**
  * Abstract class for Actor. Each Actor should be able to HandleEvent (may
  * handle own overridden event) and has a callback for scheduling events
@@ -19,10 +47,15 @@ typedef std::function<void(Event*, bool)> ScheduleFunction;
 class IActor
 {
  public:
-    explicit IActor(std::string&& type) : type_(type), uuid_(UUID::Generate())
+    /// The tag is the one of the concrete class
+    IActor(std::string&& type, ActorTag tag)
+        : type_(type), tag_(tag), tags_(TagBit(kTag) | TagBit(tag))
     {
     }
 
+    static constexpr ActorTag kTag = ActorTag::kNone;
+    using TagOwner = IActor;
+
     /// Actor should provide event handler
     virtual void HandleEvent(const Event* event) = 0;
 
@@ -38,7 +71,14 @@ class IActor
         now = std::move(now_function);
     }
 
+    /// Actor tells the world about own state changes
+    void SetMarkChangedFunction(MarkChangedFunction mark_changed_function)
+    {
+        mark_changed = std::move(mark_changed_function);
+    }
+
     void SetOwner(UUID owner) { owner_ = owner; }
+    UUID GetOwner() const { return owner_; }
 
     std::string_view GetName() const { return name_; }
     virtual void SetName(std::string name) { name_ = std::move(name); }
@@ -46,40 +86,116 @@ class IActor
     std::string_view GetType() const { return type_; }
     void SetType(std::string type) { type_ = std::move(type); }
 
+    /// Tag of the concrete class
+    ActorTag GetTag() const { return tag_; }
+
+    /// Tells if the actor is an instance of the class with the tag
+    bool HasTag(ActorTag tag) const { return tags_ & TagBit(tag); }
+
     UUID GetUUID() const { return uuid_; }
 
+    /**
+     * Undo actions of the changes made by the calling thread go to the log
+     * until it is reset with nullptr. Used by the optimistic event loop to
+     * roll actors back
+     */
+    static void SetThreadUndoLog(UndoLog* undo_log)
+    {
+        thread_undo_log_ = undo_log;
+    }
+
     virtual ~IActor() = default;
 
  protected:
     ScheduleFunction schedule_event;
     NowFunction now;
+    MarkChangedFunction mark_changed;
+
+    /// Should be called on each change which may be observed by schedulers
+    void MarkChanged() const
+    {
+        if (mark_changed) {
+            mark_changed(uuid_);
+        }
+    }
 
     std::string type_{"Actor"}, name_{"Unnamed"};
 
+    /// Writes the record to the binary trace if it is enabled, time and
+    /// actor are filled here
+    void Trace(trace::TraceRecord record) const
+    {
+        auto& writer = trace::TraceWriter::GetWriter();
+        if (writer.IsOpen()) {
+            record.ts = now();
+            record.actor = uuid_;
+            writer.Write(record, name_);
+        }
+    }
+
+    /// Should be called before each change of the state kept between events
+    template <typename Undo>
+    void SaveUndo(Undo&& undo) const
+    {
+        if (thread_undo_log_) {
+            thread_undo_log_->emplace_back(std::forward<Undo>(undo));
+        }
+    }
+
+    /**
+     * Should be called when the event is rejected, so its notificator is
+     * never scheduled. The notificator is scheduled cancelled, the loop
+     * releases it without handling, and the optimistic loop may undo this
+     * together with the handler
+     */
+    void DropNotificator(const Event* event) const
+    {
+        if (auto notificator = event->notificator) {
+            SaveUndo([notificator] { notificator->is_cancelled = false; });
+            notificator->is_cancelled = true;
+            notificator->happen_time = event->happen_time;
+            schedule_event(notificator, false);
+        }
+    }
+
     UUID owner_{};
 
+    /// Should be called by constructors of abstract classes with own tags
+    void AddBaseTag(ActorTag tag) { tags_ |= TagBit(tag); }
+
  private:
-    const UUID uuid_;
+    friend class ActorRegister;
+
+    static_assert(static_cast<size_t>(ActorTag::kCount) <= 32);
+
+    static constexpr uint32_t TagBit(ActorTag tag)
+    {
+        return uint32_t{1} << static_cast<uint32_t>(tag);
+    }
+
+    static inline thread_local UndoLog* thread_undo_log_{};
+
+    const ActorTag tag_;
+
+    /// Bits of the tags of the class and its bases
+    uint32_t tags_;
+
+    /// Assigned by ActorRegister
+    UUID uuid_{};
 };
 
 }   // namespace sim::events
 
-#define ACTOR_LOG_INFO(...)                                               \
-    SimulatorLogger::GetLogger().LogNow(LogSeverity::kInfo, type_, name_, \
-                                        __VA_ARGS__)
-#define ACTOR_LOG_ERROR(...)                                               \
-    SimulatorLogger::GetLogger().LogNow(LogSeverity::kError, type_, name_, \
-                                        __VA_ARGS__)
-#define ACTOR_LOG_DEBUG(...)                                               \
-    SimulatorLogger::GetLogger().LogNow(LogSeverity::kDebug, type_, name_, \
-                                        __VA_ARGS__)
-
-#define WORLD_LOG_INFO(...)                                                    \
-    SimulatorLogger::GetLogger().LogNow(LogSeverity::kInfo, "World", WhoAmI(), \
-                                        __VA_ARGS__)
-#define WORLD_LOG_ERROR(...)                                          \
-    SimulatorLogger::GetLogger().LogNow(LogSeverity::kError, "World", \
-                                        WhoAmI(), __VA_ARGS__)
-#define WORLD_LOG_DEBUG(...)                                                   \
-    SimulatorLogger::GetLogger().LogNow(LogSeverity::kDebug, "World", whoami_, \
-                                        __VA_ARGS__)
+#define ACTOR_LOG_INFO(...) \
+    SIM_LOG(LogSeverity::kInfo, type_, name_, __VA_ARGS__)
+#define ACTOR_LOG_ERROR(...) \
+    SIM_LOG(LogSeverity::kError, type_, name_, __VA_ARGS__)
+#define ACTOR_LOG_DEBUG(...) \
+    SIM_LOG(LogSeverity::kDebug, type_, name_, __VA_ARGS__)
+
+#define WORLD_LOG_INFO(...) \
+    SIM_LOG(LogSeverity::kInfo, "World", WhoAmI(), __VA_ARGS__)
+#define WORLD_LOG_ERROR(...) \
+    SIM_LOG(LogSeverity::kError, "World", WhoAmI(), __VA_ARGS__)
+#define WORLD_LOG_DEBUG(...) \
+    SIM_LOG(LogSeverity::kDebug, "World", whoami_, __VA_ARGS__)
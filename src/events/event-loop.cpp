@@ -1,5 +1,6 @@
 #include "event-loop.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "actor.h"
@@ -15,47 +16,46 @@ sim::events::EventLoop::Insert(Event* event, bool immediate)
 
     if (event->happen_time < current_ts_) {
         WORLD_LOG_ERROR("Timestamp in the past!");
+        ReleaseEvent(event);
         return;
     }
 
-    if (auto it = queue_.find(event->happen_time); it != queue_.end()) {
-        auto& deq = it->second;
-        if (immediate) {
-            deq.emplace_front(event);
-        } else {
-            deq.emplace_back(event);
-        }
-    } else {
-        queue_[event->happen_time].emplace_back(event);
-    }
+    queue_->Push(event, immediate);
+}
+
+void
+sim::events::EventLoop::InsertWakeUp(TimeStamp ts)
+{
+    // event without addressee is not handled by anyone
+    Insert(MakeEvent<Event>(UUID{}, ts, nullptr), false);
 }
 
 void
 sim::events::EventLoop::SimulateAll()
 {
-    while (true) {
-        if (queue_.empty()) {
-            break;
-        }
+    while (!queue_->Empty() && !Interrupted()) {
         SimulateNextStep();
     }
 }
 
 void
-sim::events::EventLoop::SimulateUntil(uint32_t until_ts)
+sim::events::EventLoop::SimulateUntil(TimeStamp until_ts)
 {
-    while (true) {
-        if (current_ts_ > until_ts) {
-            break;
+    while (!queue_->Empty() && queue_->NextTime() <= until_ts) {
+        if (Interrupted()) {
+            return;
         }
         SimulateNextStep();
     }
+
+    // the time passes even if nothing happens
+    current_ts_ = std::max(current_ts_, until_ts + 1);
 }
 
 void
 sim::events::EventLoop::SimulateSteps(uint32_t steps_count)
 {
-    for (uint32_t i = 0; i < steps_count; ++i) {
+    for (uint32_t i = 0; i < steps_count && !Interrupted(); ++i) {
         SimulateNextStep();
     }
 }
@@ -63,35 +63,45 @@ sim::events::EventLoop::SimulateSteps(uint32_t steps_count)
 void
 sim::events::EventLoop::SimulateNextStep()
 {
-    if (queue_.empty()) {
+    if (queue_->Empty()) {
         WORLD_LOG_INFO("Queue is empty!");
     } else {
-        auto& [ts, ts_queue] = *queue_.begin();
+        auto ts = queue_->NextTime();
 
         current_ts_ = ts;
 
-        // ts_queue cannot be empty
-        auto event = *ts_queue.begin();
-        ts_queue.pop_front();
-
-        try {
-            if (!event->is_cancelled()) {
-                auto addressee_ptr = actor_from_uuid(event->addressee);
-                addressee_ptr->HandleEvent(event.get());
-            } else {
-                WORLD_LOG_INFO(
-                    "Event was not called because it was cancelled");
-            }
-        } catch (...) {
-            WORLD_LOG_ERROR("Error has occurred when handling event");
-        }
-
-        if (ts_queue.empty()) {
-            queue_.erase(ts);
+        HandleEvent(queue_->Pop());
+        ++handled_count_;
 
+        // handler may schedule more events for the same timestamp
+        if (queue_->Empty() || queue_->NextTime() != ts) {
             update_world();
 
             ++current_ts_;
         }
     }
 }
+
+void
+sim::events::EventLoop::HandleEvent(Event* event)
+{
+    DispatchEvent(event);
+    ReleaseEvent(event);
+}
+
+void
+sim::events::EventLoop::DispatchEvent(const Event* event)
+{
+    try {
+        if (!event->addressee) {
+            // wake-up, only the world update is needed
+        } else if (!event->is_cancelled) {
+            auto addressee_ptr = actor_from_uuid(event->addressee);
+            addressee_ptr->HandleEvent(event);
+        } else {
+            WORLD_LOG_INFO("Event was not called because it was cancelled");
+        }
+    } catch (...) {
+        WORLD_LOG_ERROR("Error has occurred when handling event");
+    }
+}
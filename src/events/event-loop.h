@@ -1,48 +1,64 @@
 #pragma once
 
-#include <deque>
-#include <map>
+#include <functional>
+#include <memory>
 
 #include "actor.h"
+#include "event-queue.h"
 #include "event.h"
 
 namespace sim::events {
 
-/**
-Using deque to have ability of adding event to the head or to the end of queue
- */
-typedef std::map<TimeStamp, std::deque<std::shared_ptr<Event>>> EventQueue;
-
 class EventLoop
 {
  public:
-    EventLoop() : whoami_("Event-Loop") {}
+    explicit EventLoop(
+        std::unique_ptr<IEventQueue> queue = std::make_unique<MapEventQueue>())
+        : whoami_("Event-Loop"), queue_(std::move(queue))
+    {
+    }
 
     /**
      *
      * To be used in closure passed to each component able to generate events
      */
-    void Insert(Event* event, bool immediate = false);
+    virtual void Insert(Event* event, bool immediate = false);
+
+    /**
+     * Makes the loop stop at the timestamp and update the world even if there
+     * are no other events
+     */
+    void InsertWakeUp(TimeStamp ts);
 
     /**
      *
      * @param steps_count Count of steps to simulate
      */
-    void SimulateSteps(uint32_t steps_count);
+    virtual void SimulateSteps(uint32_t steps_count);
 
-    void SimulateUntil(uint32_t until_ts);
+    /**
+     * Handles events with timestamps up to until_ts, then moves the time to
+     * until_ts + 1 even if the queue is empty
+     */
+    virtual void SimulateUntil(TimeStamp until_ts);
 
     /**
      * Simulate until the queue is empty
      */
-    void SimulateAll();
+    virtual void SimulateAll();
+
+    /**
+     * Runs the callback in the simulation thread when no event handler is
+     * running, for the serial loop it is right now
+     */
+    virtual void Defer(std::function<void()> callback) { callback(); }
 
     /**
      * Available only inside the CloudManager
      *
      * @return real time at the moment of call
      */
-    TimeStamp Now() const { return current_ts_; }
+    virtual TimeStamp Now() const { return current_ts_; }
 
     void SetActorFromUUIDCallback(const std::function<IActor*(UUID)>& cb)
     {
@@ -54,19 +70,52 @@ class EventLoop
         update_world = cb;
     }
 
+    /**
+     * The callback is called between steps of a simulation (timestamps of
+     * the conservative loop, windows of the optimistic one), the simulation
+     * stops early if it returns true. Empty callback is not called
+     */
+    void SetInterruptCallback(std::function<bool()> cb)
+    {
+        interrupt = std::move(cb);
+    }
+
+    /// Events handled (committed by the optimistic loop) since the start
+    virtual uint64_t GetHandledCount() const { return handled_count_; }
+
+    /// Events waiting to be handled
+    virtual size_t GetQueueSize() const { return queue_->Size(); }
+
     std::string_view WhoAmI() const { return whoami_; }
 
- private:
+    virtual ~EventLoop() = default;
+
+ protected:
     const std::string whoami_{};
 
-    void SimulateNextStep();
+    /// Calls the handler of the addressee and releases the event
+    void HandleEvent(Event* event);
+
+    /// Calls the handler of the addressee, the event is kept
+    void DispatchEvent(const Event* event);
 
     std::function<IActor*(UUID)> actor_from_uuid;
 
     std::function<void()> update_world;
 
+    std::function<bool()> interrupt;
+
+    uint64_t handled_count_{};
+
     TimeStamp current_ts_{1};
-    EventQueue queue_{};
+    std::unique_ptr<IEventQueue> queue_;
+
+ protected:
+    /// Asks the interrupt callback whether to stop the simulation
+    bool Interrupted() const { return interrupt && interrupt(); }
+
+ private:
+    void SimulateNextStep();
 };
 
 }   // namespace sim::events
@@ -0,0 +1,259 @@
+#include "event-queue.h"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+void
+sim::events::MapEventQueue::Push(Event* event, bool immediate)
+{
+    auto& deq = queue_[event->happen_time];
+    if (immediate) {
+        deq.push_front(event);
+    } else {
+        deq.push_back(event);
+    }
+    ++size_;
+}
+
+sim::TimeStamp
+sim::events::MapEventQueue::NextTime()
+{
+    return queue_.begin()->first;
+}
+
+sim::events::Event*
+sim::events::MapEventQueue::Pop()
+{
+    auto it = queue_.begin();
+    auto& deq = it->second;
+
+    // deq cannot be empty
+    auto event = deq.front();
+    deq.pop_front();
+
+    if (deq.empty()) {
+        queue_.erase(it);
+    }
+    --size_;
+
+    return event;
+}
+
+sim::events::MapEventQueue::~MapEventQueue()
+{
+    for (auto& [ts, deq] : queue_) {
+        for (auto event : deq) {
+            ReleaseEvent(event);
+        }
+    }
+}
+
+void
+sim::events::CalendarEventQueue::Bucket::Insert(const Entry& entry)
+{
+    if (Empty()) {
+        entries.clear();
+        head = 0;
+        entries.push_back(entry);
+    } else if (Less(entries.back(), entry)) {
+        // the most common case: a new event in the end of the bucket
+        entries.push_back(entry);
+    } else if (head > 0 && Less(entry, Front())) {
+        // immediate event for the earliest timestamp
+        entries[--head] = entry;
+    } else {
+        auto it = std::upper_bound(entries.begin() + head, entries.end(),
+                                   entry, Less);
+        entries.insert(it, entry);
+    }
+}
+
+sim::events::CalendarEventQueue::Entry
+sim::events::CalendarEventQueue::Bucket::PopFront()
+{
+    auto entry = entries[head++];
+
+    if (head == entries.size()) {
+        entries.clear();
+        head = 0;
+    } else if (head >= 32 && head * 2 >= entries.size()) {
+        entries.erase(entries.begin(), entries.begin() + head);
+        head = 0;
+    }
+
+    return entry;
+}
+
+sim::events::CalendarEventQueue::CalendarEventQueue()
+    : buckets_(kMinBucketsCount)
+{
+}
+
+void
+sim::events::CalendarEventQueue::Push(Event* event, bool immediate)
+{
+    Insert({event->happen_time, immediate ? --front_seq_ : ++back_seq_,
+            event});
+    ++size_;
+
+    if (size_ > 2 * buckets_.size()) {
+        Resize(2 * buckets_.size());
+    }
+}
+
+sim::TimeStamp
+sim::events::CalendarEventQueue::NextTime()
+{
+    Locate();
+
+    return buckets_[cursor_].Front().ts;
+}
+
+sim::events::Event*
+sim::events::CalendarEventQueue::Pop()
+{
+    Locate();
+
+    auto entry = buckets_[cursor_].PopFront();
+    --size_;
+
+    // the same bucket may contain the next event of this day
+    located_ = false;
+
+    if (buckets_.size() > kMinBucketsCount && 2 * size_ < buckets_.size()) {
+        Resize(buckets_.size() / 2);
+    }
+
+    return entry.event;
+}
+
+sim::events::CalendarEventQueue::~CalendarEventQueue()
+{
+    for (auto& bucket : buckets_) {
+        for (size_t i = bucket.head; i < bucket.entries.size(); ++i) {
+            ReleaseEvent(bucket.entries[i].event);
+        }
+    }
+}
+
+void
+sim::events::CalendarEventQueue::Insert(const Entry& entry)
+{
+    // all queued events are not earlier than the current day, so the cursor
+    // is moved back only if the new event is the earliest one
+    if (entry.ts < day_end_ - width_) {
+        cursor_ = BucketOf(entry.ts);
+        day_end_ = (entry.ts / width_ + 1) * width_;
+        located_ = false;
+    }
+
+    buckets_[BucketOf(entry.ts)].Insert(entry);
+}
+
+void
+sim::events::CalendarEventQueue::Locate()
+{
+    if (located_ || size_ == 0) {
+        return;
+    }
+
+    // walk through one year starting from the current day
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+        const auto& bucket = buckets_[cursor_];
+        if (!bucket.Empty() && bucket.Front().ts < day_end_) {
+            located_ = true;
+            return;
+        }
+
+        cursor_ = (cursor_ + 1) & (buckets_.size() - 1);
+        day_end_ += width_;
+    }
+
+    // the earliest event is more than a year ahead: direct search
+    const Entry* earliest{};
+    for (const auto& bucket : buckets_) {
+        if (!bucket.Empty() && (!earliest || Less(bucket.Front(), *earliest))) {
+            earliest = &bucket.Front();
+        }
+    }
+
+    cursor_ = BucketOf(earliest->ts);
+    day_end_ = (earliest->ts / width_ + 1) * width_;
+    located_ = true;
+}
+
+void
+sim::events::CalendarEventQueue::Resize(size_t buckets_count)
+{
+    scratch_.clear();
+    for (auto& bucket : buckets_) {
+        scratch_.insert(scratch_.end(), bucket.entries.begin() + bucket.head,
+                        bucket.entries.end());
+    }
+
+    width_ = EstimateWidth();
+
+    buckets_.clear();
+    buckets_.resize(buckets_count);
+
+    for (const auto& entry : scratch_) {
+        buckets_[BucketOf(entry.ts)].Insert(entry);
+    }
+
+    located_ = false;
+    if (!scratch_.empty()) {
+        auto earliest =
+            std::min_element(scratch_.begin(), scratch_.end(), Less);
+        cursor_ = BucketOf(earliest->ts);
+        day_end_ = (earliest->ts / width_ + 1) * width_;
+        located_ = true;
+    }
+}
+
+sim::TimeInterval
+sim::events::CalendarEventQueue::EstimateWidth()
+{
+    // scratch_ holds all entries here
+    auto sample_size = std::min(scratch_.size(), kWidthSampleSize);
+    if (sample_size < 2) {
+        return width_;
+    }
+
+    std::partial_sort(scratch_.begin(), scratch_.begin() + sample_size,
+                      scratch_.end(), Less);
+
+    auto average_gap = [this, sample_size](TimeInterval limit) {
+        TimeInterval total{0};
+        size_t count{0};
+        for (size_t i = 1; i < sample_size; ++i) {
+            auto gap = scratch_[i].ts - scratch_[i - 1].ts;
+            if (gap <= limit) {
+                total += gap;
+                ++count;
+            }
+        }
+        return count ? total / static_cast<TimeInterval>(count) : 0;
+    };
+
+    // ignore gaps that are much bigger than average ones (Brown's heuristic)
+    auto gap = average_gap(std::numeric_limits<TimeInterval>::max());
+    gap = average_gap(2 * gap);
+
+    return std::max(TimeInterval{1}, 3 * gap);
+}
+
+std::unique_ptr<sim::events::IEventQueue>
+sim::events::MakeEventQueue(const std::string& name)
+{
+    if (name == "map") {
+        return std::make_unique<MapEventQueue>();
+    }
+    if (name == "calendar") {
+        return std::make_unique<CalendarEventQueue>();
+    }
+
+    throw std::invalid_argument(fmt::format("Unknown event queue {}", name));
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "event.h"
+#include "types.h"
+
+namespace sim::events {
+
+/**
+ * Abstract priority queue of events used by EventLoop.
+ *
+ * Events are ordered by happen_time. Events with equal happen_time are
+ * ordered by insertion: immediate events are placed before all already queued
+ * events of the same timestamp, other events are placed after them.
+ *
+ * Queue owns events which were pushed but not popped yet.
+ */
+class IEventQueue
+{
+ public:
+    virtual void Push(Event* event, bool immediate) = 0;
+
+    /// Timestamp of the earliest event, queue should not be empty
+    virtual TimeStamp NextTime() = 0;
+
+    /// Extracts the earliest event and passes its ownership to the caller
+    virtual Event* Pop() = 0;
+
+    virtual bool Empty() const = 0;
+    virtual size_t Size() const = 0;
+
+    virtual ~IEventQueue() = default;
+};
+
+/**
+ * Balanced tree of timestamps, each timestamp has own deque of events.
+ *
+ * Every new timestamp costs a tree node allocation and O(log n) search
+ */
+class MapEventQueue : public IEventQueue
+{
+ public:
+    void Push(Event* event, bool immediate) override;
+    TimeStamp NextTime() override;
+    Event* Pop() override;
+
+    bool Empty() const override { return queue_.empty(); }
+    size_t Size() const override { return size_; }
+
+    ~MapEventQueue() override;
+
+ private:
+    /**
+     * Using deque to have ability of adding event to the head or to the end of
+     * queue
+     */
+    std::map<TimeStamp, std::deque<Event*>> queue_;
+    size_t size_{};
+};
+
+/**
+ * Calendar queue (R. Brown, 1988): a ring of buckets, each bucket covers
+ * width_ ticks of a "year" of buckets_.size() * width_ ticks and holds sorted
+ * events of all years. Bucket count follows the queue size and width follows
+ * the average distance between the earliest events, so both Push and Pop are
+ * O(1) amortized.
+ */
+class CalendarEventQueue : public IEventQueue
+{
+ public:
+    CalendarEventQueue();
+
+    void Push(Event* event, bool immediate) override;
+    TimeStamp NextTime() override;
+    Event* Pop() override;
+
+    bool Empty() const override { return size_ == 0; }
+    size_t Size() const override { return size_; }
+
+    ~CalendarEventQueue() override;
+
+ private:
+    /**
+     * seq keeps the order of events with the same timestamp: immediate events
+     * get decreasing negative numbers, others get increasing positive ones
+     */
+    struct Entry
+    {
+        TimeStamp ts;
+        int64_t seq;
+        Event* event;
+    };
+
+    static bool Less(const Entry& lhs, const Entry& rhs)
+    {
+        return lhs.ts < rhs.ts || (lhs.ts == rhs.ts && lhs.seq < rhs.seq);
+    }
+
+    /**
+     * Sorted entries, the popped prefix [0, head) is reused by immediate
+     * events and compacted lazily, so memory is not returned between runs
+     */
+    struct Bucket
+    {
+        std::vector<Entry> entries;
+        size_t head{};
+
+        bool Empty() const { return head == entries.size(); }
+        const Entry& Front() const { return entries[head]; }
+
+        void Insert(const Entry& entry);
+        Entry PopFront();
+    };
+
+    static constexpr size_t kMinBucketsCount = 16;
+    static constexpr size_t kWidthSampleSize = 25;
+
+    size_t BucketOf(TimeStamp ts) const
+    {
+        return static_cast<size_t>(ts / width_) & (buckets_.size() - 1);
+    }
+
+    void Insert(const Entry& entry);
+
+    /// Moves cursor_ to the bucket which holds the earliest event
+    void Locate();
+
+    void Resize(size_t buckets_count);
+
+    TimeInterval EstimateWidth();
+
+    std::vector<Bucket> buckets_;
+    TimeInterval width_{1};
+    size_t size_{};
+
+    /// Bucket of the current "day" and the end of this day
+    size_t cursor_{};
+    TimeStamp day_end_{1};
+    bool located_{false};
+
+    int64_t front_seq_{0}, back_seq_{0};
+
+    /// Buffer for entries while resizing
+    std::vector<Entry> scratch_;
+};
+
+/**
+ * @param name "map" or "calendar"
+ */
+std::unique_ptr<IEventQueue> MakeEventQueue(const std::string& name);
+
+}   // namespace sim::events
@@ -1,7 +1,11 @@
 #pragma once
 
-#include <functional>
+#include <atomic>
+#include <cstddef>
 #include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 #include "types.h"
@@ -10,18 +14,56 @@ namespace sim::events {
 
 class IActor;
 
+struct Event;
+
+typedef void (*EventReleaseFunction)(Event*);
+
+/**
+ * A class with a tag declares it together with itself as the owner of the
+ * tag: kTag and TagOwner. A derived class which only inherits them is not
+ * the owner, such classes are rejected at compile time where they are cast
+ * by tags, as the tag of the base cannot tell them apart from the base
+ */
+template <typename T>
+constexpr bool kOwnsTag = std::is_same_v<typename T::TagOwner, T>;
+
+/**
+ * Tag of the concrete event type. Handlers check it instead of dynamic_cast,
+ * each derived event declares own static constexpr kTag and TagOwner
+ */
+enum class EventTag : uint8_t
+{
+    kNone,
+    kResource,
+    kServer,
+    kVM,
+    kVMStorage,
+};
+
 /**
  * Abstract class for an event, may contain some context in derived
  * implementations
  */
 struct Event
 {
+    static constexpr EventTag kTag = EventTag::kNone;
+    using TagOwner = Event;
+
+    EventTag tag{EventTag::kNone};
+
     TimeStamp happen_time;
 
     /**
-     * A closure to get info about if the event was cancelled
+     * Cancelled events are dropped by EventLoop without calling the handler
+     */
+    bool is_cancelled{false};
+
+    /**
+     * Set by ParallelEventLoop when the event is queued, so the event keeps
+     * its place among events of the same time if it is moved to another
+     * partition
      */
-    std::function<bool()> is_cancelled = [] { return false; };
+    bool immediate{false};
 
     /**
      * Actor whose HandleEvent() method should be called
@@ -33,16 +75,189 @@ struct Event
      */
     Event* notificator{};
 
+    /**
+     * Returns the event to the pool it was taken from, set by MakeEvent.
+     * Events without pool are deleted
+     */
+    EventReleaseFunction release{};
+
     virtual ~Event() = default;
 };
 
+/**
+ * Counters of all event pools, slab_allocations stays the same when the
+ * simulation reuses events from free lists. Other allocations of the loop
+ * (queues, callbacks) are not counted
+ */
+struct EventPoolStats
+{
+    uint64_t acquired{};
+    uint64_t released{};
+    uint64_t slab_allocations{};
+};
+
+struct EventPoolCounters
+{
+    std::atomic<uint64_t> acquired{};
+    std::atomic<uint64_t> released{};
+    std::atomic<uint64_t> slab_allocations{};
+};
+
+inline EventPoolCounters&
+GetEventPoolCounters()
+{
+    static EventPoolCounters counters{};
+
+    return counters;
+}
+
+inline EventPoolStats
+GetEventPoolStats()
+{
+    const auto& counters = GetEventPoolCounters();
+
+    return {counters.acquired.load(std::memory_order_relaxed),
+            counters.released.load(std::memory_order_relaxed),
+            counters.slab_allocations.load(std::memory_order_relaxed)};
+}
+
+/**
+ * Free-list allocator for events of one type.
+ *
+ * Memory is taken from slabs of kSlabSize events and is never returned to the
+ * system, so after warm-up events are created without heap allocations. The
+ * free list is guarded by a spinlock, as events may be made by schedulers
+ * running in parallel.
+ */
+template <typename TEvent>
+class EventPool
+{
+ public:
+    static EventPool& GetPool()
+    {
+        static EventPool pool{};
+
+        return pool;
+    }
+
+    TEvent* Acquire()
+    {
+        Lock();
+        if (!free_list_) {
+            AllocateSlab();
+        }
+
+        auto node = free_list_;
+        free_list_ = node->next;
+        Unlock();
+
+        auto event = new (node->storage) TEvent();
+        event->tag = TEvent::kTag;
+        event->release = &EventPool::Release;
+
+        GetEventPoolCounters().acquired.fetch_add(1, std::memory_order_relaxed);
+
+        return event;
+    }
+
+    static void Release(Event* event)
+    {
+        auto& pool = GetPool();
+
+        auto typed_event = static_cast<TEvent*>(event);
+        void* memory = typed_event;
+        typed_event->~TEvent();
+
+        auto node = new (memory) Node;
+
+        pool.Lock();
+        node->next = pool.free_list_;
+        pool.free_list_ = node;
+        pool.Unlock();
+
+        GetEventPoolCounters().released.fetch_add(1, std::memory_order_relaxed);
+    }
+
+ private:
+    static constexpr size_t kSlabSize = 1024;
+
+    union Node
+    {
+        Node* next;
+        alignas(TEvent) std::byte storage[sizeof(TEvent)];
+    };
+
+    EventPool() = default;
+
+    void AllocateSlab()
+    {
+        auto& slab = slabs_.emplace_back(new Node[kSlabSize]);
+
+        for (size_t i = 0; i < kSlabSize; ++i) {
+            slab[i].next = free_list_;
+            free_list_ = &slab[i];
+        }
+
+        GetEventPoolCounters().slab_allocations.fetch_add(
+            1, std::memory_order_relaxed);
+    }
+
+    void Lock()
+    {
+        while (lock_.test_and_set(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+
+    void Unlock() { lock_.clear(std::memory_order_release); }
+
+    std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+
+    Node* free_list_{};
+    std::vector<std::unique_ptr<Node[]>> slabs_;
+};
+
+/**
+ * Replacement of dynamic_cast for events
+ *
+ * @return nullptr if the event is not TEvent
+ */
+template <typename TEvent>
+const TEvent*
+EventCast(const Event* event)
+{
+    static_assert(std::is_base_of_v<Event, TEvent>);
+    static_assert(kOwnsTag<TEvent>, "Event should declare own kTag");
+
+    if (event->tag != TEvent::kTag) {
+        return nullptr;
+    }
+
+    return static_cast<const TEvent*>(event);
+}
+
+/**
+ * Should be called by the owner of the event (EventLoop) when the event is
+ * handled or dropped
+ */
+inline void
+ReleaseEvent(Event* event)
+{
+    if (event->release) {
+        event->release(event);
+    } else {
+        delete event;
+    }
+}
+
 template <typename TEvent>
 TEvent*
 MakeEvent(UUID addressee, TimeStamp happen_time, Event* notificator)
 {
     static_assert(std::is_base_of_v<Event, TEvent>);
+    static_assert(kOwnsTag<TEvent>, "Event should declare own kTag");
 
-    auto event = new TEvent();
+    auto event = EventPool<TEvent>::GetPool().Acquire();
     event->addressee = addressee;
     event->happen_time = happen_time;
     event->notificator = notificator;
@@ -55,8 +270,9 @@ TEvent*
 MakeInheritedEvent(UUID addressee, const Event* base_event, TimeInterval delay)
 {
     static_assert(std::is_base_of_v<Event, TEvent>);
+    static_assert(kOwnsTag<TEvent>, "Event should declare own kTag");
 
-    auto event = new TEvent();
+    auto event = EventPool<TEvent>::GetPool().Acquire();
     event->addressee = addressee;
     event->happen_time = base_event->happen_time + delay;
     event->notificator = base_event->notificator;
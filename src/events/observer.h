@@ -7,6 +7,8 @@
 
 namespace sim::events {
 
+typedef std::function<void(TimeStamp)> WakeUpFunction;
+
 /**
  * A base class for instances that are not actors, but have access to the Cloud
  * state and is able to schedule events
@@ -33,6 +35,11 @@ class Observer
         now = std::move(now_function);
     }
 
+    void SetWakeUpFunction(WakeUpFunction wake_up_function)
+    {
+        wake_up = std::move(wake_up_function);
+    }
+
     void SetMonitoredActor(UUID monitored) { monitored_ = monitored; }
 
     virtual ~Observer() = default;
@@ -44,6 +51,10 @@ class Observer
     /// Observer can get current time
     NowFunction now;
 
+    /// Observer is updated only when something changes, but it may ask to be
+    /// updated at the given future time
+    WakeUpFunction wake_up;
+
     /// Observer can resolve actor UUID to an object using actor register
     const ActorRegister* actor_register_{};
 
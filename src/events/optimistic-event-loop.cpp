@@ -0,0 +1,574 @@
+#include "optimistic-event-loop.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "logger.h"
+#include "random.h"
+
+namespace {
+
+/// External events are numbered up from the middle, immediate ones down
+constexpr uint64_t kMiddleTiebreak = uint64_t{1} << 63;
+
+}   // namespace
+
+void
+sim::events::OptimisticEventLoop::SetPartitionsCount(size_t partitions_count)
+{
+    PartitionedEventLoop::SetPartitionsCount(partitions_count);
+
+    while (partitions_.size() < partitions_count) {
+        auto partition = std::make_unique<Partition>();
+        partition->index = partitions_.size();
+        partitions_.push_back(std::move(partition));
+    }
+}
+
+void
+sim::events::OptimisticEventLoop::Insert(Event* event, bool immediate)
+{
+    if (!event) {
+        throw std::runtime_error("Tried to schedule null event");
+    }
+
+    if (auto partition = thread_partition_) {
+        // sent by a handler, the immediate flag is not needed as the event
+        // goes after its cause anyway
+        auto& parent = *partition->current;
+        if (event->happen_time < parent.key.ts) {
+            WORLD_LOG_ERROR("Timestamp in the past!");
+            ReleaseEvent(event);
+            return;
+        }
+
+        auto key = MakeChildKey(parent.key, *event,
+                                partition->children_count++);
+        auto target = GetPartition(event->addressee);
+
+        // a notificator is owned by the event which brought it
+        parent.sent.push_back(
+            {key, event, target, event != parent.event->notificator});
+
+        if (target == partition->index) {
+            partition->pending.emplace(key, event);
+        } else {
+            Send(target, {key, event, false, false, false, nullptr});
+        }
+        return;
+    }
+
+    if (event->happen_time < current_ts_) {
+        WORLD_LOG_ERROR("Timestamp in the past!");
+        ReleaseEvent(event);
+        return;
+    }
+
+    if (!event->addressee) {
+        wake_ups_.insert(event->happen_time);
+    }
+
+    // immediate events go before all others of the timestamp, as in the
+    // serial loop
+    EventKey key{
+        .ts = event->happen_time,
+        .sent_ts =
+            immediate ? std::numeric_limits<TimeStamp>::min() : current_ts_,
+        .tiebreak = immediate ? kMiddleTiebreak - external_count_
+                              : kMiddleTiebreak + external_count_,
+    };
+    ++external_count_;
+
+    partitions_[GetPartition(event->addressee)]->pending.emplace(key, event);
+}
+
+void
+sim::events::OptimisticEventLoop::Defer(std::function<void()> callback)
+{
+    if (thread_partition_) {
+        thread_partition_->deferred.push_back(std::move(callback));
+    } else {
+        callback();
+    }
+}
+
+sim::TimeStamp
+sim::events::OptimisticEventLoop::Now() const
+{
+    if (thread_partition_ && thread_partition_->current) {
+        return thread_partition_->current->key.ts;
+    }
+    return current_ts_;
+}
+
+void
+sim::events::OptimisticEventLoop::SimulateSteps(uint32_t steps_count)
+{
+    auto committed = stats_.committed;
+    while (stats_.committed - committed < steps_count && NextTime() &&
+           !Interrupted()) {
+        SimulateNextWindow(std::numeric_limits<TimeStamp>::max() - 1);
+    }
+}
+
+void
+sim::events::OptimisticEventLoop::SimulateUntil(TimeStamp until_ts)
+{
+    while (true) {
+        auto next_time = NextTime();
+        if (!next_time || *next_time > until_ts) {
+            break;
+        }
+        if (Interrupted()) {
+            return;
+        }
+        SimulateNextWindow(until_ts);
+    }
+
+    current_ts_ = std::max(current_ts_, until_ts + 1);
+}
+
+void
+sim::events::OptimisticEventLoop::SimulateAll()
+{
+    while (NextTime() && !Interrupted()) {
+        SimulateNextWindow(std::numeric_limits<TimeStamp>::max() - 1);
+    }
+}
+
+size_t
+sim::events::OptimisticEventLoop::GetQueueSize() const
+{
+    size_t size = 0;
+    for (const auto& partition : partitions_) {
+        size += partition->pending.size();
+    }
+    return size;
+}
+
+sim::events::OptimisticEventLoop::~OptimisticEventLoop()
+{
+    for (auto& partition : partitions_) {
+        for (auto& handled : partition->handled) {
+            ReleaseEvent(handled.event);
+        }
+        for (auto [key, event] : partition->pending) {
+            ReleaseEvent(event);
+        }
+        for (auto event : partition->orphans) {
+            ReleaseEvent(event);
+        }
+
+        auto message = partition->inbox.exchange(nullptr);
+        while (message) {
+            if (!message->anti) {
+                ReleaseEvent(message->event);
+            }
+            delete std::exchange(message, message->next);
+        }
+    }
+}
+
+sim::events::EventKey
+sim::events::OptimisticEventLoop::MakeChildKey(const EventKey& parent,
+                                               const Event& event,
+                                               uint32_t index)
+{
+    auto ts = event.happen_time;
+
+    // a re-executed handler may send the event to another actor, while the
+    // previous copy is not cancelled yet, so copies of different addressees
+    // should have different keys
+    uint64_t hash = Mix(parent.tiebreak);
+    hash = Mix(hash ^ static_cast<uint64_t>(parent.ts));
+    hash = Mix(hash ^ static_cast<uint64_t>(parent.sent_ts));
+    hash = Mix(hash ^ (uint64_t{parent.depth} << 32 | index));
+    hash = Mix(hash ^ (uint64_t{event.addressee.Generation()} << 32 |
+                       event.addressee.Index()));
+
+    return {.ts = ts,
+            .depth = ts == parent.ts ? parent.depth + 1 : 0,
+            .sent_ts = parent.ts,
+            .tiebreak = hash};
+}
+
+std::optional<sim::TimeStamp>
+sim::events::OptimisticEventLoop::NextTime() const
+{
+    std::optional<TimeStamp> next_time;
+    for (const auto& partition : partitions_) {
+        if (!partition->pending.empty()) {
+            auto ts = partition->pending.begin()->first.ts;
+            if (!next_time || ts < *next_time) {
+                next_time = ts;
+            }
+        }
+    }
+    return next_time;
+}
+
+void
+sim::events::OptimisticEventLoop::SimulateNextWindow(TimeStamp until_ts)
+{
+    auto start_ts = *NextTime();
+    auto end_ts = std::min(start_ts + window_, until_ts + 1);
+    if (auto it = wake_ups_.lower_bound(start_ts); it != wake_ups_.end()) {
+        end_ts = std::min(end_ts, *it + 1);
+    }
+
+    current_ts_ = start_ts;
+    auto committed = stats_.committed;
+    ++stats_.windows;
+
+    auto& logger = SimulatorLogger::GetLogger();
+    auto& writer = trace::TraceWriter::GetWriter();
+
+    while (true) {
+        pool_.ParallelFor(partitions_.size(), [&, this, end_ts](size_t i,
+                                                                size_t) {
+            // threads of the pool serve only this simulation
+            SimulatorLogger::SetThreadLogger(&logger);
+            trace::TraceWriter::SetThreadWriter(&writer);
+
+            RunPartition(*partitions_[i], end_ts);
+        });
+        ++stats_.rounds;
+
+        auto gvt = ComputeGVT();
+        CommitBefore(gvt);
+
+        // messages sent after their receiver had finished need a new round
+        if (!HasMessages() && (!gvt || gvt->ts >= end_ts)) {
+            break;
+        }
+    }
+
+    wake_ups_.erase(wake_ups_.begin(), wake_ups_.lower_bound(end_ts));
+
+    for (auto& partition : partitions_) {
+        stats_.handled += std::exchange(partition->stats.handled, 0);
+        stats_.rolled_back += std::exchange(partition->stats.rolled_back, 0);
+        stats_.stragglers += std::exchange(partition->stats.stragglers, 0);
+        stats_.anti_messages +=
+            std::exchange(partition->stats.anti_messages, 0);
+
+        for (auto event : partition->orphans) {
+            ReleaseEvent(event);
+        }
+        partition->orphans.clear();
+    }
+
+    // callbacks may move actors to other partitions
+    for (auto& callback : committed_deferred_) {
+        callback();
+    }
+    committed_deferred_.clear();
+
+    // the world is updated at the last handled timestamp, as in the serial
+    // loop, so the time does not depend on the window length
+    if (stats_.committed != committed) {
+        current_ts_ = committed_ts_;
+        update_world();
+        current_ts_ = committed_ts_ + 1;
+    }
+}
+
+void
+sim::events::OptimisticEventLoop::RunPartition(Partition& partition,
+                                               TimeStamp end_ts)
+{
+    thread_partition_ = &partition;
+    SimulatorLogger::SetThreadCapture(&partition.log);
+    trace::TraceWriter::SetThreadCapture(&partition.trace);
+    IActor::SetThreadUndoLog(&partition.undo);
+
+    while (true) {
+        ReceiveMessages(partition);
+        if (partition.pending.empty() ||
+            partition.pending.begin()->first.ts >= end_ts) {
+            break;
+        }
+        HandleNext(partition);
+    }
+
+    thread_partition_ = nullptr;
+    SimulatorLogger::SetThreadCapture(nullptr);
+    trace::TraceWriter::SetThreadCapture(nullptr);
+    IActor::SetThreadUndoLog(nullptr);
+}
+
+void
+sim::events::OptimisticEventLoop::HandleNext(Partition& partition)
+{
+    auto [key, event] = *partition.pending.begin();
+    partition.pending.erase(partition.pending.begin());
+
+    if (auto target = GetPartition(event->addressee);
+        target != partition.index) {
+        // the addressee has moved since the event was sent
+        Send(target, {key, event, false, false, false, nullptr});
+        return;
+    }
+
+    // a notificator may be rescheduled by another copy of its sender
+    event->happen_time = key.ts;
+
+    auto undo_size = partition.undo.size();
+    auto log_size = partition.log.size;
+    auto trace_size = partition.trace.records.size();
+    auto deferred_size = partition.deferred.size();
+
+    auto& handled = partition.handled.emplace_back(
+        HandledEvent{.key = key, .event = event});
+    partition.current = &handled;
+    partition.children_count = 0;
+
+    DispatchEvent(event);
+
+    partition.current = nullptr;
+
+    handled.undo_count = partition.undo.size() - undo_size;
+    handled.log_count = partition.log.size - log_size;
+    handled.trace_count = partition.trace.records.size() - trace_size;
+    handled.deferred_count = partition.deferred.size() - deferred_size;
+
+    ++partition.stats.handled;
+}
+
+void
+sim::events::OptimisticEventLoop::ReceiveMessages(Partition& partition)
+{
+    // the stack is reversed, so messages are received in the order of sending
+    Message* messages = nullptr;
+    auto message = partition.inbox.exchange(nullptr, std::memory_order_acquire);
+    while (message) {
+        auto next = message->next;
+        message->next = messages;
+        messages = message;
+        message = next;
+    }
+
+    while (messages) {
+        message = std::exchange(messages, messages->next);
+
+        bool late = !partition.handled.empty() &&
+                    message->key <= partition.handled.back().key;
+
+        if (!message->anti) {
+            if (late) {
+                ++partition.stats.stragglers;
+                Rollback(partition, message->key);
+            }
+            partition.pending.emplace(message->key, message->event);
+        } else {
+            ++partition.stats.anti_messages;
+            if (late) {
+                Rollback(partition, message->key);
+            }
+            RemovePending(partition, message->key, message->owned,
+                          message->owns_notificator);
+        }
+
+        delete message;
+    }
+}
+
+void
+sim::events::OptimisticEventLoop::Rollback(Partition& partition,
+                                           const EventKey& key)
+{
+    while (!partition.handled.empty() && partition.handled.back().key >= key) {
+        auto& handled = partition.handled.back();
+
+        for (uint32_t i = 0; i < handled.undo_count; ++i) {
+            partition.undo.back()();
+            partition.undo.pop_back();
+        }
+
+        partition.log.size -= handled.log_count;
+        partition.trace.records.resize(partition.trace.records.size() -
+                                       handled.trace_count);
+        partition.deferred.resize(partition.deferred.size() -
+                                  handled.deferred_count);
+
+        for (auto it = handled.sent.rbegin(); it != handled.sent.rend(); ++it) {
+            Cancel(partition, *it, handled.event);
+        }
+
+        partition.pending.emplace(handled.key, handled.event);
+        partition.handled.pop_back();
+
+        ++partition.stats.rolled_back;
+    }
+}
+
+void
+sim::events::OptimisticEventLoop::Cancel(Partition& partition,
+                                         const SentEvent& sent,
+                                         const Event* parent)
+{
+    // a notificator not inherited from the parent was made by its handler
+    auto notificator = sent.event->notificator;
+    bool owns_notificator =
+        sent.owned && notificator && notificator != parent->notificator;
+
+    if (sent.partition == partition.index) {
+        RemovePending(partition, sent.key, sent.owned, owns_notificator);
+    } else {
+        Send(sent.partition,
+             {sent.key, sent.event, true, sent.owned, owns_notificator,
+              nullptr});
+    }
+}
+
+void
+sim::events::OptimisticEventLoop::RemovePending(Partition& partition,
+                                                const EventKey& key,
+                                                bool owned,
+                                                bool owns_notificator)
+{
+    // events sent later are rolled back first, so the event is pending
+    auto it = partition.pending.find(key);
+    if (it == partition.pending.end()) {
+        return;
+    }
+
+    if (owned) {
+        if (owns_notificator) {
+            // the notificator may still wait for own anti-message
+            partition.orphans.push_back(it->second->notificator);
+        }
+        ReleaseEvent(it->second);
+    }
+
+    partition.pending.erase(it);
+}
+
+void
+sim::events::OptimisticEventLoop::Send(uint32_t partition, Message message)
+{
+    auto node = new Message(message);
+    auto& inbox = partitions_[partition]->inbox;
+
+    node->next = inbox.load(std::memory_order_relaxed);
+    while (!inbox.compare_exchange_weak(node->next, node,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+    }
+}
+
+bool
+sim::events::OptimisticEventLoop::HasMessages() const
+{
+    return std::any_of(partitions_.begin(), partitions_.end(),
+                       [](const auto& partition) {
+                           return partition->inbox.load() != nullptr;
+                       });
+}
+
+std::optional<sim::events::EventKey>
+sim::events::OptimisticEventLoop::ComputeGVT() const
+{
+    std::optional<EventKey> gvt;
+    auto update = [&gvt](const EventKey& key) {
+        if (!gvt || key < *gvt) {
+            gvt = key;
+        }
+    };
+
+    // called at the barrier, so nothing is handled or sent meanwhile
+    for (const auto& partition : partitions_) {
+        if (!partition->pending.empty()) {
+            update(partition->pending.begin()->first);
+        }
+        for (auto message = partition->inbox.load(); message;
+             message = message->next) {
+            update(message->key);
+        }
+    }
+
+    return gvt;
+}
+
+void
+sim::events::OptimisticEventLoop::CommitBefore(
+    const std::optional<EventKey>& gvt)
+{
+    auto& logger = SimulatorLogger::GetLogger();
+    auto& writer = trace::TraceWriter::GetWriter();
+
+    struct Position
+    {
+        size_t handled, undo, log, trace, deferred;
+    };
+    std::vector<Position> positions(partitions_.size());
+
+    // records are written in the order of keys over all partitions
+    while (true) {
+        Partition* next = nullptr;
+        const EventKey* next_key = nullptr;
+        for (auto& partition : partitions_) {
+            auto i = positions[partition->index].handled;
+            if (i == partition->handled.size()) {
+                continue;
+            }
+
+            const auto& key = partition->handled[i].key;
+            if ((!gvt || key < *gvt) && (!next_key || key < *next_key)) {
+                next = partition.get();
+                next_key = &key;
+            }
+        }
+
+        if (!next) {
+            break;
+        }
+
+        auto& position = positions[next->index];
+        const auto& handled = next->handled[position.handled++];
+
+        for (uint32_t i = 0; i < handled.log_count; ++i) {
+            const auto& entry = next->log.entries[position.log++];
+            logger.Log(entry.ts, entry.severity, entry.caller_type,
+                       entry.caller_name, "{}", entry.text);
+        }
+        for (uint32_t i = 0; i < handled.trace_count; ++i) {
+            const auto& [record, actor_name] =
+                next->trace.records[position.trace++];
+            writer.Write(record, actor_name);
+        }
+        for (uint32_t i = 0; i < handled.deferred_count; ++i) {
+            committed_deferred_.push_back(
+                std::move(next->deferred[position.deferred++]));
+        }
+        position.undo += handled.undo_count;
+
+        committed_ts_ = handled.key.ts;
+        ReleaseEvent(handled.event);
+        ++stats_.committed;
+    }
+
+    // fossil collection
+    for (auto& partition : partitions_) {
+        const auto& position = positions[partition->index];
+
+        partition->handled.erase(
+            partition->handled.begin(),
+            partition->handled.begin() + position.handled);
+        partition->undo.erase(partition->undo.begin(),
+                              partition->undo.begin() + position.undo);
+
+        // strings of log entries keep their capacity
+        auto& log = partition->log;
+        std::rotate(log.entries.begin(), log.entries.begin() + position.log,
+                    log.entries.begin() + log.size);
+        log.size -= position.log;
+
+        partition->trace.records.erase(
+            partition->trace.records.begin(),
+            partition->trace.records.begin() + position.trace);
+        partition->deferred.erase(
+            partition->deferred.begin(),
+            partition->deferred.begin() + position.deferred);
+    }
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <atomic>
+#include <compare>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <vector>
+
+#include "actor.h"
+#include "logger.h"
+#include "parallel-event-loop.h"
+#include "trace-writer.h"
+
+namespace sim::events {
+
+/// Position of an event in the order of handling
+struct EventKey
+{
+    TimeStamp ts{};
+
+    /// Count of events of the same timestamp in the chain leading to this one
+    uint32_t depth{};
+
+    /// Time when the event was sent, earlier sent events go first
+    TimeStamp sent_ts{};
+
+    /// Sequence number of external events, a hash of the parent key and the
+    /// index among siblings for events sent by handlers
+    uint64_t tiebreak{};
+
+    auto operator<=>(const EventKey&) const = default;
+};
+
+struct TimeWarpStats
+{
+    /// Events handled by actors, rolled back ones are counted again
+    uint64_t handled{};
+    uint64_t committed{};
+    uint64_t rolled_back{};
+    uint64_t stragglers{};
+    uint64_t anti_messages{};
+    uint64_t windows{};
+    uint64_t rounds{};
+};
+
+/**
+ * Optimistic (Time Warp) parallel event loop. Actors are split into
+ * partitions as in ParallelEventLoop, each partition handles its events
+ * speculatively in the order of EventKey without waiting for others.
+ *
+ * Actors record undo actions of their changes (IActor::SaveUndo), log and
+ * trace records and deferred callbacks of handlers are kept aside. An event
+ * from another partition which should have been handled before the already
+ * handled ones (a straggler) rolls the partition back: changes are undone
+ * and events sent by the rolled back handlers are cancelled with
+ * anti-messages, which may roll back other partitions too.
+ *
+ * The world is updated once per time window of the given length (windows
+ * end at wake-up times too), at its last handled timestamp as the serial
+ * loop would. A window is simulated in rounds: partitions run in
+ * parallel until they have no events in the window, at the barrier global
+ * virtual time (GVT) is computed and everything handled before it is
+ * committed: records are written, events are released (fossil collection).
+ * Deferred callbacks run at the end of the window, so the partitions of
+ * actors change only between windows.
+ *
+ * Results do not depend on the threads count. Events of one timestamp are
+ * handled after their causes and after the events sent earlier, otherwise
+ * their order may differ from the serial loop.
+ */
+class OptimisticEventLoop : public PartitionedEventLoop
+{
+ public:
+    OptimisticEventLoop(size_t threads_count, TimeInterval window)
+        : PartitionedEventLoop(nullptr, threads_count), window_(window)
+    {
+        partitions_.push_back(std::make_unique<Partition>());
+    }
+
+    void SetPartitionsCount(size_t partitions_count) override;
+
+    void Insert(Event* event, bool immediate = false) override;
+
+    /// Simulates whole windows until at least steps_count events are handled
+    void SimulateSteps(uint32_t steps_count) override;
+    void SimulateUntil(TimeStamp until_ts) override;
+    void SimulateAll() override;
+
+    void Defer(std::function<void()> callback) override;
+
+    /// Time of the handled event for the threads of partitions
+    TimeStamp Now() const override;
+
+    const TimeWarpStats& GetStats() const { return stats_; }
+
+    uint64_t GetHandledCount() const override { return stats_.committed; }
+    size_t GetQueueSize() const override;
+
+    ~OptimisticEventLoop() override;
+
+ private:
+    /// Event or anti-message sent to another partition
+    struct Message
+    {
+        EventKey key;
+        Event* event;
+        bool anti;
+
+        /// The event should be released when it is cancelled
+        bool owned;
+
+        /// The notificator of the cancelled event should be released too
+        bool owns_notificator;
+
+        Message* next;
+    };
+
+    struct SentEvent
+    {
+        EventKey key;
+        Event* event;
+        uint32_t partition;
+        bool owned;
+    };
+
+    /// Handled event which is not committed yet
+    struct HandledEvent
+    {
+        EventKey key;
+        Event* event;
+        std::vector<SentEvent> sent{};
+
+        /// Counts of records the handler has added to the partition
+        uint32_t undo_count{}, log_count{}, trace_count{}, deferred_count{};
+    };
+
+    struct Partition
+    {
+        uint32_t index{};
+
+        std::map<EventKey, Event*> pending;
+        std::deque<HandledEvent> handled;
+
+        /// Lock-free stack of incoming messages, newest first
+        std::atomic<Message*> inbox{};
+
+        UndoLog undo;
+        LogCapture log;
+        trace::TraceCapture trace;
+        std::vector<std::function<void()>> deferred;
+
+        /// Notificators of cancelled events, released at the end of window
+        std::vector<Event*> orphans;
+
+        /// The event being handled
+        HandledEvent* current{};
+        uint32_t children_count{};
+
+        TimeWarpStats stats;
+    };
+
+    const TimeInterval window_;
+
+    std::vector<std::unique_ptr<Partition>> partitions_;
+
+    /// Sequence number of the next event inserted from outside of handlers
+    uint64_t external_count_{};
+
+    /// Times of wake-ups, the world should be updated at them
+    std::set<TimeStamp> wake_ups_;
+
+    /// Callbacks of committed events, run at the end of the window
+    std::vector<std::function<void()>> committed_deferred_;
+
+    TimeWarpStats stats_;
+
+    /// Time of the last committed event
+    TimeStamp committed_ts_{};
+
+    /// Partition handled by this thread
+    static inline thread_local Partition* thread_partition_{};
+
+    static EventKey MakeChildKey(const EventKey& parent, const Event& event,
+                                 uint32_t index);
+
+    /// Time of the first event or nullopt if there are no events
+    std::optional<TimeStamp> NextTime() const;
+
+    /// Simulates the next window, which ends not later than until_ts
+    void SimulateNextWindow(TimeStamp until_ts);
+
+    /// Runs the partition until it has no events before end_ts
+    void RunPartition(Partition& partition, TimeStamp end_ts);
+    void HandleNext(Partition& partition);
+    void ReceiveMessages(Partition& partition);
+
+    /// Rolls back all handled events with keys not less than the given one
+    void Rollback(Partition& partition, const EventKey& key);
+    void Cancel(Partition& partition, const SentEvent& sent,
+                const Event* parent);
+
+    /// Removes the pending event cancelled by its sender
+    void RemovePending(Partition& partition, const EventKey& key, bool owned,
+                       bool owns_notificator);
+
+    void Send(uint32_t partition, Message message);
+    bool HasMessages() const;
+
+    /// Minimum key of events which may still be handled or rolled back
+    std::optional<EventKey> ComputeGVT() const;
+
+    /// Commits events handled before the GVT in the order of keys
+    void CommitBefore(const std::optional<EventKey>& gvt);
+};
+
+}   // namespace sim::events
@@ -0,0 +1,213 @@
+#include "parallel-event-loop.h"
+
+#include <algorithm>
+
+#include "logger.h"
+
+void
+sim::events::PartitionedEventLoop::UpdatePartition(UUID uuid)
+{
+    if (actor_partitions_.size() <= uuid.Index()) {
+        actor_partitions_.resize(uuid.Index() + 1);
+    }
+
+    auto partition = partition_function_(uuid);
+    if (partition >= partitions_count_) {
+        throw std::out_of_range(
+            fmt::format("Partition {} of actor {} does not exist", partition,
+                        uuid));
+    }
+
+    actor_partitions_[uuid.Index()] = {uuid, partition};
+}
+
+void
+sim::events::ParallelEventLoop::SetPartitionsCount(size_t partitions_count)
+{
+    PartitionedEventLoop::SetPartitionsCount(partitions_count);
+
+    while (queues_.size() < partitions_count) {
+        queues_.push_back(MakeEventQueue(queue_type_));
+    }
+    outputs_.resize(queues_.size());
+}
+
+void
+sim::events::ParallelEventLoop::Insert(Event* event, bool immediate)
+{
+    if (!event) {
+        throw std::runtime_error("Tried to schedule null event");
+    }
+
+    if (thread_output_) {
+        thread_output_->events.emplace_back(event, immediate);
+    } else {
+        Route(event, immediate);
+    }
+}
+
+void
+sim::events::ParallelEventLoop::Defer(std::function<void()> callback)
+{
+    if (thread_output_) {
+        thread_output_->deferred.push_back(std::move(callback));
+    } else {
+        callback();
+    }
+}
+
+void
+sim::events::ParallelEventLoop::SimulateSteps(uint32_t steps_count)
+{
+    uint64_t handled = 0;
+    while (handled < steps_count && NextTime() && !Interrupted()) {
+        handled += SimulateNextTimeStamp();
+    }
+}
+
+void
+sim::events::ParallelEventLoop::SimulateUntil(TimeStamp until_ts)
+{
+    while (true) {
+        auto next_time = NextTime();
+        if (!next_time || *next_time > until_ts) {
+            break;
+        }
+        if (Interrupted()) {
+            return;
+        }
+        SimulateNextTimeStamp();
+    }
+
+    current_ts_ = std::max(current_ts_, until_ts + 1);
+}
+
+void
+sim::events::ParallelEventLoop::SimulateAll()
+{
+    while (NextTime() && !Interrupted()) {
+        SimulateNextTimeStamp();
+    }
+}
+
+size_t
+sim::events::ParallelEventLoop::GetQueueSize() const
+{
+    size_t size = 0;
+    for (const auto& queue : queues_) {
+        size += queue->Size();
+    }
+    return size;
+}
+
+std::optional<sim::TimeStamp>
+sim::events::ParallelEventLoop::NextTime()
+{
+    std::optional<TimeStamp> next_time;
+    for (auto& queue : queues_) {
+        if (!queue->Empty() && (!next_time || queue->NextTime() < *next_time)) {
+            next_time = queue->NextTime();
+        }
+    }
+    return next_time;
+}
+
+uint64_t
+sim::events::ParallelEventLoop::SimulateNextTimeStamp()
+{
+    auto ts = *NextTime();
+    current_ts_ = ts;
+
+    uint64_t handled = 0;
+    do {
+        RunRound(ts);
+        for (auto& output : outputs_) {
+            handled += std::exchange(output.handled, 0);
+        }
+    } while (NextTime() == ts);
+
+    update_world();
+    ++current_ts_;
+    handled_count_ += handled;
+
+    return handled;
+}
+
+void
+sim::events::ParallelEventLoop::RunRound(TimeStamp ts)
+{
+    auto& logger = SimulatorLogger::GetLogger();
+    auto& writer = trace::TraceWriter::GetWriter();
+
+    pool_.ParallelFor(queues_.size(), [&, this, ts](size_t partition, size_t) {
+        auto& output = outputs_[partition];
+
+        // threads of the pool serve only this simulation
+        SimulatorLogger::SetThreadLogger(&logger);
+        trace::TraceWriter::SetThreadWriter(&writer);
+
+        thread_output_ = &output;
+        SimulatorLogger::SetThreadCapture(&output.log);
+        trace::TraceWriter::SetThreadCapture(&output.trace);
+
+        HandlePartition(partition, ts);
+
+        thread_output_ = nullptr;
+        SimulatorLogger::SetThreadCapture(nullptr);
+        trace::TraceWriter::SetThreadCapture(nullptr);
+    });
+
+    // records refer to names of actors, which may be removed by callbacks
+    for (auto& output : outputs_) {
+        logger.Replay(output.log);
+        writer.Replay(output.trace);
+    }
+
+    // callbacks may move actors to other partitions before routing
+    for (auto& output : outputs_) {
+        for (auto& callback : output.deferred) {
+            callback();
+        }
+        output.deferred.clear();
+    }
+
+    for (auto& output : outputs_) {
+        for (auto [event, immediate] : output.events) {
+            Route(event, immediate);
+        }
+        output.events.clear();
+    }
+}
+
+void
+sim::events::ParallelEventLoop::HandlePartition(size_t partition, TimeStamp ts)
+{
+    auto& queue = *queues_[partition];
+    auto& output = outputs_[partition];
+
+    while (!queue.Empty() && queue.NextTime() == ts) {
+        auto event = queue.Pop();
+
+        if (GetPartition(event->addressee) != partition) {
+            // the addressee has moved since the event was sent
+            output.events.emplace_back(event, event->immediate);
+            continue;
+        }
+
+        HandleEvent(event);
+        ++output.handled;
+    }
+}
+
+void
+sim::events::ParallelEventLoop::Route(Event* event, bool immediate)
+{
+    if (event->happen_time < current_ts_) {
+        WORLD_LOG_ERROR("Timestamp in the past!");
+        ReleaseEvent(event);
+        return;
+    }
+
+    event->immediate = immediate;
+    queues_[GetPartition(event->addressee)]->Push(event, immediate);
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "event-loop.h"
+#include "event-queue.h"
+#include "logger.h"
+#include "thread-pool.h"
+#include "trace-writer.h"
+
+namespace sim::events {
+
+/// Partition which handles events of the actor, 0 is the default one
+typedef std::function<uint32_t(UUID)> PartitionFunction;
+
+/**
+ * Event loop whose actors are split into partitions (e.g., one per data
+ * center) handled in parallel. Keeps the partition of each actor
+ */
+class PartitionedEventLoop : public EventLoop
+{
+ public:
+    PartitionedEventLoop(std::unique_ptr<IEventQueue> queue,
+                         size_t threads_count)
+        : EventLoop(std::move(queue)), pool_(threads_count)
+    {
+    }
+
+    void SetPartitionFunction(PartitionFunction partition_function)
+    {
+        partition_function_ = std::move(partition_function);
+    }
+
+    /// Should be called before the simulation
+    virtual void SetPartitionsCount(size_t partitions_count)
+    {
+        partitions_count_ = partitions_count;
+    }
+
+    size_t GetPartitionsCount() const { return partitions_count_; }
+
+    /// Assigns the actor to the partition given by the partition function
+    void UpdatePartition(UUID uuid);
+
+ protected:
+    WorkStealingPool pool_;
+
+    uint32_t GetPartition(UUID uuid) const
+    {
+        if (uuid.Index() < actor_partitions_.size()) {
+            const auto& entry = actor_partitions_[uuid.Index()];
+            if (entry.uuid == uuid) {
+                return entry.partition;
+            }
+        }
+        return 0;
+    }
+
+ private:
+    struct PartitionEntry
+    {
+        UUID uuid;
+        uint32_t partition{};
+    };
+
+    size_t partitions_count_{1};
+
+    /// Indexed by UUID::Index(), entries of removed actors are ignored
+    std::vector<PartitionEntry> actor_partitions_;
+    PartitionFunction partition_function_;
+};
+
+/**
+ * Conservative parallel event loop. Actors are split into partitions (e.g.,
+ * one per data center), each partition has own event queue.
+ *
+ * The world is updated after every timestamp with events, so partitions are
+ * synchronized at each timestamp. A timestamp is simulated in rounds: in a
+ * round all partitions handle their events of this timestamp in parallel,
+ * then, at the barrier, side effects of the handlers (new events, deferred
+ * callbacks, log and trace records) are passed on in the order of
+ * partitions. Events of the same timestamp sent to other partitions are
+ * handled in the next round. Results do not depend on the threads count.
+ *
+ * The partition of an actor is changed only at the barrier with
+ * UpdatePartition, an event found in a wrong partition is forwarded to the
+ * right one, so an actor is never handled by two threads at once.
+ */
+class ParallelEventLoop : public PartitionedEventLoop
+{
+ public:
+    ParallelEventLoop(const std::string& queue_type, size_t threads_count)
+        : PartitionedEventLoop(MakeEventQueue(queue_type), threads_count),
+          queue_type_(queue_type)
+    {
+        queues_.push_back(std::move(queue_));
+        outputs_.resize(1);
+    }
+
+    void SetPartitionsCount(size_t partitions_count) override;
+
+    void Insert(Event* event, bool immediate = false) override;
+
+    /// Simulates whole timestamps until at least steps_count events are handled
+    void SimulateSteps(uint32_t steps_count) override;
+    void SimulateUntil(TimeStamp until_ts) override;
+    void SimulateAll() override;
+
+    void Defer(std::function<void()> callback) override;
+
+    size_t GetQueueSize() const override;
+
+ private:
+    /// Side effects of one partition in a round
+    struct Output
+    {
+        std::vector<std::pair<Event*, bool>> events;
+        std::vector<std::function<void()>> deferred;
+        LogCapture log;
+        trace::TraceCapture trace;
+        uint64_t handled{};
+    };
+
+    const std::string queue_type_;
+
+    std::vector<std::unique_ptr<IEventQueue>> queues_;
+    std::vector<Output> outputs_;
+
+    /// Output of the partition handled by this thread
+    static inline thread_local Output* thread_output_{};
+
+    std::optional<TimeStamp> NextTime();
+
+    /// Simulates the next timestamp, returns the count of handled events
+    uint64_t SimulateNextTimeStamp();
+
+    void RunRound(TimeStamp ts);
+    void HandlePartition(size_t partition, TimeStamp ts);
+
+    /// Puts the event to the queue of its partition
+    void Route(Event* event, bool immediate);
+};
+
+}   // namespace sim::events
@@ -9,7 +9,10 @@ namespace sim::infra {
 class Cloud : public IResource
 {
  public:
-    Cloud() : IResource("Cloud") {}
+    Cloud() : IResource("Cloud", kTag) {}
+
+    static constexpr events::ActorTag kTag = events::ActorTag::kCloud;
+    using TagOwner = Cloud;
 
     // for scheduler
     const auto& GetDataCenters() const { return data_centers_; }
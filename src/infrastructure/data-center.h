@@ -11,7 +11,10 @@ namespace sim::infra {
 class DataCenter : public IResource
 {
  public:
-    DataCenter() : IResource("Data-Center") {}
+    DataCenter() : IResource("Data-Center", kTag) {}
+
+    static constexpr events::ActorTag kTag = events::ActorTag::kDataCenter;
+    using TagOwner = DataCenter;
 
     void AddServer(UUID uuid)
     {
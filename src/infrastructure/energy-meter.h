@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "types.h"
+
+namespace sim::infra {
+
+/**
+ * Power draw and spent energy of the hierarchy of resources in flat arrays.
+ *
+ * A resource tells only changes of its own power, they are added to the
+ * totals of the resource and its ancestors. The energy of a subtree is kept
+ * as offset + power * now: a change of power by delta at time ts adds delta
+ * to the power and -delta * ts to the offset. So power and energy of any
+ * subtree are O(1) queries, and changes are commutative: servers of
+ * different partitions may change totals of common ancestors in parallel
+ * and roll their changes back in any order.
+ */
+class EnergyMeter
+{
+ public:
+    static constexpr uint32_t kNoParent = std::numeric_limits<uint32_t>::max();
+
+    /// Returns the index of the new resource, its parent should be added first
+    uint32_t AddResource(uint32_t parent)
+    {
+        parent_.push_back(parent);
+        power_.push_back(0);
+        offset_.push_back(0);
+
+        return static_cast<uint32_t>(parent_.size() - 1);
+    }
+
+    /// Changes the power of the resource by delta since ts
+    void AddPower(uint32_t resource, int64_t delta, TimeStamp ts)
+    {
+        for (auto i = resource; i != kNoParent; i = parent_[i]) {
+            std::atomic_ref{power_[i]}.fetch_add(delta,
+                                                 std::memory_order_relaxed);
+            std::atomic_ref{offset_[i]}.fetch_add(-delta * ts,
+                                                  std::memory_order_relaxed);
+        }
+    }
+
+    /// Power of the resource and its components
+    EnergyCount GetPower(uint32_t resource) const
+    {
+        return EnergyCount{static_cast<uint64_t>(power_[resource])};
+    }
+
+    /// Energy spent by the resource and its components up to now
+    EnergyCount GetEnergy(uint32_t resource, TimeStamp now) const
+    {
+        return EnergyCount{
+            static_cast<uint64_t>(offset_[resource] + power_[resource] * now)};
+    }
+
+ private:
+    std::vector<uint32_t> parent_;
+    std::vector<int64_t> power_, offset_;
+};
+
+}   // namespace sim::infra
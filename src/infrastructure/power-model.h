@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "types.h"
+
+namespace sim::infra {
+
+inline EnergyCount
+RoundPower(double power)
+{
+    return EnergyCount{static_cast<uint64_t>(std::lround(power))};
+}
+
+/**
+ * Power per tick of a running server by its CPU utilization in [0, 1]. It is
+ * evaluated only when the utilization or the power state changes, the energy
+ * between changes is integrated by EnergyMeter
+ */
+class IPowerModel
+{
+ public:
+    virtual EnergyCount GetPower(double utilization) const = 0;
+
+    virtual ~IPowerModel() = default;
+};
+
+/// Power grows linearly from idle to the full load
+class LinearPowerModel : public IPowerModel
+{
+ public:
+    LinearPowerModel(double idle_power, double max_power)
+        : idle_power_(idle_power), max_power_(max_power)
+    {
+    }
+
+    EnergyCount GetPower(double utilization) const override
+    {
+        return RoundPower(idle_power_ +
+                          (max_power_ - idle_power_) * utilization);
+    }
+
+ private:
+    double idle_power_, max_power_;
+};
+
+/**
+ * Power measured at equally spaced loads from 0 to 100% (e.g. 11 values of a
+ * SPECpower report), linearly interpolated between them
+ */
+class TablePowerModel : public IPowerModel
+{
+ public:
+    explicit TablePowerModel(std::vector<double> powers)
+        : powers_(std::move(powers))
+    {
+        if (powers_.size() < 2) {
+            throw std::invalid_argument(
+                "Power table should have at least 2 values");
+        }
+    }
+
+    EnergyCount GetPower(double utilization) const override
+    {
+        auto position = utilization * static_cast<double>(powers_.size() - 1);
+        auto index =
+            std::min(static_cast<size_t>(position), powers_.size() - 2);
+        auto fraction = position - static_cast<double>(index);
+
+        return RoundPower(powers_[index] +
+                          (powers_[index + 1] - powers_[index]) * fraction);
+    }
+
+ private:
+    std::vector<double> powers_;
+};
+
+/**
+ * Power at arbitrary loads, linearly interpolated between them. The first
+ * and the last values hold below and above their loads
+ */
+class PiecewisePowerModel : public IPowerModel
+{
+ public:
+    /// Points are (utilization, power) in increasing utilization
+    explicit PiecewisePowerModel(std::vector<std::pair<double, double>> points)
+        : points_(std::move(points))
+    {
+        if (points_.empty()) {
+            throw std::invalid_argument("Power curve should have points");
+        }
+        if (!std::is_sorted(points_.begin(), points_.end())) {
+            throw std::invalid_argument(
+                "Power curve points should go in increasing utilization");
+        }
+    }
+
+    EnergyCount GetPower(double utilization) const override
+    {
+        auto next = std::lower_bound(points_.begin(), points_.end(),
+                                     utilization,
+                                     [](const auto& point, double value) {
+                                         return point.first < value;
+                                     });
+
+        if (next == points_.begin()) {
+            return RoundPower(points_.front().second);
+        }
+        if (next == points_.end()) {
+            return RoundPower(points_.back().second);
+        }
+
+        auto prev = std::prev(next);
+        auto fraction =
+            (utilization - prev->first) / (next->first - prev->first);
+
+        return RoundPower(prev->second +
+                          (next->second - prev->second) * fraction);
+    }
+
+ private:
+    std::vector<std::pair<double, double>> points_;
+};
+
+}   // namespace sim::infra
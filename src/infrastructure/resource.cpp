@@ -33,7 +33,7 @@ sim::infra::IResource::PowerStateToString(PowerState state)
 void
 sim::infra::IResource::HandleEvent(const events::Event* event)
 {
-    auto resource_event = dynamic_cast<const ResourceEvent*>(event);
+    auto resource_event = events::EventCast<ResourceEvent>(event);
 
     if (!resource_event) {
         ACTOR_LOG_ERROR("Received invalid event");
@@ -189,11 +189,77 @@ sim::infra::IResource::SetEnergyPerTickConst(
     sim::EnergyCount energy_per_tick_const)
 {
     energy_per_tick_const_ = energy_per_tick_const;
+    UpdatePower();
+}
+
+sim::EnergyCount
+sim::infra::IResource::SpentPower() const
+{
+    return energy_meter_ ? energy_meter_->GetPower(meter_index_)
+                         : EnergyCount{};
+}
+
+sim::EnergyCount
+sim::infra::IResource::SpentEnergy() const
+{
+    return energy_meter_ ? energy_meter_->GetEnergy(meter_index_, now())
+                         : EnergyCount{};
+}
+
+void
+sim::infra::IResource::SetEnergyMeter(EnergyMeter* energy_meter,
+                                      uint32_t parent)
+{
+    energy_meter_ = energy_meter;
+    meter_index_ = energy_meter_->AddResource(parent);
+    power_ = EnergyCount{};
+    UpdatePower();
+}
+
+sim::EnergyCount
+sim::infra::IResource::ComputePower() const
+{
+    if (power_state_ == PowerState::kOff ||
+        power_state_ == PowerState::kFailure) {
+        return EnergyCount{};
+    }
+
+    return energy_per_tick_const_;
+}
+
+void
+sim::infra::IResource::UpdatePower() const
+{
+    if (!energy_meter_) {
+        return;
+    }
+
+    auto power = ComputePower();
+    if (power == power_) {
+        return;
+    }
+
+    auto delta = static_cast<int64_t>(power.get() - power_.get());
+    auto ts = now();
+    energy_meter_->AddPower(meter_index_, delta, ts);
+
+    SaveUndo([this, delta, ts, power = power_] {
+        energy_meter_->AddPower(meter_index_, -delta, ts);
+        power_ = power;
+    });
+    power_ = power;
 }
 
 void
 sim::infra::IResource::SetPowerState(PowerState new_state)
 {
+    Trace({.type = trace::RecordType::kPowerState,
+           .old_state = static_cast<uint8_t>(power_state_),
+           .new_state = static_cast<uint8_t>(new_state)});
+
+    SaveUndo([this, state = power_state_] { power_state_ = state; });
     power_state_ = new_state;
+    UpdatePower();
+    MarkChanged();
     ACTOR_LOG_INFO("State changed to {}", PowerStateToString(new_state));
 }
@@ -6,6 +6,7 @@
 #include <utility>
 
 #include "actor.h"
+#include "energy-meter.h"
 #include "event.h"
 #include "types.h"
 
@@ -23,16 +24,18 @@ enum class ResourceEventType
 
 struct ResourceEvent : events::Event
 {
+    static constexpr events::EventTag kTag = events::EventTag::kResource;
+    using TagOwner = ResourceEvent;
+
     ResourceEventType type{ResourceEventType::kNone};
 };
 
-typedef std::function<EnergyCount(UUID)> EnergyMeterFunction;
-
 /**
  * Abstract class for Resource (something physical, e.g. Server, DataCenter,
  * Switch, etc.) Each Resource:
  *
- * 1) should be able to return SpentPower() in abstract EnergyCount units
+ * 1) should be able to return SpentPower() in abstract EnergyCount units,
+ *    it is accounted by EnergyMeter
  * 2) is an Actor
  * 3) has PowerState (Off, TurningOn/Off, Running, Failure)
  * 4) inherits standard life cycle and ResourceEvent handling
@@ -42,17 +45,16 @@ typedef std::function<EnergyCount(UUID)> EnergyMeterFunction;
 class IResource : public events::IActor
 {
  public:
+    static constexpr events::ActorTag kTag = events::ActorTag::kResource;
+    using TagOwner = IResource;
+
     void HandleEvent(const events::Event* event) override;
 
-    virtual EnergyCount SpentPower() {
-        EnergyCount total{energy_per_tick_const_};
+    /// Power per tick of the resource and its components
+    EnergyCount SpentPower() const;
 
-        for (UUID component_handle : components_) {
-            total += energy_meter_function_(component_handle);
-        }
-
-        return total;
-    };
+    /// Energy spent by the resource and its components up to now
+    EnergyCount SpentEnergy() const;
 
     TimeInterval GetStartupDelay() const;
     void SetStartupDelay(TimeInterval startup_delay);
@@ -63,19 +65,26 @@ class IResource : public events::IActor
     EnergyCount GetEnergyPerTickConst() const;
     void SetEnergyPerTickConst(EnergyCount energy_per_tick_const);
 
-    void SetEnergyMeterFunction(EnergyMeterFunction energy_meter_function) {
-        energy_meter_function_ = std::move(energy_meter_function);
-    }
+    /// The meter should have the parent of the resource already
+    void SetEnergyMeter(EnergyMeter* energy_meter, uint32_t parent);
+
+    uint32_t GetMeterIndex() const { return meter_index_; }
 
     const auto& GetComponents() const { return components_; }
 
+    bool IsRunning() const { return power_state_ == PowerState::kRunning; }
+
     ~IResource() override = default;
 
  protected:
     /**
      * This class is abstract, constructor can be called only from derived
      */
-    explicit IResource(std::string type) : events::IActor(std::move(type)) {}
+    IResource(std::string type, events::ActorTag tag)
+        : events::IActor(std::move(type), tag)
+    {
+        AddBaseTag(kTag);
+    }
 
     /**
      * Set of IResources, which are components of this IResource (e.g.,
@@ -100,6 +109,13 @@ class IResource : public events::IActor
 
     void SetPowerState(PowerState new_state);
 
+    /// Own power of the resource without components in the current state
+    virtual EnergyCount ComputePower() const;
+
+    /// Tells the meter the new power, should be called when the result of
+    /// ComputePower() may have changed
+    void UpdatePower() const;
+
     PowerState power_state_{PowerState::kOff};
 
     // event handlers
@@ -113,7 +129,12 @@ class IResource : public events::IActor
     TimeInterval startup_delay_{}, reboot_delay_{}, shutdown_delay_{};
 
     EnergyCount energy_per_tick_const_{};
-    EnergyMeterFunction energy_meter_function_;
+
+    EnergyMeter* energy_meter_{};
+    uint32_t meter_index_{};
+
+    /// Power last told to the meter
+    mutable EnergyCount power_{};
 };
 
 }   // namespace sim::infra
@@ -1,6 +1,6 @@
 #include "server.h"
 
-#include <typeinfo>
+#include <algorithm>
 
 #include "event.h"
 #include "logger.h"
@@ -9,7 +9,7 @@
 void
 sim::infra::Server::HandleEvent(const events::Event* event)
 {
-    auto server_event = dynamic_cast<const ServerEvent*>(event);
+    auto server_event = events::EventCast<ServerEvent>(event);
 
     if (!server_event) {
         IResource::HandleEvent(event);
@@ -39,17 +39,29 @@ sim::infra::Server::ProvisionVM(const ServerEvent* server_event)
     if (power_state_ != PowerState::kRunning) {
         ACTOR_LOG_ERROR(
             "ProvisionVM event received, but server is not in Running state");
+        SaveUndo([this, state = power_state_] { power_state_ = state; });
         power_state_ = PowerState::kFailure;
+        UpdatePower();
+        MarkChanged();
+        DropNotificator(server_event);
         return;
     }
 
     if (!server_event->vm_uuid) {
         ACTOR_LOG_ERROR("ProvisionVM event without virtual_machine attached");
+        DropNotificator(server_event);
         return;
     }
 
-    virtual_machines_.insert(server_event->vm_uuid);
+    if (virtual_machines_.insert(server_event->vm_uuid).second) {
+        SaveUndo([this, vm_uuid = server_event->vm_uuid] {
+            virtual_machines_.erase(vm_uuid);
+        });
+    }
+    UpdatePower();
+    MarkChanged();
     ACTOR_LOG_INFO("VM {} is hosted here", server_event->vm_uuid);
+    TraceWorkload(trace::RecordType::kVMProvisioned, server_event->vm_uuid);
 
     auto vm_provisioned_event = events::MakeInheritedEvent<VMEvent>(
         server_event->vm_uuid, server_event, TimeInterval{0});
@@ -67,20 +79,79 @@ sim::infra::Server::UnprovisionVM(const ServerEvent* server_event)
     if (power_state_ != PowerState::kRunning) {
         ACTOR_LOG_ERROR(
             "UnprovisionVM event received, but server is not in Running state");
+        SaveUndo([this, state = power_state_] { power_state_ = state; });
         power_state_ = PowerState::kFailure;
+        UpdatePower();
+        MarkChanged();
+        DropNotificator(server_event);
         return;
     }
 
     if (!virtual_machines_.count(server_event->vm_uuid)) {
         ACTOR_LOG_ERROR("VM {} is ot hosted on this server",
                         server_event->vm_uuid);
+        DropNotificator(server_event);
         return;
     }
 
+    SaveUndo([this, vm_uuid = server_event->vm_uuid] {
+        virtual_machines_.insert(vm_uuid);
+    });
     virtual_machines_.erase(server_event->vm_uuid);
+    UpdatePower();
+    MarkChanged();
     ACTOR_LOG_INFO("VM {} removed from this server", server_event->vm_uuid);
+    TraceWorkload(trace::RecordType::kVMUnprovisioned, server_event->vm_uuid);
+
+    if (auto event = server_event->notificator) {
+        event->happen_time = server_event->happen_time;
+        schedule_event(event, false);
+    }
+}
+
+void
+sim::infra::Server::TraceWorkload(trace::RecordType type, UUID vm_uuid) const
+{
+    Trace({.subject = vm_uuid,
+           .type = type,
+           .ram = server_workload_.required_ram.get(),
+           .cpu = server_workload_.cpu_utilization.get(),
+           .io_bandwidth = server_workload_.io_bandwidth.get()});
+}
+
+void
+sim::infra::Server::SetWorkload(Workload workload) const
+{
+    if (workload.required_ram == server_workload_.required_ram &&
+        workload.cpu_utilization.get() ==
+            server_workload_.cpu_utilization.get() &&
+        workload.io_bandwidth.get() == server_workload_.io_bandwidth.get()) {
+        return;
+    }
+
+    server_workload_ = workload;
+    UpdatePower();
+    TraceWorkload(trace::RecordType::kServerWorkload);
+}
+
+double
+sim::infra::Server::GetUtilization() const
+{
+    if (!spec_.cores_count) {
+        return 0;
+    }
+
+    return std::min(1.0, server_workload_.cpu_utilization.get() /
+                             (100.0 * spec_.cores_count));
+}
+
+sim::EnergyCount
+sim::infra::Server::ComputePower() const
+{
+    if (!spec_.power_model || power_state_ == PowerState::kOff ||
+        power_state_ == PowerState::kFailure) {
+        return IResource::ComputePower();
+    }
 
-    auto event = server_event->notificator;
-    event->happen_time = server_event->happen_time;
-    schedule_event(event, false);
+    return spec_.power_model->GetPower(GetUtilization());
 }
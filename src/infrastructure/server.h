@@ -1,9 +1,11 @@
 #pragma once
 
-#include <unordered_set>
+#include <memory>
+#include <set>
 
 #include "actor.h"
 #include "event.h"
+#include "power-model.h"
 #include "resource.h"
 #include "types.h"
 #include "vm-storage.h"
@@ -20,6 +22,9 @@ enum class ServerEventType
 
 struct ServerEvent : events::Event
 {
+    static constexpr events::EventTag kTag = events::EventTag::kServer;
+    using TagOwner = ServerEvent;
+
     ServerEventType type{ServerEventType::kNone};
     UUID vm_uuid;
 };
@@ -29,31 +34,52 @@ struct ServerSpec
     RAMBytes ram{};
     uint32_t cores_count{};
     IOBandwidthMBpS io_bandwidth{};
+
+    /// Power of the running server by utilization, servers without it draw
+    /// the constant power of a resource
+    std::shared_ptr<const IPowerModel> power_model;
 };
 
 class Server : public IResource
 {
  public:
-    Server() : IResource("Server") {}
+    Server() : IResource("Server", kTag) {}
+
+    static constexpr events::ActorTag kTag = events::ActorTag::kServer;
+    using TagOwner = Server;
 
     void HandleEvent(const events::Event* event) override;
 
     // for scheduler
     const auto& GetVMs() const { return virtual_machines_; }
 
-    void SetSpec(ServerSpec spec) { spec_ = spec; }
+    void SetSpec(ServerSpec spec)
+    {
+        spec_ = std::move(spec);
+        UpdatePower();
+    }
 
     auto GetSpec() const { return spec_; }
 
-    void SetWorkload(Workload workload) const { server_workload_ = workload; }
+    /// Total workload of hosted VM-s, set by the server scheduler
+    void SetWorkload(Workload workload) const;
+
+    /// CPU utilization by the workload in [0, 1], a VM requiring 100% takes
+    /// one core
+    double GetUtilization() const;
+
+ protected:
+    EnergyCount ComputePower() const override;
 
  private:
     ServerSpec spec_{};
 
     mutable Workload server_workload_{};
 
-    // consumers of Server as a resource
-    std::unordered_set<UUID> virtual_machines_{};
+    // consumers of Server as a resource, ordered as VMStorage::vms_
+    std::set<UUID> virtual_machines_{};
+
+    void TraceWorkload(trace::RecordType type, UUID vm_uuid = UUID{}) const;
 
     // event handlers
     void ProvisionVM(const ServerEvent* server_event);
@@ -10,10 +10,10 @@ sim::infra::VMStorage::HandleEvent(const sim::events::Event* event)
         return;
     }
 
-    auto vms_event = dynamic_cast<const VMStorageEvent*>(event);
+    auto vms_event = events::EventCast<VMStorageEvent>(event);
     if (!vms_event) {
         ACTOR_LOG_ERROR("Received invalid event");
-        state_ = VMStorageState::kFailure;
+        SetState(VMStorageState::kFailure);
         return;
     }
 
@@ -38,19 +38,23 @@ sim::infra::VMStorage::HandleEvent(const sim::events::Event* event)
             break;
         default:
             ACTOR_LOG_ERROR("Received event with invalid type");
-            state_ = VMStorageState::kFailure;
+            SetState(VMStorageState::kFailure);
     }
+
+    // every handled event changes the list of VM-s
+    MarkChanged();
 }
 
 void
 sim::infra::VMStorage::AddVM(const sim::infra::VMStorageEvent* event)
 {
     if (auto it = vms_.find(event->vm_uuid); it == vms_.end()) {
+        SaveUndo([this, uuid = event->vm_uuid] { vms_.erase(uuid); });
         vms_[event->vm_uuid] = VMStatus::kCreated;
         ACTOR_LOG_INFO("VM {} was created", event->vm_uuid);
     } else {
         ACTOR_LOG_ERROR("VM {} is already in VM-s list", event->vm_uuid);
-        state_ = VMStorageState::kFailure;
+        SetState(VMStorageState::kFailure);
     }
 }
 
@@ -61,13 +65,13 @@ sim::infra::VMStorage::MoveToPending(const sim::infra::VMStorageEvent* event)
         if (it->second == VMStatus::kCreated ||
             it->second == VMStatus::kStoppedVM) {
             ACTOR_LOG_INFO("VM {} is pending scheduling now", event->vm_uuid);
-            it->second = VMStatus::kPending;
+            SetVMStatus(it, VMStatus::kPending);
         } else {
             ACTOR_LOG_ERROR("Cannot move VM {} to pending", event->vm_uuid);
         }
     } else {
         ACTOR_LOG_ERROR("VM {} not found in VM-s list", event->vm_uuid);
-        state_ = VMStorageState::kFailure;
+        SetState(VMStorageState::kFailure);
     }
 }
 
@@ -76,10 +80,10 @@ sim::infra::VMStorage::MoveToProvisioning(const VMStorageEvent* event)
 {
     if (auto it = vms_.find(event->vm_uuid); it != vms_.end()) {
         ACTOR_LOG_INFO("VM {} is provisioning now", event->vm_uuid);
-        it->second = VMStatus::kProvisioning;
+        SetVMStatus(it, VMStatus::kProvisioning);
     } else {
         ACTOR_LOG_ERROR("VM {} not found in VM-s list", event->vm_uuid);
-        state_ = VMStorageState::kFailure;
+        SetState(VMStorageState::kFailure);
     }
 }
 
@@ -89,13 +93,13 @@ sim::infra::VMStorage::MoveToStopped(const VMStorageEvent* event)
     if (auto it = vms_.find(event->vm_uuid); it != vms_.end()) {
         if (it->second != VMStatus::kStoppedVM) {
             ACTOR_LOG_INFO("VM {} is stopped", event->vm_uuid);
-            it->second = VMStatus::kStoppedVM;
+            SetVMStatus(it, VMStatus::kStoppedVM);
         } else {
             ACTOR_LOG_ERROR("VM {} is already stopped", event->vm_uuid);
         }
     } else {
         ACTOR_LOG_ERROR("VM {} not found in VM-s list", event->vm_uuid);
-        state_ = VMStorageState::kFailure;
+        SetState(VMStorageState::kFailure);
     }
 }
 
@@ -105,13 +109,13 @@ sim::infra::VMStorage::MoveToHosted(const VMStorageEvent* event)
     if (auto it = vms_.find(event->vm_uuid); it != vms_.end()) {
         if (it->second != VMStatus::kHostedVM) {
             ACTOR_LOG_INFO("VM {} is hosted on a server", event->vm_uuid);
-            it->second = VMStatus::kHostedVM;
+            SetVMStatus(it, VMStatus::kHostedVM);
         } else {
             ACTOR_LOG_ERROR("VM {} is already hosted", event->vm_uuid);
         }
     } else {
         ACTOR_LOG_ERROR("VM {} not found in VM-s list", event->vm_uuid);
-        state_ = VMStorageState::kFailure;
+        SetState(VMStorageState::kFailure);
     }
 }
 
@@ -119,10 +123,35 @@ void
 sim::infra::VMStorage::DeleteVM(const VMStorageEvent* event)
 {
     if (auto it = vms_.find(event->vm_uuid); it != vms_.end()) {
+        SaveUndo([this, uuid = it->first, status = it->second] {
+            vms_.emplace(uuid, status);
+        });
         vms_.erase(it);
         ACTOR_LOG_INFO("VM {} is deleted", event->vm_uuid);
+
+        if (remove_actor) {
+            remove_actor(event->vm_uuid);
+        }
     } else {
         ACTOR_LOG_ERROR("VM {} not found in VM-s list", event->vm_uuid);
-        state_ = VMStorageState::kFailure;
+        SetState(VMStorageState::kFailure);
     }
 }
+
+void
+sim::infra::VMStorage::SetState(VMStorageState new_state)
+{
+    SaveUndo([this, state = state_] { state_ = state; });
+    state_ = new_state;
+}
+
+void
+sim::infra::VMStorage::SetVMStatus(std::map<UUID, VMStatus>::iterator it,
+                                   VMStatus status)
+{
+    // the VM may be erased and restored later, so it is found by UUID
+    SaveUndo([this, uuid = it->first, old_status = it->second] {
+        vms_[uuid] = old_status;
+    });
+    it->second = status;
+}
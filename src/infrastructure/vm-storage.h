@@ -1,7 +1,7 @@
 #pragma once
 
-#include <unordered_map>
-#include <unordered_set>
+#include <functional>
+#include <map>
 
 #include "actor.h"
 #include "types.h"
@@ -30,8 +30,13 @@ enum class VMStatus
                     // yet
 };
 
+typedef std::function<void(UUID)> RemoveActorFunction;
+
 struct VMStorageEvent : events::Event
 {
+    static constexpr events::EventTag kTag = events::EventTag::kVMStorage;
+    using TagOwner = VMStorageEvent;
+
     VMStorageEventType type{VMStorageEventType::kNone};
     UUID vm_uuid{};
 };
@@ -44,15 +49,27 @@ struct VMStorageEvent : events::Event
 class VMStorage : public events::IActor
 {
  public:
-    VMStorage() : events::IActor("VM-Storage") {}
+    VMStorage() : events::IActor("VM-Storage", kTag) {}
+
+    static constexpr events::ActorTag kTag = events::ActorTag::kVMStorage;
+    using TagOwner = VMStorage;
 
     void HandleEvent(const events::Event* event) override;
 
     // For scheduler
     const auto& GetVMs() const { return vms_; }
 
+    /// Deleted VMs are removed from the world using this callback
+    void SetRemoveActorFunction(RemoveActorFunction remove_actor_function)
+    {
+        remove_actor = std::move(remove_actor_function);
+    }
+
  private:
-    std::unordered_map<UUID, VMStatus> vms_;
+    /// Ordered, so the order of VM-s does not depend on the history of changes
+    std::map<UUID, VMStatus> vms_;
+
+    RemoveActorFunction remove_actor;
 
     enum class VMStorageState
     {
@@ -62,6 +79,9 @@ class VMStorage : public events::IActor
 
     VMStorageState state_{VMStorageState::kOk};
 
+    void SetState(VMStorageState new_state);
+    void SetVMStatus(std::map<UUID, VMStatus>::iterator it, VMStatus status);
+
     // event handlers
     void AddVM(const VMStorageEvent* event);
     void MoveToPending(const VMStorageEvent* event);
@@ -1,5 +1,7 @@
 #include "vm.h"
 
+#include <algorithm>
+
 #include "server.h"
 
 static const char*
@@ -37,7 +39,7 @@ StateToString(sim::infra::VMState state)
 void
 sim::infra::VM::HandleEvent(const Event* event)
 {
-    auto vm_event = dynamic_cast<const VMEvent*>(event);
+    auto vm_event = events::EventCast<VMEvent>(event);
 
     if (!vm_event) {
         ACTOR_LOG_ERROR("Received invalid event");
@@ -80,6 +82,11 @@ sim::infra::VM::HandleEvent(const Event* event)
 void
 sim::infra::VM::Start(const VMEvent* vm_event)
 {
+    // the server hosts the VM even if it fails to start, so the VM should
+    // be unprovisioned from it when deleted
+    SaveUndo([this, owner = owner_] { owner_ = owner; });
+    owner_ = vm_event->server_uuid;
+
     FAIL_ON_STATE_MISMATCH({VMState::kProvisioning})
 
     SetState(VMState::kStarting);
@@ -149,13 +156,20 @@ sim::infra::VM::CompleteStop(const VMEvent* vm_event)
 
     SetState(VMState::kStopped);
 
+    // VM-Storage is notified when the server is free
+    auto vmst_callback = events::MakeEvent<VMStorageEvent>(
+        vm_storage_handle_, vm_event->happen_time, nullptr);
+    vmst_callback->vm_uuid = GetUUID();
+    vmst_callback->type = VMStorageEventType::kVMStopped;
+
     auto free_server_event =
-        MakeInheritedEvent<ServerEvent>(owner_, vm_event, TimeInterval{0});
+        MakeEvent<ServerEvent>(owner_, vm_event->happen_time, vmst_callback);
     free_server_event->type = ServerEventType::kUnprovisionVM;
     free_server_event->vm_uuid = GetUUID();
 
     schedule_event(free_server_event, false);
 
+    SaveUndo([this, owner = owner_] { owner_ = owner; });
     owner_ = UUID{};
 }
 
@@ -179,19 +193,20 @@ sim::infra::VM::CompleteDelete(const VMEvent* vm_event)
 {
     FAIL_ON_STATE_MISMATCH({VMState::kDeleting})
 
+    // VM-Storage removes the VM, so the server should release it first
+    auto vmst_callback = events::MakeEvent<VMStorageEvent>(
+        vm_storage_handle_, vm_event->happen_time, nullptr);
+    vmst_callback->vm_uuid = GetUUID();
+    vmst_callback->type = VMStorageEventType::kVMDeleted;
+
     if (owner_) {
         auto free_server_event = MakeEvent<ServerEvent>(
-            owner_, vm_event->happen_time, vm_event->notificator);
+            owner_, vm_event->happen_time, vmst_callback);
         free_server_event->type = ServerEventType::kUnprovisionVM;
         free_server_event->vm_uuid = GetUUID();
 
         schedule_event(free_server_event, false);
     } else {
-        auto vmst_callback = events::MakeEvent<VMStorageEvent>(
-            vm_storage_handle_, vm_event->happen_time, nullptr);
-        vmst_callback->vm_uuid = GetUUID();
-        vmst_callback->type = VMStorageEventType::kVMDeleted;
-
         schedule_event(vmst_callback, false);
     }
 }
@@ -247,7 +262,13 @@ sim::infra::VM::SetDeleteDelay(TimeInterval delete_delay)
 void
 sim::infra::VM::SetState(sim::infra::VMState new_state)
 {
+    Trace({.type = trace::RecordType::kVMState,
+           .old_state = static_cast<uint8_t>(state_),
+           .new_state = static_cast<uint8_t>(new_state)});
+
+    SaveUndo([this, state = state_] { state_ = state; });
     state_ = new_state;
+    MarkChanged();
     ACTOR_LOG_INFO("State changed to {}", StateToString(new_state));
 }
 
@@ -257,3 +278,54 @@ sim::infra::VM::CheckStateMatch(std::initializer_list<VMState> allowed_states)
     return std::any_of(allowed_states.begin(), allowed_states.end(),
                        [this](VMState state) { return state == state_; });
 }
+
+const sim::infra::WorkloadBatch&
+sim::infra::WorkloadBatcher::Evaluate(std::span<const VM* const> vms,
+                                      TimeStamp time)
+{
+    for (auto& group : groups_) {
+        group.models.clear();
+        group.positions.clear();
+    }
+
+    // there are few types of models, so groups are searched linearly
+    for (uint32_t i = 0; i < vms.size(); ++i) {
+        auto* model = vms[i]->GetWorkloadModel();
+        std::type_index type = typeid(*model);
+
+        auto it = std::find_if(
+            groups_.begin(), groups_.end(),
+            [&type](const Group& group) { return group.type == type; });
+        if (it == groups_.end()) {
+            it = groups_.insert(groups_.end(), Group{type, {}, {}});
+        }
+        it->models.push_back(model);
+        it->positions.push_back(i);
+    }
+
+    result_.Resize(vms.size());
+    for (auto& group : groups_) {
+        if (group.models.empty()) {
+            continue;
+        }
+
+        // VM-s of one type of models are written in place
+        if (group.models.size() == vms.size()) {
+            group.models.front()->GetWorkloads(group.models, time, result_);
+            break;
+        }
+
+        group_result_.Resize(group.models.size());
+        group.models.front()->GetWorkloads(group.models, time, group_result_);
+        for (size_t i = 0; i < group.positions.size(); ++i) {
+            result_.required_ram[group.positions[i]] =
+                group_result_.required_ram[i];
+            result_.cpu_utilization[group.positions[i]] =
+                group_result_.cpu_utilization[i];
+            result_.io_bandwidth[group.positions[i]] =
+                group_result_.io_bandwidth[i];
+        }
+    }
+
+    return result_;
+}
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <span>
+#include <typeindex>
+#include <vector>
+
 #include "actor.h"
+#include "random.h"
 
 namespace sim::infra {
 
@@ -21,6 +26,9 @@ enum class VMEventType
 
 struct VMEvent : events::Event
 {
+    static constexpr events::EventTag kTag = events::EventTag::kVM;
+    using TagOwner = VMEvent;
+
     VMEventType type{VMEventType::kNone};
 
     UUID server_uuid;
@@ -50,6 +58,36 @@ struct Workload
     IOBandwidthMBpS io_bandwidth{};
 };
 
+/// Workloads of several VM-s as structure of arrays
+struct WorkloadBatch
+{
+    std::vector<uint64_t> required_ram;
+    std::vector<uint32_t> cpu_utilization, io_bandwidth;
+
+    size_t Size() const { return required_ram.size(); }
+
+    void Resize(size_t size)
+    {
+        required_ram.resize(size);
+        cpu_utilization.resize(size);
+        io_bandwidth.resize(size);
+    }
+
+    Workload Get(size_t index) const
+    {
+        return {RAMBytes{required_ram[index]},
+                CPUUtilizationPercent{cpu_utilization[index]},
+                IOBandwidthMBpS{io_bandwidth[index]}};
+    }
+
+    void Set(size_t index, const Workload& workload)
+    {
+        required_ram[index] = workload.required_ram.get();
+        cpu_utilization[index] = workload.cpu_utilization.get();
+        io_bandwidth[index] = workload.io_bandwidth.get();
+    }
+};
+
 /**
  * Stateful object which calculates required amount of resources on each tick.
  * Should be implemented by a researcher
@@ -64,6 +102,31 @@ class IVMWorkloadModel
     /// This function is called on each tick
     virtual Workload GetWorkload(TimeStamp time) = 0;
 
+    /**
+     * Computes workloads of the models into the first models.size() entries
+     * of the batch. The models are of the same type as this one, so an
+     * override may read their parameters into arrays and compute all
+     * workloads in one loop instead of a virtual call per VM
+     */
+    virtual void GetWorkloads(std::span<IVMWorkloadModel* const> models,
+                              TimeStamp time, WorkloadBatch& batch)
+    {
+        for (size_t i = 0; i < models.size(); ++i) {
+            batch.Set(i, models[i]->GetWorkload(time));
+        }
+    }
+
+    /**
+     * The earliest time after the given one when the workload may differ
+     * from the one at the given time, 0 if it does not change anymore.
+     * Server schedulers wake up at this time to update the workloads
+     */
+    virtual TimeStamp GetNextChange(TimeStamp) const { return 0; }
+
+    /// Random models should draw their workload from this stream only, so
+    /// results are reproducible for the simulation seed
+    virtual void SetRandomStream(RandomStream) {}
+
     const auto& Params() { return params_; }
 
     virtual ~IVMWorkloadModel() = default;
@@ -83,10 +146,15 @@ class IVMWorkloadModel
 class VM : public events::IActor
 {
  public:
-    VM() : events::IActor("VM") {}
+    VM() : events::IActor("VM", kTag) {}
+
+    static constexpr events::ActorTag kTag = events::ActorTag::kVM;
+    using TagOwner = VM;
 
     void HandleEvent(const events::Event* event) override;
 
+    VMState GetState() const { return state_; }
+
     TimeInterval GetStartDelay() const;
     void SetStartDelay(TimeInterval start_delay);
     TimeInterval GetRestartDelay() const;
@@ -98,6 +166,11 @@ class VM : public events::IActor
 
     auto GetWorkload() const { return workload_model_->GetWorkload(now()); }
 
+    IVMWorkloadModel* GetWorkloadModel() const
+    {
+        return workload_model_.get();
+    }
+
     void SetWorkloadModel(IVMWorkloadModel* workload_model)
     {
         workload_model_ = std::shared_ptr<IVMWorkloadModel>{workload_model};
@@ -132,4 +205,29 @@ class VM : public events::IActor
     void CompleteDelete(const VMEvent* vm_event);
 };
 
+/**
+ * Computes workloads of many VM-s with one GetWorkloads call per type of
+ * workload models. Keeps its buffers between calls, so it is cheap to reuse
+ */
+class WorkloadBatcher
+{
+ public:
+    /// Workloads of the VM-s at the given time in the order of VM-s
+    const WorkloadBatch& Evaluate(std::span<const VM* const> vms,
+                                  TimeStamp time);
+
+ private:
+    struct Group
+    {
+        std::type_index type;
+        std::vector<IVMWorkloadModel*> models;
+
+        /// Positions of the VM-s of the models in the input
+        std::vector<uint32_t> positions;
+    };
+
+    std::vector<Group> groups_;
+    WorkloadBatch result_, group_result_;
+};
+
 }   // namespace sim::infra
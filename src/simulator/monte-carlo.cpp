@@ -0,0 +1,365 @@
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <argparse.hpp>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+#include "logger.h"
+#include "thread-pool.h"
+#include "trace-writer.h"
+#include "world.h"
+
+/**
+ * Runs the same scenario many times with different seeds and reports summary
+ * statistics of the outcomes. Replications are independent worlds simulated
+ * in parallel, each one with own logger and trace writer.
+ *
+ * A replication creates VM-s with random uniform workloads, arriving as a
+ * poisson process, provisions them on the next tick, stops them after
+ * exponential lifetime and deletes them.
+ */
+
+namespace {
+
+using namespace sim;
+
+struct Options
+{
+    uint32_t replications, vms;
+    double arrival_rate, vm_lifetime;
+    uint64_t seed;
+};
+
+enum class ActionType
+{
+    kCreate,
+    kProvision,
+    kStop,
+    kDelete,
+};
+
+/// Actions of one time go in the order of the life cycle
+struct Action
+{
+    TimeStamp time;
+    ActionType type;
+    uint32_t vm;
+
+    auto operator<=>(const Action&) const = default;
+};
+
+/// Outcome of one replication
+struct Sample
+{
+    double energy, placement_failures, mean_wait_time;
+};
+
+/**
+ * Logger and trace writer of the replication simulated by the calling thread
+ */
+class ThreadContext
+{
+ public:
+    ThreadContext()
+    {
+        SimulatorLogger::SetThreadLogger(&logger_);
+        trace::TraceWriter::SetThreadWriter(&writer_);
+    }
+
+    ~ThreadContext()
+    {
+        SimulatorLogger::SetThreadLogger(nullptr);
+        trace::TraceWriter::SetThreadWriter(nullptr);
+    }
+
+ private:
+    SimulatorLogger logger_;
+    trace::TraceWriter writer_;
+};
+
+std::shared_ptr<core::SimulatorConfig>
+MakeConfig(const argparse::ArgumentParser& parser)
+{
+    auto config = std::make_shared<core::SimulatorConfig>();
+
+    config->SetEventQueueType(parser.get<std::string>("--event-queue"));
+    config->SetCloudScheduler(parser.get<std::string>("--cloud-scheduler"));
+    config->SetMaxLogSeverity(LogSeverity::kError);
+
+    if (auto path = parser.get<std::string>("--config"); !path.empty()) {
+        config->SetConfigPath(path);
+        return config;
+    }
+
+    config->AddServerSpec(
+        "server", {RAMBytes{64}, 32, IOBandwidthMBpS{4000},
+                   std::make_shared<infra::LinearPowerModel>(100, 250)});
+
+    auto data_centers =
+        std::stoul(parser.get<std::string>("--data-centers"));
+    auto servers = static_cast<uint32_t>(
+        std::stoul(parser.get<std::string>("--servers")));
+    for (uint32_t i = 1; i <= data_centers; ++i) {
+        config->AddDataCenter(
+            {"dc-" + std::to_string(i), {{"server", servers, "greedy"}}});
+    }
+
+    return config;
+}
+
+Sample
+RunReplication(const Options& options,
+               std::shared_ptr<core::SimulatorConfig> config,
+               uint32_t replication)
+{
+    ThreadContext context;
+
+    auto seed = options.seed + replication;
+    config->SetSeed(seed);
+
+    core::World world{std::move(config)};
+    world.Setup();
+    world.DoResourceAction("cloud-1", infra::ResourceEventType::kBoot);
+
+    std::mt19937_64 generator{seed};
+    std::exponential_distribution<double> interval{options.arrival_rate};
+    std::exponential_distribution<double> lifetime{1 / options.vm_lifetime};
+
+    std::vector<Action> actions;
+    double time = 1;
+    for (uint32_t vm = 0; vm < options.vms; ++vm) {
+        time += interval(generator);
+        auto create_time = static_cast<TimeStamp>(time);
+        auto stop_time = create_time + 2 +
+                         static_cast<TimeStamp>(lifetime(generator));
+
+        actions.push_back({create_time, ActionType::kCreate, vm});
+        actions.push_back({create_time + 1, ActionType::kProvision, vm});
+        actions.push_back({stop_time, ActionType::kStop, vm});
+        actions.push_back({stop_time + 1, ActionType::kDelete, vm});
+    }
+    std::sort(actions.begin(), actions.end());
+
+    for (const auto& action : actions) {
+        if (action.time > world.Now()) {
+            world.SimulateUntil(action.time - 1);
+        }
+
+        auto vm_name = "vm-" + std::to_string(action.vm);
+        switch (action.type) {
+            case ActionType::kCreate: {
+                world.CreateVM(vm_name, "random-uniform",
+                               {{"required_ram", "8"},
+                                {"required_cpu", "20"},
+                                {"required_bandwidth", "100"}});
+                break;
+            }
+            case ActionType::kProvision: {
+                world.DoProvisionVM(vm_name);
+                break;
+            }
+            case ActionType::kStop: {
+                world.DoStopVM(vm_name);
+                break;
+            }
+            case ActionType::kDelete: {
+                world.DoDeleteVM(vm_name);
+                break;
+            }
+        }
+    }
+    world.SimulateAll();
+
+    auto metrics = world.GetMetrics();
+    return {
+        .energy = static_cast<double>(metrics.energy.get()),
+        .placement_failures =
+            static_cast<double>(metrics.vms_requested - metrics.vms_started),
+        .mean_wait_time =
+            metrics.vms_started ? static_cast<double>(metrics.total_wait_time) /
+                                      metrics.vms_started
+                                : 0.0,
+    };
+}
+
+/// Prints mean, standard deviation, 95% confidence interval of the mean
+void
+PrintSummary(std::string_view name, const std::vector<double>& values)
+{
+    double mean = 0;
+    for (auto value : values) {
+        mean += value;
+    }
+    mean /= values.size();
+
+    double variance = 0;
+    for (auto value : values) {
+        variance += (value - mean) * (value - mean);
+    }
+    auto deviation =
+        values.size() > 1 ? std::sqrt(variance / (values.size() - 1)) : 0.0;
+    auto half_width = 1.96 * deviation / std::sqrt(values.size());
+
+    auto [min, max] = std::minmax_element(values.begin(), values.end());
+
+    fmt::print("{:<20} {:>12.3f} {:>12.3f} {:>12.3f} {:>12.3f} {:>12.3f} "
+               "{:>12.3f}\n",
+               name, mean, deviation, mean - half_width, mean + half_width,
+               *min, *max);
+}
+
+}   // namespace
+
+int
+main(int argc, char** argv)
+{
+    argparse::ArgumentParser parser("monte-carlo");
+
+    parser.add_argument("--replications")
+        .help("Count of simulations of the scenario")
+        .nargs(1)
+        .default_value(std::string{"100"});
+
+    parser.add_argument("--threads")
+        .help("Number of replications simulated in parallel, 0 - all cores")
+        .nargs(1)
+        .default_value(std::string{"0"});
+
+    parser.add_argument("--seed")
+        .help("Seed of the first replication, the next ones are increased")
+        .nargs(1)
+        .default_value(std::string{"42"});
+
+    parser.add_argument("--config")
+        .help("Path to directory with configuration files, a synthetic cloud "
+              "is simulated without it")
+        .nargs(1)
+        .default_value(std::string{});
+
+    parser.add_argument("--data-centers")
+        .help("Count of data centers of the synthetic cloud")
+        .nargs(1)
+        .default_value(std::string{"2"});
+
+    parser.add_argument("--servers")
+        .help("Count of servers in each data center of the synthetic cloud")
+        .nargs(1)
+        .default_value(std::string{"10"});
+
+    parser.add_argument("--vms")
+        .help("Count of VM-s in a replication")
+        .nargs(1)
+        .default_value(std::string{"1000"});
+
+    parser.add_argument("--arrival-rate")
+        .help("Mean count of new VMs per tick")
+        .nargs(1)
+        .default_value(std::string{"1"});
+
+    parser.add_argument("--vm-lifetime")
+        .help("Mean count of ticks between provision and stop of a VM")
+        .nargs(1)
+        .default_value(std::string{"100"});
+
+    parser.add_argument("--event-queue")
+        .help("Event queue implementation: \"calendar\" or \"map\"")
+        .nargs(1)
+        .default_value(std::string{"calendar"});
+
+    parser.add_argument("--cloud-scheduler")
+        .help("Cloud scheduler: \"greedy\", \"best-fit\" or \"worst-fit\"")
+        .nargs(1)
+        .default_value(std::string{"best-fit"});
+
+    parser.add_argument("--logs-folder")
+        .help("Path to the folder where to write logs of replications")
+        .nargs(1)
+        .default_value(std::string{"."});
+
+    parser.add_argument("--csv")
+        .help("Path to the file where to write metrics of each replication")
+        .nargs(1)
+        .default_value(std::string{});
+
+    try {
+        parser.parse_args(argc, argv);
+
+        Options options{
+            .replications = static_cast<uint32_t>(
+                std::stoul(parser.get<std::string>("--replications"))),
+            .vms = static_cast<uint32_t>(
+                std::stoul(parser.get<std::string>("--vms"))),
+            .arrival_rate =
+                std::stod(parser.get<std::string>("--arrival-rate")),
+            .vm_lifetime =
+                std::stod(parser.get<std::string>("--vm-lifetime")),
+            .seed = std::stoull(parser.get<std::string>("--seed")),
+        };
+        if (options.replications == 0) {
+            throw std::runtime_error("Replications count should be positive");
+        }
+
+        auto threads = std::stoul(parser.get<std::string>("--threads"));
+        if (threads == 0) {
+            threads = std::max(std::thread::hardware_concurrency(), 1U);
+        }
+
+        auto base_config = MakeConfig(parser);
+        auto logs_folder = parser.get<std::string>("--logs-folder");
+
+        std::vector<Sample> samples(options.replications);
+
+        WorkStealingPool pool{threads};
+        pool.ParallelFor(options.replications, [&](size_t i, size_t) {
+            // log files are named by the start time, so each replication
+            // writes to own folder
+            auto logs_path =
+                logs_folder + "/replication-" + std::to_string(i);
+            std::filesystem::create_directories(logs_path);
+
+            auto config =
+                std::make_shared<core::SimulatorConfig>(*base_config);
+            config->SetLogsPath(logs_path);
+
+            samples[i] = RunReplication(options, std::move(config), i);
+        });
+
+        if (auto path = parser.get<std::string>("--csv"); !path.empty()) {
+            std::ofstream csv{path};
+            csv << "replication,energy,placement_failures,mean_wait_time\n";
+            for (size_t i = 0; i < samples.size(); ++i) {
+                csv << fmt::format("{},{},{},{}\n", i, samples[i].energy,
+                                   samples[i].placement_failures,
+                                   samples[i].mean_wait_time);
+            }
+        }
+
+        auto column = [&samples](double Sample::*field) {
+            std::vector<double> values;
+            for (const auto& sample : samples) {
+                values.push_back(sample.*field);
+            }
+            return values;
+        };
+
+        fmt::print("replications: {}\n", samples.size());
+        fmt::print("{:<20} {:>12} {:>12} {:>12} {:>12} {:>12} {:>12}\n",
+                   "metric", "mean", "stddev", "95% CI low", "95% CI high",
+                   "min", "max");
+        PrintSummary("energy", column(&Sample::energy));
+        PrintSummary("placement failures", column(&Sample::placement_failures));
+        PrintSummary("mean VM wait time", column(&Sample::mean_wait_time));
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
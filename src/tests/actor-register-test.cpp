@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include "actor-register.h"
+#include "cloud.h"
+#include "server.h"
+#include "vm.h"
+
+namespace {
+
+using namespace sim;
+using namespace sim::events;
+
+class ActorRegisterTest : public testing::Test
+{
+ protected:
+    void SetUp() override
+    {
+        auto& logger = SimulatorLogger::GetLogger();
+        logger.SetMaxConsoleSeverity(LogSeverity::kError);
+        logger.SetMaxCSVSeverity(LogSeverity::kError);
+        logger.SetTimeCallback([] { return TimeStamp{0}; });
+    }
+
+    ActorRegister actor_register_;
+};
+
+TEST_F(ActorRegisterTest, GetActorChecksTags)
+{
+    auto server = actor_register_.Make<infra::Server>("server-1");
+    auto cloud = actor_register_.Make<infra::Cloud>("cloud-1");
+    auto vm = actor_register_.Make<infra::VM>("vm-1");
+
+    EXPECT_EQ(actor_register_.GetActor<infra::Server>(server->GetUUID()),
+              server);
+    EXPECT_EQ(actor_register_.GetActor<infra::IResource>(server->GetUUID()),
+              server);
+    EXPECT_EQ(actor_register_.GetActor<IActor>(server->GetUUID()), server);
+    EXPECT_EQ(actor_register_.GetActor<infra::Cloud>(server->GetUUID()),
+              nullptr);
+
+    EXPECT_EQ(actor_register_.GetActor<infra::IResource>(cloud->GetUUID()),
+              cloud);
+    EXPECT_EQ(actor_register_.GetActor<infra::Server>(cloud->GetUUID()),
+              nullptr);
+
+    EXPECT_EQ(actor_register_.GetActor<infra::VM>(vm->GetUUID()), vm);
+    EXPECT_EQ(actor_register_.GetActor<infra::IResource>(vm->GetUUID()),
+              nullptr);
+    EXPECT_EQ(actor_register_.GetActor<infra::Server>(vm->GetUUID()),
+              nullptr);
+}
+
+TEST_F(ActorRegisterTest, RemovedActorIsNotResolved)
+{
+    auto uuid = actor_register_.Make<infra::VM>("vm-1")->GetUUID();
+    EXPECT_EQ(actor_register_.Size(), 1);
+    EXPECT_EQ(actor_register_.GetActorHandle("vm-1"), uuid);
+
+    actor_register_.Remove(uuid);
+
+    EXPECT_EQ(actor_register_.Size(), 0);
+    EXPECT_EQ(actor_register_.FindActor(uuid), nullptr);
+    EXPECT_THROW(actor_register_.GetActor<infra::VM>(uuid), std::out_of_range);
+    EXPECT_THROW(actor_register_.GetActorHandle("vm-1"), std::out_of_range);
+}
+
+TEST_F(ActorRegisterTest, SlotIsReusedWithNewGeneration)
+{
+    auto old_uuid = actor_register_.Make<infra::VM>("vm-1")->GetUUID();
+    actor_register_.Remove(old_uuid);
+
+    // the name is free again, the slot is taken by the new actor
+    auto vm = actor_register_.Make<infra::VM>("vm-1");
+    auto new_uuid = vm->GetUUID();
+
+    EXPECT_EQ(new_uuid.Index(), old_uuid.Index());
+    EXPECT_NE(new_uuid.Generation(), old_uuid.Generation());
+    EXPECT_NE(new_uuid, old_uuid);
+
+    EXPECT_EQ(actor_register_.FindActor(new_uuid), vm);
+    EXPECT_EQ(actor_register_.FindActor(old_uuid), nullptr);
+    EXPECT_THROW(actor_register_.GetActor<infra::VM>(old_uuid),
+                 std::out_of_range);
+}
+
+TEST_F(ActorRegisterTest, UnknownActors)
+{
+    actor_register_.Make<infra::VM>("vm-1");
+
+    EXPECT_EQ(actor_register_.FindActor(UUID{}), nullptr);
+    EXPECT_EQ(actor_register_.FindActor(UUID{100, 0}), nullptr);
+    EXPECT_THROW(actor_register_.GetActor<IActor>(UUID{}), std::out_of_range);
+    EXPECT_THROW(actor_register_.GetActor<IActor>(UUID{100, 0}),
+                 std::out_of_range);
+    EXPECT_THROW(actor_register_.Make<infra::VM>("vm-1"), std::logic_error);
+}
+
+TEST(ActorTagTest, ActorKeepsTagsOfBases)
+{
+    infra::Server server;
+
+    EXPECT_EQ(server.GetTag(), ActorTag::kServer);
+    EXPECT_TRUE(server.HasTag(ActorTag::kServer));
+    EXPECT_TRUE(server.HasTag(ActorTag::kResource));
+    EXPECT_TRUE(server.HasTag(ActorTag::kNone));
+    EXPECT_FALSE(server.HasTag(ActorTag::kDataCenter));
+    EXPECT_FALSE(server.HasTag(ActorTag::kVM));
+}
+
+TEST(EventCastTest, ChecksExactTag)
+{
+    infra::VMEvent vm_event;
+    vm_event.tag = infra::VMEvent::kTag;
+
+    EXPECT_EQ(EventCast<infra::VMEvent>(&vm_event), &vm_event);
+    EXPECT_EQ(EventCast<infra::ServerEvent>(&vm_event), nullptr);
+}
+
+}   // namespace
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "cloud-schedulers/capacity-index.h"
+
+namespace {
+
+using namespace sim::custom;
+
+auto
+Key(const Capacity& capacity)
+{
+    return std::tuple{capacity.ram, capacity.cpu, capacity.io};
+}
+
+/// The fitting server with the least or the most free resources by a scan
+std::optional<Capacity>
+ScanFit(const std::vector<std::optional<Capacity>>& servers,
+        const Capacity& required, bool best)
+{
+    std::optional<Capacity> found;
+    for (const auto& free : servers) {
+        if (!free || !free->Fits(required)) {
+            continue;
+        }
+        if (!found || (best ? Key(*free) < Key(*found)
+                            : Key(*free) > Key(*found))) {
+            found = free;
+        }
+    }
+    return found;
+}
+
+TEST(CapacityIndexTest, BestAndWorstFit)
+{
+    CapacityIndex index;
+    index.Update(0, {8, 100, 10});
+    index.Update(1, {16, 50, 10});
+    index.Update(2, {16, 200, 5});
+    index.Update(3, {32, 400, 100});
+
+    EXPECT_EQ(index.FindBestFit({4, 50, 5}), 0u);
+    EXPECT_EQ(index.FindBestFit({8, 150, 5}), 2u);
+    EXPECT_EQ(index.FindBestFit({8, 150, 10}), 3u);
+    EXPECT_EQ(index.FindBestFit({64, 1, 1}), std::nullopt);
+
+    EXPECT_EQ(index.FindWorstFit({4, 50, 5}), 3u);
+    EXPECT_EQ(index.FindWorstFit({4, 500, 5}), std::nullopt);
+}
+
+TEST(CapacityIndexTest, UpdateMovesAndRemoveDrops)
+{
+    CapacityIndex index;
+    index.Update(0, {8, 100, 10});
+    index.Update(1, {16, 100, 10});
+
+    index.Update(1, {4, 100, 10});
+    EXPECT_EQ(index.FindBestFit({4, 0, 0}), 1u);
+    EXPECT_EQ(index.FindWorstFit({4, 0, 0}), 0u);
+
+    index.Remove(0);
+    EXPECT_FALSE(index.Contains(0));
+    EXPECT_TRUE(index.Contains(1));
+    EXPECT_EQ(index.FindWorstFit({4, 0, 0}), 1u);
+    EXPECT_EQ(index.FindBestFit({8, 0, 0}), std::nullopt);
+
+    // removal of an absent server is ignored
+    index.Remove(0);
+    index.Remove(10);
+    EXPECT_TRUE(index.Contains(1));
+}
+
+TEST(CapacityIndexTest, SameResultsAsScan)
+{
+    constexpr uint32_t kServersCount = 64;
+
+    std::mt19937 generator{42};
+    auto random = [&generator](uint64_t bound) {
+        return generator() % (bound + 1);
+    };
+
+    CapacityIndex index;
+    std::vector<std::optional<Capacity>> servers(kServersCount);
+
+    for (int i = 0; i < 20000; ++i) {
+        uint32_t server = random(kServersCount - 1);
+        if (random(9) == 0) {
+            index.Remove(server);
+            servers[server].reset();
+        } else {
+            Capacity free{random(16), random(8) * 50, random(4) * 100};
+            index.Update(server, free);
+            servers[server] = free;
+        }
+
+        Capacity required{random(16), random(8) * 50, random(4) * 100};
+        for (bool best : {true, false}) {
+            auto found = best ? index.FindBestFit(required)
+                              : index.FindWorstFit(required);
+            auto expected = ScanFit(servers, required, best);
+
+            ASSERT_EQ(found.has_value(), expected.has_value());
+            if (found) {
+                // servers with equal free capacity are interchangeable
+                ASSERT_TRUE(servers[*found]);
+                ASSERT_EQ(Key(*servers[*found]), Key(*expected));
+            }
+        }
+    }
+}
+
+}   // namespace
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "event.h"
+
+namespace {
+
+using namespace sim;
+using namespace sim::events;
+
+/// Each test uses own type, so it starts with an empty pool
+template <int N>
+struct PooledEvent : Event
+{
+    static constexpr EventTag kTag = EventTag::kVM;
+    using TagOwner = PooledEvent;
+
+    uint64_t payload{};
+};
+
+TEST(EventPoolTest, MakeEventFillsFields)
+{
+    Event notificator;
+    auto event =
+        MakeEvent<PooledEvent<0>>(UUID{3, 1}, TimeStamp{42}, &notificator);
+
+    EXPECT_EQ(event->tag, EventTag::kVM);
+    EXPECT_EQ(event->addressee, (UUID{3, 1}));
+    EXPECT_EQ(event->happen_time, 42);
+    EXPECT_EQ(event->notificator, &notificator);
+    EXPECT_FALSE(event->is_cancelled);
+    EXPECT_NE(event->release, nullptr);
+
+    ReleaseEvent(event);
+}
+
+TEST(EventPoolTest, ReleasedEventIsReused)
+{
+    auto event = MakeEvent<PooledEvent<1>>(UUID{}, TimeStamp{1}, nullptr);
+    event->payload = 7;
+    ReleaseEvent(event);
+
+    auto reused = MakeEvent<PooledEvent<1>>(UUID{}, TimeStamp{2}, nullptr);
+
+    // the slot is taken from the free list and constructed anew
+    EXPECT_EQ(reused, event);
+    EXPECT_EQ(reused->payload, 0);
+
+    ReleaseEvent(reused);
+}
+
+TEST(EventPoolTest, SlabIsAllocatedOnlyWhenFreeListIsEmpty)
+{
+    using TestEvent = PooledEvent<2>;
+
+    // the slab size of the pool
+    constexpr size_t kSlabSize = 1024;
+
+    auto before = GetEventPoolStats();
+
+    std::vector<TestEvent*> events;
+    for (size_t i = 0; i < kSlabSize; ++i) {
+        events.push_back(MakeEvent<TestEvent>(UUID{}, TimeStamp{1}, nullptr));
+    }
+    EXPECT_EQ(GetEventPoolStats().slab_allocations - before.slab_allocations,
+              1);
+
+    events.push_back(MakeEvent<TestEvent>(UUID{}, TimeStamp{1}, nullptr));
+    EXPECT_EQ(GetEventPoolStats().slab_allocations - before.slab_allocations,
+              2);
+
+    for (auto event : events) {
+        ReleaseEvent(event);
+    }
+
+    // warmed up pool does not allocate
+    auto warm = GetEventPoolStats();
+    for (int round = 0; round < 10; ++round) {
+        events.clear();
+        for (size_t i = 0; i < 2 * kSlabSize; ++i) {
+            events.push_back(
+                MakeEvent<TestEvent>(UUID{}, TimeStamp{1}, nullptr));
+        }
+        for (auto event : events) {
+            ReleaseEvent(event);
+        }
+    }
+
+    auto after = GetEventPoolStats();
+    EXPECT_EQ(after.slab_allocations, warm.slab_allocations);
+    EXPECT_EQ(after.acquired - warm.acquired, 20 * kSlabSize);
+    EXPECT_EQ(after.released - warm.released, 20 * kSlabSize);
+}
+
+TEST(EventPoolTest, ConcurrentAcquireAndRelease)
+{
+    using TestEvent = PooledEvent<3>;
+
+    constexpr int kThreadsCount = 4;
+    constexpr int kEventsCount = 10000;
+
+    std::vector<std::vector<TestEvent*>> events(kThreadsCount);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreadsCount; ++t) {
+        threads.emplace_back([&events, t] {
+            for (int i = 0; i < kEventsCount; ++i) {
+                auto event =
+                    MakeEvent<TestEvent>(UUID{}, TimeStamp{1}, nullptr);
+                event->payload = t;
+                events[t].push_back(event);
+
+                // half of the events are returned at once
+                if (i % 2) {
+                    ReleaseEvent(events[t].back());
+                    events[t].pop_back();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // live events are distinct and kept their payload
+    std::set<TestEvent*> unique;
+    for (int t = 0; t < kThreadsCount; ++t) {
+        for (auto event : events[t]) {
+            EXPECT_EQ(event->payload, t);
+            unique.insert(event);
+        }
+    }
+    EXPECT_EQ(unique.size(), kThreadsCount * kEventsCount / 2);
+
+    for (auto event : unique) {
+        ReleaseEvent(event);
+    }
+}
+
+}   // namespace
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "event-queue.h"
+
+namespace {
+
+using namespace sim;
+using namespace sim::events;
+
+struct TestEvent : Event
+{
+    int id{};
+};
+
+TestEvent*
+MakeTestEvent(TimeStamp ts, int id)
+{
+    auto event = new TestEvent;
+    event->happen_time = ts;
+    event->id = id;
+    return event;
+}
+
+/// Pops all events and returns their ids, releasing them
+std::vector<int>
+PopAll(IEventQueue& queue)
+{
+    std::vector<int> ids;
+    while (!queue.Empty()) {
+        auto event = static_cast<TestEvent*>(queue.Pop());
+        ids.push_back(event->id);
+        ReleaseEvent(event);
+    }
+    return ids;
+}
+
+class EventQueueTest : public testing::TestWithParam<std::string>
+{
+ protected:
+    std::unique_ptr<IEventQueue> queue_ = MakeEventQueue(GetParam());
+};
+
+TEST_P(EventQueueTest, OrdersByTime)
+{
+    queue_->Push(MakeTestEvent(30, 3), false);
+    queue_->Push(MakeTestEvent(10, 1), false);
+    queue_->Push(MakeTestEvent(20, 2), false);
+
+    EXPECT_EQ(queue_->Size(), 3);
+    EXPECT_EQ(queue_->NextTime(), 10);
+    EXPECT_EQ(PopAll(*queue_), (std::vector<int>{1, 2, 3}));
+    EXPECT_EQ(queue_->Size(), 0);
+}
+
+TEST_P(EventQueueTest, ImmediateEventsGoFirstInTimeStamp)
+{
+    queue_->Push(MakeTestEvent(5, 1), false);
+    queue_->Push(MakeTestEvent(5, 2), false);
+    queue_->Push(MakeTestEvent(5, 3), true);
+    queue_->Push(MakeTestEvent(5, 4), true);
+    queue_->Push(MakeTestEvent(4, 5), false);
+
+    EXPECT_EQ(PopAll(*queue_), (std::vector<int>{5, 4, 3, 1, 2}));
+}
+
+TEST_P(EventQueueTest, ImmediateEventAfterPopGoesFirst)
+{
+    queue_->Push(MakeTestEvent(7, 1), false);
+    queue_->Push(MakeTestEvent(7, 2), false);
+
+    // a handler of the first event schedules the next one for the same time
+    auto event = queue_->Pop();
+    ReleaseEvent(event);
+    queue_->Push(MakeTestEvent(7, 3), true);
+    queue_->Push(MakeTestEvent(7, 4), false);
+
+    EXPECT_EQ(PopAll(*queue_), (std::vector<int>{3, 2, 4}));
+}
+
+TEST_P(EventQueueTest, FarFutureEvents)
+{
+    queue_->Push(MakeTestEvent(1'000'000'000, 3), false);
+    queue_->Push(MakeTestEvent(2, 1), false);
+    queue_->Push(MakeTestEvent(1'000'000, 2), false);
+
+    EXPECT_EQ(queue_->NextTime(), 2);
+    EXPECT_EQ(PopAll(*queue_), (std::vector<int>{1, 2, 3}));
+}
+
+INSTANTIATE_TEST_SUITE_P(Queues, EventQueueTest,
+                         testing::Values("map", "calendar"));
+
+TEST(CalendarEventQueueTest, SameOrderAsMapQueue)
+{
+    std::mt19937 generator{42};
+
+    for (int round = 0; round < 20; ++round) {
+        MapEventQueue expected;
+        CalendarEventQueue actual;
+
+        // spreads of timestamps make the calendar resize and change width
+        TimeInterval spread = 1 + generator() % 1000;
+        TimeStamp now = 1;
+        int id = 0;
+
+        for (int i = 0; i < 5000; ++i) {
+            if (generator() % 3 != 0 || expected.Empty()) {
+                auto ts = now + generator() % spread;
+                if (generator() % 100 == 0) {
+                    ts += 100'000;
+                }
+                bool immediate = generator() % 4 == 0;
+
+                expected.Push(MakeTestEvent(ts, id), immediate);
+                actual.Push(MakeTestEvent(ts, id), immediate);
+                ++id;
+            } else {
+                ASSERT_EQ(actual.NextTime(), expected.NextTime());
+                now = expected.NextTime();
+
+                auto expected_event = static_cast<TestEvent*>(expected.Pop());
+                auto actual_event = static_cast<TestEvent*>(actual.Pop());
+                ASSERT_EQ(actual_event->id, expected_event->id);
+
+                ReleaseEvent(expected_event);
+                ReleaseEvent(actual_event);
+            }
+            ASSERT_EQ(actual.Size(), expected.Size());
+        }
+
+        EXPECT_EQ(PopAll(actual), PopAll(expected));
+    }
+}
+
+TEST(MakeEventQueueTest, UnknownQueueType)
+{
+    EXPECT_THROW(MakeEventQueue("heap"), std::invalid_argument);
+}
+
+}   // namespace
@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "power-model.h"
+#include "world.h"
+
+namespace {
+
+using namespace sim;
+
+struct RunResult
+{
+    TimeStamp now{};
+    core::SimulationMetrics middle, end;
+};
+
+/// Runs the same scenario in the given execution mode
+RunResult
+RunScenario(const std::string& mode)
+{
+    auto logs = std::filesystem::temp_directory_path() / "execution-modes-test";
+    std::filesystem::create_directories(logs);
+
+    auto config = std::make_shared<core::SimulatorConfig>();
+    config->SetMaxLogSeverity(LogSeverity::kError);
+    config->SetLogsPath(logs.string());
+    config->SetExecutionMode(mode);
+    config->SetExecutionThreads(3);
+
+    // the optimistic loop updates the world at the end of each window, with
+    // one tick windows schedulers run at the same times as in the others
+    config->SetOptimisticWindow(1);
+    config->SetSeed(7);
+
+    config->AddServerSpec(
+        "server",
+        {.ram = RAMBytes{64},
+         .cores_count = 4,
+         .io_bandwidth = IOBandwidthMBpS{4000},
+         .power_model = std::make_shared<infra::LinearPowerModel>(100, 300)});
+    config->AddDataCenter({"dc-1", {{"server", 3, "greedy"}}});
+    config->AddDataCenter({"dc-2", {{"server", 3, "greedy"}}});
+
+    core::World world{config};
+    world.Setup();
+
+    world.DoResourceAction("cloud-1", infra::ResourceEventType::kBoot);
+    world.SimulateUntil(10);
+
+    for (int i = 0; i < 12; ++i) {
+        // random workloads change every tick and wake servers up
+        auto name = "vm-" + std::to_string(i);
+        world.CreateVM(name, i % 4 == 3 ? "random-uniform" : "constant",
+                       {{"required_ram", std::to_string(4 + i % 5 * 8)},
+                        {"required_cpu", std::to_string(20 + i * 10)},
+                        {"required_bandwidth", "100"}});
+        world.SimulateUntil(world.Now() + 1);
+        world.DoProvisionVM(name);
+        world.SimulateUntil(world.Now() + 2);
+    }
+    world.SimulateUntil(100);
+
+    RunResult result;
+    result.middle = world.GetMetrics();
+
+    for (int i = 0; i < 12; i += 3) {
+        world.DoStopVM("vm-" + std::to_string(i));
+        world.DoDeleteVM("vm-" + std::to_string(i + 1));
+    }
+    world.SimulateUntil(150);
+    world.DoResourceAction("dc-2", infra::ResourceEventType::kShutdown);
+    world.SimulateUntil(200);
+
+    result.now = world.Now();
+    result.end = world.GetMetrics();
+    return result;
+}
+
+void
+ExpectSameMetrics(const core::SimulationMetrics& actual,
+                  const core::SimulationMetrics& expected)
+{
+    EXPECT_EQ(actual.energy, expected.energy);
+    EXPECT_EQ(actual.vms_requested, expected.vms_requested);
+    EXPECT_EQ(actual.vms_started, expected.vms_started);
+    EXPECT_EQ(actual.total_wait_time, expected.total_wait_time);
+}
+
+TEST(ExecutionModesTest, SameResultsInAllModes)
+{
+    auto serial = RunScenario("serial");
+
+    // the scenario should do something to compare
+    EXPECT_GT(serial.middle.vms_started, 0u);
+    EXPECT_GT(serial.end.energy.get(), serial.middle.energy.get());
+
+    for (std::string mode : {"conservative", "optimistic"}) {
+        SCOPED_TRACE(mode);
+
+        auto result = RunScenario(mode);
+        EXPECT_EQ(result.now, serial.now);
+        ExpectSameMetrics(result.middle, serial.middle);
+        ExpectSameMetrics(result.end, serial.end);
+    }
+}
+
+/// Simulates all events of the scenario in the given mode
+RunResult
+RunUntilEmpty(const std::string& mode, TimeInterval window)
+{
+    auto logs = std::filesystem::temp_directory_path() / "execution-modes-test";
+    std::filesystem::create_directories(logs);
+
+    auto config = std::make_shared<core::SimulatorConfig>();
+    config->SetMaxLogSeverity(LogSeverity::kError);
+    config->SetLogsPath(logs.string());
+    config->SetExecutionMode(mode);
+    config->SetExecutionThreads(3);
+    config->SetOptimisticWindow(window);
+
+    config->AddServerSpec(
+        "server",
+        {.ram = RAMBytes{64},
+         .cores_count = 4,
+         .io_bandwidth = IOBandwidthMBpS{4000},
+         .power_model = std::make_shared<infra::LinearPowerModel>(100, 300)});
+    config->AddDataCenter({"dc-1", {{"server", 3, "greedy"}}});
+    config->AddDataCenter({"dc-2", {{"server", 3, "greedy"}}});
+
+    core::World world{config};
+    world.Setup();
+
+    world.DoResourceAction("cloud-1", infra::ResourceEventType::kBoot);
+    world.SimulateAll();
+
+    RunResult result;
+    result.middle = world.GetMetrics();
+
+    for (int i = 0; i < 6; ++i) {
+        world.CreateVM("vm-" + std::to_string(i), "constant",
+                       {{"required_ram", "16"},
+                        {"required_cpu", std::to_string(50 + i * 20)},
+                        {"required_bandwidth", "100"}});
+    }
+    world.SimulateAll();
+    for (int i = 0; i < 6; ++i) {
+        world.DoProvisionVM("vm-" + std::to_string(i));
+    }
+    world.SimulateAll();
+
+    result.now = world.Now();
+    result.end = world.GetMetrics();
+    return result;
+}
+
+TEST(ExecutionModesTest, SimulateAllStopsAtLastEvent)
+{
+    auto serial = RunUntilEmpty("serial", 1);
+    EXPECT_GT(serial.end.vms_started, 0u);
+
+    // the time should not depend on the length of windows
+    for (TimeInterval window : {1, 7, 100, 100000}) {
+        SCOPED_TRACE(window);
+
+        auto result = RunUntilEmpty("optimistic", window);
+        EXPECT_EQ(result.now, serial.now);
+        ExpectSameMetrics(result.middle, serial.middle);
+        ExpectSameMetrics(result.end, serial.end);
+    }
+}
+
+}   // namespace
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+
+#include "log-batcher.h"
+
+namespace {
+
+using namespace sim::core;
+using namespace std::chrono_literals;
+
+LogMessage
+MakeLog(const std::string& text)
+{
+    LogMessage message{};
+    message.set_text(text);
+    return message;
+}
+
+TEST(LogBatcherTest, FirstRecordStartsDelay)
+{
+    SimulateAllMessage request{};
+    request.set_max_batch_delay_ms(10);
+    LogBatcher batcher{request};
+
+    // the writer is waiting for records when the first one comes
+    LogBatchMessage batch{};
+    auto taken =
+        std::async(std::launch::async, [&] { return batcher.Next(&batch); });
+    std::this_thread::sleep_for(20ms);
+
+    batcher.Add(MakeLog("first"));
+    auto status = taken.wait_for(5s);
+
+    // the writer would return only now, with the last batch
+    batcher.Close();
+
+    EXPECT_EQ(status, std::future_status::ready);
+    EXPECT_TRUE(taken.get());
+    ASSERT_EQ(batch.logs_size(), 1);
+    EXPECT_EQ(batch.logs(0).text(), "first");
+
+    EXPECT_FALSE(batcher.Next(&batch));
+}
+
+TEST(LogBatcherTest, FullBatchesAndTheRestOnClose)
+{
+    SimulateAllMessage request{};
+    request.set_max_batch_size(2);
+    LogBatcher batcher{request};
+
+    for (int i = 0; i < 5; ++i) {
+        batcher.Add(MakeLog(std::to_string(i)));
+    }
+    batcher.Close();
+
+    LogBatchMessage batch{};
+    std::string texts;
+    int batches = 0;
+    while (batcher.Next(&batch)) {
+        ++batches;
+        for (const auto& log : batch.logs()) {
+            texts += log.text();
+        }
+    }
+
+    EXPECT_EQ(batches, 3);
+    EXPECT_EQ(texts, "01234");
+}
+
+TEST(LogBatcherTest, DropsAndCountsRecordsOfSlowClient)
+{
+    SimulateAllMessage request{};
+    request.set_max_batch_size(2);
+    request.set_max_pending_batches(1);
+    request.set_slow_client_policy(
+        simulator_api::SlowClientPolicy::DROP_SLOW_CLIENT_POLICY);
+    LogBatcher batcher{request};
+
+    // a pending batch and a full current one, the rest is dropped
+    for (int i = 0; i < 10; ++i) {
+        batcher.Add(MakeLog(std::to_string(i)));
+    }
+    batcher.Close();
+
+    LogBatchMessage batch{};
+    ASSERT_TRUE(batcher.Next(&batch));
+    EXPECT_EQ(batch.logs_size(), 2);
+    EXPECT_EQ(batch.dropped_count(), 0u);
+
+    ASSERT_TRUE(batcher.Next(&batch));
+    EXPECT_EQ(batch.logs_size(), 2);
+    EXPECT_EQ(batch.dropped_count(), 6u);
+
+    EXPECT_FALSE(batcher.Next(&batch));
+}
+
+}   // namespace
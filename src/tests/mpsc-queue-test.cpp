@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "mpsc-queue.h"
+
+namespace {
+
+using namespace sim;
+using namespace std::chrono_literals;
+
+TEST(MPSCQueueTest, PopsInPushOrder)
+{
+    MPSCQueue<int> queue;
+    EXPECT_EQ(queue.TryPop(), std::nullopt);
+
+    for (int i = 0; i < 5; ++i) {
+        queue.Push(i);
+    }
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(queue.TryPop(), i);
+    }
+    EXPECT_EQ(queue.TryPop(), std::nullopt);
+}
+
+TEST(MPSCQueueTest, KeepsOrderOfEachProducer)
+{
+    constexpr int kProducersCount = 4;
+    constexpr int kItemsCount = 20000;
+
+    MPSCQueue<std::pair<int, int>> queue;
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < kProducersCount; ++producer) {
+        producers.emplace_back([&queue, producer] {
+            for (int i = 0; i < kItemsCount; ++i) {
+                queue.Push({producer, i});
+            }
+        });
+    }
+
+    // every item comes once and after the previous ones of its producer
+    std::vector<int> next(kProducersCount);
+    for (int taken = 0; taken < kProducersCount * kItemsCount; ++taken) {
+        auto [producer, i] = queue.Pop();
+        ASSERT_EQ(i, next[producer]);
+        ++next[producer];
+    }
+    EXPECT_EQ(queue.TryPop(), std::nullopt);
+
+    for (auto& thread : producers) {
+        thread.join();
+    }
+}
+
+TEST(MPSCQueueTest, PopWaitsForPush)
+{
+    MPSCQueue<std::unique_ptr<int>> queue;
+
+    auto popped = std::async(std::launch::async, [&queue] {
+        return *queue.Pop();
+    });
+    EXPECT_EQ(popped.wait_for(20ms), std::future_status::timeout);
+
+    queue.Push(std::make_unique<int>(7));
+    ASSERT_EQ(popped.wait_for(5s), std::future_status::ready);
+    EXPECT_EQ(popped.get(), 7);
+}
+
+}   // namespace
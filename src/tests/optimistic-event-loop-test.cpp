@@ -0,0 +1,246 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "actor-register.h"
+#include "event-loop.h"
+#include "optimistic-event-loop.h"
+#include "random.h"
+#include "trace-reader.h"
+
+namespace {
+
+using namespace sim;
+using namespace sim::events;
+
+constexpr uint32_t kActorsCount = 16;
+constexpr uint32_t kChainsCount = 40;
+constexpr int kChainLength = 8;
+
+/// Depth of a chain at which its event gets a new notificator
+constexpr int kNotifyTTL = 5;
+
+struct PingEvent : Event
+{
+    using TagOwner = PingEvent;
+
+    uint64_t payload{};
+    int ttl{};
+};
+
+/**
+ * Passes the event on to an actor chosen by its state with zero delay, so a
+ * chain lives in one timestamp and crosses partitions. The last event of a
+ * chain schedules its notificator
+ */
+class PingActor : public IActor
+{
+ public:
+    static constexpr ActorTag kTag = ActorTag::kNone;
+    using TagOwner = PingActor;
+
+    PingActor() : IActor("Ping", kTag) {}
+
+    void SetActors(const std::vector<UUID>* actors) { actors_ = actors; }
+
+    uint64_t GetState() const { return state_; }
+
+    void HandleEvent(const Event* event) override
+    {
+        auto ping = static_cast<const PingEvent*>(event);
+
+        SaveUndo([this, state = state_] { state_ = state; });
+        state_ = Mix(state_ ^ ping->payload);
+
+        ACTOR_LOG_INFO("Got {} with ttl {}, state {}", ping->payload,
+                       ping->ttl, state_);
+        Trace({.type = trace::RecordType::kServerWorkload,
+               .ram = state_,
+               .cpu = static_cast<uint32_t>(ping->ttl)});
+
+        if (ping->ttl == 0) {
+            if (auto notificator = ping->notificator) {
+                notificator->happen_time = ping->happen_time;
+                schedule_event(notificator, false);
+            }
+            return;
+        }
+
+        // the notificator made here is owned by the next event
+        auto notificator = ping->notificator;
+        if (!notificator && ping->ttl == kNotifyTTL) {
+            auto made = MakeEvent<PingEvent>(Pick(state_ >> 32),
+                                             ping->happen_time, nullptr);
+            made->payload = state_ + 1;
+            notificator = made;
+        }
+
+        auto next =
+            MakeEvent<PingEvent>(Pick(state_), ping->happen_time, notificator);
+        next->payload = state_;
+        next->ttl = ping->ttl - 1;
+        schedule_event(next, false);
+    }
+
+ private:
+    const std::vector<UUID>* actors_{};
+    uint64_t state_{1};
+
+    UUID Pick(uint64_t value) const
+    {
+        return (*actors_)[value % actors_->size()];
+    }
+};
+
+struct RunResult
+{
+    std::vector<uint64_t> states;
+    std::vector<std::string> logs;
+    std::vector<std::pair<TimeStamp, uint64_t>> trace;
+    TimeStamp now{};
+    int64_t leaked{};
+};
+
+/// Runs chains of pings with the loop, the partition of an actor is its
+/// index modulo partitions_count
+RunResult
+RunChains(EventLoop& loop, size_t partitions_count)
+{
+    auto trace_path =
+        std::filesystem::temp_directory_path() / "optimistic-loop-test.trace";
+    auto& writer = trace::TraceWriter::GetWriter();
+    writer.Open(trace_path.string());
+
+    auto& logger = SimulatorLogger::GetLogger();
+    logger.SetMaxConsoleSeverity(LogSeverity::kError);
+    logger.SetMaxCSVSeverity(LogSeverity::kError);
+    logger.SetTimeCallback([&loop] { return loop.Now(); });
+
+    RunResult result;
+    logger.PushLoggingCallback(
+        [&result](TimeStamp ts, LogSeverity, std::string_view,
+                  std::string_view caller_name, std::string_view text) {
+            result.logs.push_back(fmt::format("{} {}: {}", ts, caller_name,
+                                              text));
+        });
+
+    auto before = GetEventPoolStats();
+    {
+        ActorRegister actor_register;
+        actor_register.SetScheduleFunction(
+            [&loop](Event* event, bool immediate) {
+                loop.Insert(event, immediate);
+            });
+        actor_register.SetNowFunction([&loop] { return loop.Now(); });
+
+        std::vector<UUID> actors;
+        for (uint32_t i = 0; i < kActorsCount; ++i) {
+            auto actor =
+                actor_register.Make<PingActor>("ping-" + std::to_string(i));
+            actor->SetActors(&actors);
+            actors.push_back(actor->GetUUID());
+        }
+
+        loop.SetActorFromUUIDCallback([&actor_register](UUID uuid) {
+            return actor_register.GetActor<IActor>(uuid);
+        });
+        loop.SetUpdateWorldCallback([] {});
+
+        if (auto partitioned = dynamic_cast<PartitionedEventLoop*>(&loop)) {
+            partitioned->SetPartitionFunction(
+                [partitions_count](UUID uuid) {
+                    return uuid.Index() % partitions_count;
+                });
+            partitioned->SetPartitionsCount(partitions_count);
+            for (auto uuid : actors) {
+                partitioned->UpdatePartition(uuid);
+            }
+        }
+
+        // one chain per timestamp, so the order of events is the same in
+        // all loops; every other chain brings a notificator from outside
+        for (uint32_t i = 0; i < kChainsCount; ++i) {
+            Event* notificator = nullptr;
+            if (i % 2 == 0) {
+                auto made = MakeEvent<PingEvent>(
+                    actors[(i + 1) % kActorsCount], 0, nullptr);
+                made->payload = i + 1000;
+                notificator = made;
+            }
+
+            auto event = MakeEvent<PingEvent>(actors[i % kActorsCount],
+                                              TimeStamp{1} + i, notificator);
+            event->payload = i;
+            event->ttl = kChainLength;
+            loop.Insert(event);
+        }
+
+        loop.SimulateAll();
+        logger.Flush();
+
+        result.now = loop.Now();
+        for (auto uuid : actors) {
+            result.states.push_back(
+                actor_register.GetActor<PingActor>(uuid)->GetState());
+        }
+    }
+    auto after = GetEventPoolStats();
+    result.leaked = static_cast<int64_t>(after.acquired - before.acquired) -
+                    static_cast<int64_t>(after.released - before.released);
+
+    logger.PopLoggingCallback();
+    writer.Close();
+
+    {
+        trace::TraceReader reader{trace_path.string()};
+        for (const auto& chunk : reader.GetChunks()) {
+            for (size_t i = 0; i < chunk.size; ++i) {
+                auto record = chunk.GetRecord(i);
+                result.trace.emplace_back(record.ts, record.ram);
+            }
+        }
+    }
+    std::filesystem::remove(trace_path);
+
+    return result;
+}
+
+class OptimisticEventLoopTest : public testing::TestWithParam<size_t>
+{
+};
+
+TEST_P(OptimisticEventLoopTest, RollsBackToSerialResults)
+{
+    EventLoop serial;
+    auto expected = RunChains(serial, 1);
+
+    OptimisticEventLoop optimistic{GetParam(), 100};
+    auto result = RunChains(optimistic, 4);
+
+    // chains crossing partitions in the past roll back handled events
+    const auto& stats = optimistic.GetStats();
+    EXPECT_GT(stats.stragglers, 0u);
+    EXPECT_GT(stats.rolled_back, 0u);
+    EXPECT_GT(stats.anti_messages, 0u);
+
+    // the events of a chain and its notificator
+    EXPECT_EQ(stats.committed, kChainsCount * (kChainLength + 2));
+    EXPECT_EQ(expected.trace.size(), stats.committed);
+
+    EXPECT_EQ(result.states, expected.states);
+    EXPECT_EQ(result.logs, expected.logs);
+    EXPECT_EQ(result.trace, expected.trace);
+    EXPECT_EQ(result.now, expected.now);
+
+    // cancelled events and notificators are released
+    EXPECT_EQ(expected.leaked, 0);
+    EXPECT_EQ(result.leaked, 0);
+}
+
+INSTANTIATE_TEST_SUITE_P(Threads, OptimisticEventLoopTest,
+                         testing::Values(1, 4));
+
+}   // namespace
@@ -0,0 +1,246 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cloud.h"
+#include "config.h"
+#include "power-model.h"
+#include "workload-trace.h"
+#include "world.h"
+
+namespace {
+
+using namespace sim;
+
+/// Writes a trace of one VM "vm-1" with the given CPU utilization samples
+std::string
+WriteTrace(const std::string& name, TimeInterval step,
+           const std::vector<uint32_t>& cpu)
+{
+    auto path = (std::filesystem::temp_directory_path() / name).string();
+
+    std::vector<trace::WorkloadSample> samples;
+    for (auto value : cpu) {
+        samples.push_back({.ram = 4, .cpu = value, .io_bandwidth = 10});
+    }
+
+    trace::WorkloadTraceHeader header{};
+    std::memcpy(header.magic, trace::kWorkloadFileMagic,
+                sizeof(trace::kWorkloadFileMagic));
+    header.version = trace::kWorkloadFormatVersion;
+    header.vms_count = 1;
+    header.step = step;
+    header.samples_count = samples.size();
+
+    std::string names = "vm-1";
+    header.names_size = names.size();
+
+    trace::WorkloadTraceVM vm{
+        .start_ts = 0,
+        .first_sample = 0,
+        .samples_count = samples.size(),
+        .name_offset = 0,
+        .name_length = static_cast<uint32_t>(names.size())};
+
+    auto file = std::fopen(path.c_str(), "wb");
+    std::fwrite(&header, sizeof(header), 1, file);
+    std::fwrite(samples.data(), sizeof(trace::WorkloadSample), samples.size(),
+                file);
+    std::fwrite(&vm, sizeof(vm), 1, file);
+    std::fwrite(names.data(), 1, names.size(), file);
+    std::fclose(file);
+
+    return path;
+}
+
+TEST(PowerModelTest, TableInterpolatesBetweenLoads)
+{
+    infra::TablePowerModel model{{100, 200, 400}};
+
+    EXPECT_EQ(model.GetPower(0).get(), 100u);
+    EXPECT_EQ(model.GetPower(0.25).get(), 150u);
+    EXPECT_EQ(model.GetPower(0.5).get(), 200u);
+    EXPECT_EQ(model.GetPower(0.75).get(), 300u);
+    EXPECT_EQ(model.GetPower(1).get(), 400u);
+
+    EXPECT_THROW(infra::TablePowerModel{{100}}, std::invalid_argument);
+}
+
+TEST(PowerModelTest, PiecewiseHoldsOutsideOfPoints)
+{
+    infra::PiecewisePowerModel model{{{0.2, 100}, {0.6, 300}, {0.8, 340}}};
+
+    // the first and the last points hold below and above their loads
+    EXPECT_EQ(model.GetPower(0).get(), 100u);
+    EXPECT_EQ(model.GetPower(0.2).get(), 100u);
+    EXPECT_EQ(model.GetPower(0.4).get(), 200u);
+    EXPECT_EQ(model.GetPower(0.6).get(), 300u);
+    EXPECT_EQ(model.GetPower(0.7).get(), 320u);
+    EXPECT_EQ(model.GetPower(0.8).get(), 340u);
+    EXPECT_EQ(model.GetPower(1).get(), 340u);
+
+    EXPECT_THROW(infra::PiecewisePowerModel{{}}, std::invalid_argument);
+    EXPECT_THROW((infra::PiecewisePowerModel{{{0.6, 300}, {0.2, 100}}}),
+                 std::invalid_argument);
+}
+
+/// Parses the config folder with one server of each spec of the specs file
+class PowerConfigTest : public testing::Test
+{
+ protected:
+    void SetUp() override
+    {
+        auto& logger = SimulatorLogger::GetLogger();
+        logger.SetMaxConsoleSeverity(LogSeverity::kError);
+        logger.SetMaxCSVSeverity(LogSeverity::kError);
+        logger.SetTimeCallback([] { return TimeStamp{0}; });
+
+        config_path_ = std::filesystem::temp_directory_path() / "power-test";
+        std::filesystem::create_directories(config_path_);
+    }
+
+    void TearDown() override { std::filesystem::remove_all(config_path_); }
+
+    /// Returns the power model of the server of each spec
+    std::vector<std::shared_ptr<const infra::IPowerModel>> Parse(
+        const std::vector<std::pair<std::string, std::string>>& specs)
+    {
+        std::ofstream specs_file{config_path_ / "specs.yaml"};
+        std::ofstream cloud_file{config_path_ / "cloud.yaml"};
+        cloud_file << "data-centers:\n"
+                      "    -   name: dc-1\n"
+                      "        servers:\n";
+
+        for (const auto& [name, power] : specs) {
+            specs_file << "-   name: " << name << "\n"
+                       << "    ram: 32\n"
+                       << "    io-bandwidth: 2000\n"
+                       << "    cores-count: 4\n"
+                       << "    power: " << power << "\n";
+            cloud_file << "            -   name: " << name << "\n"
+                       << "                count: 1\n"
+                       << "                scheduler: greedy\n";
+        }
+        specs_file.close();
+        cloud_file.close();
+
+        events::ActorRegister actor_register;
+        core::ServerSchedulerManager manager;
+        auto cloud = actor_register.Make<infra::Cloud>("cloud-1");
+
+        core::SimulatorConfig config;
+        config.SetConfigPath(config_path_.string());
+        config.ParseResources(cloud->GetUUID(), &actor_register, &manager);
+
+        std::vector<std::shared_ptr<const infra::IPowerModel>> models;
+        for (const auto& [name, power] : specs) {
+            auto server = actor_register.GetActor<infra::Server>(
+                actor_register.GetActorHandle(name + "-1"));
+            models.push_back(server->GetSpec().power_model);
+        }
+        return models;
+    }
+
+    std::filesystem::path config_path_;
+};
+
+TEST_F(PowerConfigTest, ParsesModels)
+{
+    auto models = Parse(
+        {{"linear", "{model: linear, idle: 100, max: 300}"},
+         {"table", "{model: table, values: [100, 200, 400]}"},
+         {"piecewise",
+          "{model: piecewise, points: [[0.2, 100], [0.6, 300]]}"}});
+
+    ASSERT_EQ(models.size(), 3u);
+    for (const auto& model : models) {
+        ASSERT_TRUE(model);
+    }
+
+    EXPECT_EQ(models[0]->GetPower(0.5).get(), 200u);
+    EXPECT_EQ(models[1]->GetPower(0.75).get(), 300u);
+    EXPECT_EQ(models[2]->GetPower(0.4).get(), 200u);
+    EXPECT_EQ(models[2]->GetPower(1).get(), 300u);
+}
+
+TEST_F(PowerConfigTest, RejectsInvalidModels)
+{
+    for (std::string power :
+         {"100", "{idle: 100, max: 300}", "{model: cubic}",
+          "{model: [linear]}", "{model: linear, idle: 100}",
+          "{model: linear, idle: [100], max: 300}", "{model: table}",
+          "{model: table, values: [100]}", "{model: table, values: 100}",
+          "{model: piecewise}", "{model: piecewise, points: []}",
+          "{model: piecewise, points: [[0.2, 100, 1]]}",
+          "{model: piecewise, points: [[0.6, 300], [0.2, 100]]}"}) {
+        SCOPED_TRACE(power);
+
+        EXPECT_THROW(Parse({{"server", power}}), std::runtime_error);
+    }
+}
+
+class ServerPowerTest : public testing::TestWithParam<std::string>
+{
+};
+
+TEST_P(ServerPowerTest, FollowsTraceWorkload)
+{
+    auto trace = WriteTrace("power-test-" + GetParam() + ".trace", 50,
+                            {10, 90});
+    auto logs = std::filesystem::temp_directory_path() / "power-test";
+    std::filesystem::create_directories(logs);
+
+    auto config = std::make_shared<core::SimulatorConfig>();
+    config->SetMaxLogSeverity(LogSeverity::kError);
+    config->SetLogsPath(logs.string());
+    config->SetExecutionMode(GetParam());
+    config->SetExecutionThreads(2);
+    config->SetOptimisticWindow(4);
+
+    config->AddServerSpec(
+        "server",
+        {.ram = RAMBytes{64},
+         .cores_count = 1,
+         .io_bandwidth = IOBandwidthMBpS{4000},
+         .power_model = std::make_shared<infra::LinearPowerModel>(100, 300)});
+    config->AddDataCenter({"dc-1", {{"server", 1, "greedy"}}});
+
+    core::World world{config};
+    world.Setup();
+
+    world.DoResourceAction("cloud-1", infra::ResourceEventType::kBoot);
+    world.SimulateUntil(5);
+    world.CreateVM("vm-1", "trace", {{"trace", trace}, {"trace_vm", "vm-1"}});
+    world.SimulateUntil(6);
+    world.DoProvisionVM("vm-1");
+
+    auto energy_at = [&world](TimeStamp ts) {
+        world.SimulateUntil(ts);
+        return world.GetMetrics().energy.get();
+    };
+
+    // the VM loads the server by 10% until 50 and by 90% after it
+    auto low = energy_at(20);
+    low = energy_at(40) - low;
+    auto high = energy_at(60);
+    high = energy_at(80) - high;
+
+    EXPECT_EQ(low, 20 * 120u);
+    EXPECT_EQ(high, 20 * 280u);
+
+    std::filesystem::remove(trace);
+}
+
+INSTANTIATE_TEST_SUITE_P(Modes, ServerPowerTest,
+                         testing::Values("serial", "conservative",
+                                         "optimistic"));
+
+}   // namespace
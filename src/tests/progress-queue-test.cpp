@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <thread>
+
+#include "progress-queue.h"
+
+namespace {
+
+using namespace sim::core;
+using namespace std::chrono_literals;
+
+ProgressMessage
+MakeProgress(uint64_t time)
+{
+    ProgressMessage message{};
+    message.set_time(time);
+    return message;
+}
+
+TEST(ProgressQueueTest, FullQueueDropsOldest)
+{
+    ProgressQueue queue{2};
+    for (uint64_t time = 1; time <= 5; ++time) {
+        EXPECT_TRUE(queue.Push(MakeProgress(time)));
+    }
+    queue.Close();
+
+    ProgressMessage message{};
+    ASSERT_TRUE(queue.Next(&message));
+    EXPECT_EQ(message.time(), 4u);
+    ASSERT_TRUE(queue.Next(&message));
+    EXPECT_EQ(message.time(), 5u);
+    EXPECT_FALSE(queue.Next(&message));
+}
+
+TEST(ProgressQueueTest, WriterWaitsForRecords)
+{
+    ProgressQueue queue;
+
+    ProgressMessage message{};
+    auto taken =
+        std::async(std::launch::async, [&] { return queue.Next(&message); });
+    std::this_thread::sleep_for(20ms);
+
+    queue.Push(MakeProgress(7));
+    auto status = taken.wait_for(5s);
+    queue.Close();
+
+    EXPECT_EQ(status, std::future_status::ready);
+    EXPECT_TRUE(taken.get());
+    EXPECT_EQ(message.time(), 7u);
+}
+
+TEST(ProgressQueueTest, CancelledQueueRejectsRecords)
+{
+    ProgressQueue queue;
+    EXPECT_TRUE(queue.Push(MakeProgress(1)));
+
+    queue.Cancel();
+    EXPECT_TRUE(queue.IsCancelled());
+    EXPECT_FALSE(queue.Push(MakeProgress(2)));
+    queue.Close();
+
+    ProgressMessage message{};
+    ASSERT_TRUE(queue.Next(&message));
+    EXPECT_EQ(message.time(), 1u);
+    EXPECT_FALSE(queue.Next(&message));
+}
+
+}   // namespace
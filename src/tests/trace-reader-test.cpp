@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+#include "trace-reader.h"
+#include "trace-writer.h"
+
+namespace {
+
+using namespace sim;
+using namespace sim::trace;
+
+/// Writes a trace of one chunk with count records of actor "server-1"
+std::string
+WriteTrace(const std::string& name, int count)
+{
+    auto path = (std::filesystem::temp_directory_path() / name).string();
+
+    TraceWriter writer;
+    writer.Open(path);
+    for (int i = 0; i < count; ++i) {
+        writer.Write({.ts = i,
+                      .actor = UUID{1, 0},
+                      .type = RecordType::kServerWorkload,
+                      .ram = static_cast<uint64_t>(i) * 10},
+                     "server-1");
+    }
+    writer.Close();
+
+    return path;
+}
+
+/// Overwrites a field of the first chunk header
+void
+PatchChunk(const std::string& path, size_t offset, uint32_t value)
+{
+    auto file = std::fopen(path.c_str(), "r+b");
+    std::fseek(file, static_cast<long>(sizeof(FileHeader) + offset),
+               SEEK_SET);
+    std::fwrite(&value, sizeof(value), 1, file);
+    std::fclose(file);
+}
+
+TEST(TraceReaderTest, ReadsWrittenRecords)
+{
+    auto path = WriteTrace("trace-reader-test-read.trace", 3);
+
+    TraceReader reader{path};
+    ASSERT_EQ(reader.GetChunks().size(), 1u);
+
+    const auto& chunk = reader.GetChunks()[0];
+    ASSERT_EQ(chunk.size, 3u);
+    EXPECT_EQ(chunk.GetRecord(2).ts, 2);
+    EXPECT_EQ(chunk.GetRecord(2).ram, 20u);
+    EXPECT_EQ(chunk.GetRecord(2).actor, (UUID{1, 0}));
+    EXPECT_EQ(reader.GetActorName(UUID{1, 0}), "server-1");
+
+    std::filesystem::remove(path);
+}
+
+TEST(TraceReaderTest, RejectsCountsPastChunk)
+{
+    // columns of the counts do not fit the chunk
+    for (auto field : {offsetof(ChunkHeader, records_count),
+                       offsetof(ChunkHeader, names_count),
+                       offsetof(ChunkHeader, names_size)}) {
+        SCOPED_TRACE(field);
+
+        auto path = WriteTrace("trace-reader-test-counts.trace", 3);
+        PatchChunk(path, field, 1000000);
+
+        TraceReader reader{path};
+        EXPECT_TRUE(reader.GetChunks().empty());
+
+        std::filesystem::remove(path);
+    }
+}
+
+}   // namespace
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "actor-register.h"
+#include "server.h"
+#include "vm.h"
+
+namespace {
+
+using namespace sim;
+using namespace sim::events;
+using namespace sim::infra;
+
+class VMTest : public testing::Test
+{
+ protected:
+    void SetUp() override
+    {
+        auto& logger = SimulatorLogger::GetLogger();
+        logger.SetMaxConsoleSeverity(LogSeverity::kError);
+        logger.SetMaxCSVSeverity(LogSeverity::kError);
+        logger.SetTimeCallback([] { return TimeStamp{1}; });
+
+        actor_register_.SetScheduleFunction(
+            [this](Event* event, bool) { scheduled_.push_back(event); });
+        actor_register_.SetNowFunction([] { return TimeStamp{1}; });
+
+        vm_ = actor_register_.Make<VM>("vm-1");
+    }
+
+    void TearDown() override
+    {
+        for (auto event : scheduled_) {
+            if (event->notificator) {
+                ReleaseEvent(event->notificator);
+            }
+            ReleaseEvent(event);
+        }
+    }
+
+    void Send(VMEventType type)
+    {
+        VMEvent event;
+        event.tag = VMEvent::kTag;
+        event.type = type;
+        event.happen_time = 1;
+        event.addressee = vm_->GetUUID();
+        event.server_uuid = server_;
+
+        vm_->HandleEvent(&event);
+    }
+
+    ActorRegister actor_register_;
+    std::vector<Event*> scheduled_;
+
+    VM* vm_{};
+    UUID server_{7, 0};
+};
+
+TEST_F(VMTest, StartTakesOwner)
+{
+    Send(VMEventType::kStart);
+
+    EXPECT_EQ(vm_->GetState(), VMState::kStarting);
+    EXPECT_EQ(vm_->GetOwner(), server_);
+    ASSERT_EQ(scheduled_.size(), 1u);
+}
+
+TEST_F(VMTest, RejectedStartTakesOwner)
+{
+    // deletion of a VM which has not started fails it
+    Send(VMEventType::kDelete);
+    ASSERT_EQ(vm_->GetState(), VMState::kFailure);
+
+    // the server has added the VM to its list anyway, so the VM should know
+    // where to be unprovisioned from
+    Send(VMEventType::kStart);
+
+    EXPECT_EQ(vm_->GetState(), VMState::kFailure);
+    EXPECT_EQ(vm_->GetOwner(), server_);
+
+    Send(VMEventType::kDelete);
+    Send(VMEventType::kDeleteCompleted);
+
+    ASSERT_EQ(scheduled_.size(), 2u);
+    auto unprovision = EventCast<ServerEvent>(scheduled_.back());
+    ASSERT_NE(unprovision, nullptr);
+    EXPECT_EQ(unprovision->type, ServerEventType::kUnprovisionVM);
+    EXPECT_EQ(unprovision->addressee, server_);
+    EXPECT_EQ(unprovision->vm_uuid, vm_->GetUUID());
+}
+
+}   // namespace
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "vm.h"
+#include "workload-models/random-uniform.h"
+
+namespace {
+
+using namespace sim;
+using namespace sim::custom;
+
+std::unique_ptr<RandomUniformWorkloadModel>
+MakeRandomModel(uint64_t key)
+{
+    auto model = std::make_unique<RandomUniformWorkloadModel>();
+    model->Setup({{"required_ram", "64"},
+                  {"required_cpu", "100"},
+                  {"required_bandwidth", "1000"}});
+    model->SetRandomStream(RandomStream{key});
+    return model;
+}
+
+TEST(RandomUniformWorkloadModelTest, WorkloadDependsOnlyOnTime)
+{
+    auto model = MakeRandomModel(1);
+
+    auto first = model->GetWorkload(10);
+    model->GetWorkload(11);
+    model->GetWorkload(10);
+    auto again = model->GetWorkload(10);
+
+    EXPECT_EQ(again.required_ram.get(), first.required_ram.get());
+    EXPECT_EQ(again.cpu_utilization.get(), first.cpu_utilization.get());
+    EXPECT_EQ(again.io_bandwidth.get(), first.io_bandwidth.get());
+
+    // a fresh model of the same stream agrees
+    auto copy = MakeRandomModel(1)->GetWorkload(10);
+    EXPECT_EQ(copy.required_ram.get(), first.required_ram.get());
+    EXPECT_EQ(copy.cpu_utilization.get(), first.cpu_utilization.get());
+    EXPECT_EQ(copy.io_bandwidth.get(), first.io_bandwidth.get());
+}
+
+TEST(RandomUniformWorkloadModelTest, WorkloadsChangeAndStayInBounds)
+{
+    auto model = MakeRandomModel(2);
+
+    int changes = 0;
+    auto previous = model->GetWorkload(0);
+    for (TimeStamp time = 1; time < 1000; ++time) {
+        auto workload = model->GetWorkload(time);
+        EXPECT_LE(workload.required_ram.get(), 64u);
+        EXPECT_LE(workload.cpu_utilization.get(), 100u);
+        EXPECT_LE(workload.io_bandwidth.get(), 1000u);
+
+        changes += workload.cpu_utilization.get() !=
+                   previous.cpu_utilization.get();
+        previous = workload;
+    }
+    EXPECT_GT(changes, 900);
+    EXPECT_EQ(model->GetNextChange(5), 6);
+}
+
+TEST(RandomUniformWorkloadModelTest, BatchEqualsSingleModels)
+{
+    std::vector<std::unique_ptr<RandomUniformWorkloadModel>> models;
+    std::vector<infra::IVMWorkloadModel*> pointers;
+    for (uint64_t key = 0; key < 20; ++key) {
+        models.push_back(MakeRandomModel(key));
+        pointers.push_back(models.back().get());
+    }
+
+    for (TimeStamp time : {0, 1, 7, 1000}) {
+        infra::WorkloadBatch batch;
+        batch.Resize(models.size());
+        models[0]->GetWorkloads(pointers, time, batch);
+
+        for (size_t i = 0; i < models.size(); ++i) {
+            auto workload = models[i]->GetWorkload(time);
+            EXPECT_EQ(batch.required_ram[i], workload.required_ram.get());
+            EXPECT_EQ(batch.cpu_utilization[i],
+                      workload.cpu_utilization.get());
+            EXPECT_EQ(batch.io_bandwidth[i], workload.io_bandwidth.get());
+        }
+    }
+}
+
+}   // namespace
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "workload-trace.h"
+
+namespace {
+
+using namespace sim;
+using namespace sim::trace;
+
+/// Writes a trace of one VM "vm-1" with the given samples
+std::string
+WriteTrace(const std::string& name, TimeStamp start_ts, TimeInterval step,
+           const std::vector<WorkloadSample>& samples)
+{
+    auto path = (std::filesystem::temp_directory_path() / name).string();
+
+    WorkloadTraceHeader header{};
+    std::memcpy(header.magic, kWorkloadFileMagic, sizeof(kWorkloadFileMagic));
+    header.version = kWorkloadFormatVersion;
+    header.vms_count = 1;
+    header.step = step;
+    header.samples_count = samples.size();
+
+    std::string names = "vm-1";
+    header.names_size = names.size();
+
+    WorkloadTraceVM vm{.start_ts = start_ts,
+                       .first_sample = 0,
+                       .samples_count = samples.size(),
+                       .name_offset = 0,
+                       .name_length = static_cast<uint32_t>(names.size())};
+
+    auto file = std::fopen(path.c_str(), "wb");
+    std::fwrite(&header, sizeof(header), 1, file);
+    std::fwrite(samples.data(), sizeof(WorkloadSample), samples.size(), file);
+    std::fwrite(&vm, sizeof(vm), 1, file);
+    std::fwrite(names.data(), 1, names.size(), file);
+    std::fclose(file);
+
+    return path;
+}
+
+/// Overwrites a field of the written trace
+template <typename T>
+void
+Patch(const std::string& path, size_t offset, T value)
+{
+    auto file = std::fopen(path.c_str(), "r+b");
+    std::fseek(file, static_cast<long>(offset), SEEK_SET);
+    std::fwrite(&value, sizeof(value), 1, file);
+    std::fclose(file);
+}
+
+TEST(WorkloadTraceTest, SamplesLastUntilTheNextOne)
+{
+    auto path = WriteTrace("workload-trace-test-hold.trace", 10, 5,
+                           {{100, 10, 1}, {200, 20, 2}, {300, 30, 3}});
+    WorkloadTrace trace{path};
+    auto vm = trace.FindVM("vm-1");
+
+    EXPECT_EQ(trace.GetSample(vm, 0, false).cpu, 10);
+    EXPECT_EQ(trace.GetSample(vm, 14, false).cpu, 10);
+    EXPECT_EQ(trace.GetSample(vm, 15, false).cpu, 20);
+    EXPECT_EQ(trace.GetSample(vm, 17, true).cpu, 24);
+    EXPECT_EQ(trace.GetSample(vm, 100, false).cpu, 30);
+
+    std::filesystem::remove(path);
+}
+
+TEST(WorkloadTraceTest, NextChange)
+{
+    auto path = WriteTrace("workload-trace-test-change.trace", 10, 5,
+                           {{100, 10, 1}, {200, 20, 2}, {300, 30, 3}});
+    WorkloadTrace trace{path};
+    auto vm = trace.FindVM("vm-1");
+
+    EXPECT_EQ(trace.GetNextChange(vm, 0, false), 15);
+    EXPECT_EQ(trace.GetNextChange(vm, 10, false), 15);
+    EXPECT_EQ(trace.GetNextChange(vm, 15, false), 20);
+    EXPECT_EQ(trace.GetNextChange(vm, 19, false), 20);
+    EXPECT_EQ(trace.GetNextChange(vm, 20, false), 0);
+
+    EXPECT_EQ(trace.GetNextChange(vm, 0, true), 11);
+    EXPECT_EQ(trace.GetNextChange(vm, 17, true), 18);
+    EXPECT_EQ(trace.GetNextChange(vm, 19, true), 20);
+    EXPECT_EQ(trace.GetNextChange(vm, 20, true), 0);
+
+    std::filesystem::remove(path);
+}
+
+TEST(WorkloadTraceTest, SingleSampleNeverChanges)
+{
+    auto path =
+        WriteTrace("workload-trace-test-single.trace", 10, 5, {{100, 10, 1}});
+    WorkloadTrace trace{path};
+    auto vm = trace.FindVM("vm-1");
+
+    EXPECT_EQ(trace.GetNextChange(vm, 0, false), 0);
+    EXPECT_EQ(trace.GetNextChange(vm, 0, true), 0);
+
+    std::filesystem::remove(path);
+}
+
+TEST(WorkloadTraceTest, RejectsWrappingSizes)
+{
+    constexpr auto kMax = std::numeric_limits<uint64_t>::max();
+
+    auto names_path = WriteTrace("workload-trace-test-names.trace", 10, 5,
+                                 {{100, 10, 1}, {200, 20, 2}});
+
+    // the end of the names wraps to the start of the file
+    auto names_offset = sizeof(WorkloadTraceHeader) +
+                        2 * sizeof(WorkloadSample) + sizeof(WorkloadTraceVM);
+    Patch(names_path, offsetof(WorkloadTraceHeader, names_size),
+          kMax - names_offset + 2);
+    EXPECT_THROW(WorkloadTrace{names_path}, std::runtime_error);
+
+    auto samples_path = WriteTrace("workload-trace-test-samples.trace", 10, 5,
+                                   {{100, 10, 1}, {200, 20, 2}});
+
+    // the end of the samples of the VM wraps to the first one
+    Patch(samples_path,
+          sizeof(WorkloadTraceHeader) + 2 * sizeof(WorkloadSample) +
+              offsetof(WorkloadTraceVM, first_sample),
+          kMax);
+    EXPECT_THROW(WorkloadTrace{samples_path}, std::runtime_error);
+
+    std::filesystem::remove(names_path);
+    std::filesystem::remove(samples_path);
+}
+
+}   // namespace
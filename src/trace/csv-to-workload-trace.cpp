@@ -0,0 +1,227 @@
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "workload-trace.h"
+
+/**
+ * Converts CSV utilization of VM-s to a workload trace:
+ * csv-to-workload-trace <input.csv> <output.trace> <step>
+ *
+ * The CSV has the header line and rows "vm,time,ram,cpu,io_bandwidth". Rows
+ * of a VM go together in increasing time. Samples are put to the grid of
+ * step ticks from the first row of the VM: the last row of a cell wins,
+ * missing cells repeat the previous sample. The input is streamed, only the
+ * table of VM-s is kept in memory.
+ */
+
+namespace {
+
+using namespace sim::trace;
+
+class WorkloadTraceConverter
+{
+ public:
+    WorkloadTraceConverter(const std::string& path, sim::TimeInterval step)
+        : step_(step)
+    {
+        if (step_ <= 0) {
+            throw std::invalid_argument("Step should be positive");
+        }
+
+        file_ = std::fopen(path.c_str(), "wb");
+        if (!file_) {
+            throw std::runtime_error("Cannot open workload trace " + path);
+        }
+
+        // the header is rewritten when the counts are known
+        WorkloadTraceHeader header{};
+        Write(&header, sizeof(header));
+    }
+
+    WorkloadTraceConverter(const WorkloadTraceConverter& other) = delete;
+
+    void Add(std::string_view vm_name, sim::TimeStamp time,
+             const WorkloadSample& sample)
+    {
+        if (vms_.empty() || vm_name != current_name_) {
+            Flush();
+
+            if (!seen_.insert(std::string{vm_name}).second) {
+                throw std::runtime_error("Rows of VM " +
+                                         std::string{vm_name} +
+                                         " should go together");
+            }
+
+            vms_.push_back({.start_ts = time,
+                            .first_sample = samples_count_,
+                            .samples_count = 0,
+                            .name_offset =
+                                static_cast<uint32_t>(names_.size()),
+                            .name_length =
+                                static_cast<uint32_t>(vm_name.size())});
+            names_ += vm_name;
+            current_name_ = vm_name;
+            pending_ = sample;
+            pending_cell_ = 0;
+            last_ts_ = time;
+            return;
+        }
+
+        if (time < last_ts_) {
+            throw std::runtime_error("Rows of VM " + current_name_ +
+                                     " should go in increasing time");
+        }
+
+        auto cell =
+            static_cast<uint64_t>((time - vms_.back().start_ts) / step_);
+        for (; pending_cell_ < cell; ++pending_cell_) {
+            WriteSample(pending_);
+        }
+        pending_ = sample;
+        last_ts_ = time;
+    }
+
+    void Finish()
+    {
+        Flush();
+
+        Write(vms_.data(), vms_.size() * sizeof(WorkloadTraceVM));
+        Write(names_.data(), names_.size());
+
+        WorkloadTraceHeader header{};
+        std::memcpy(header.magic, kWorkloadFileMagic,
+                    sizeof(kWorkloadFileMagic));
+        header.version = kWorkloadFormatVersion;
+        header.vms_count = static_cast<uint32_t>(vms_.size());
+        header.step = step_;
+        header.samples_count = samples_count_;
+        header.names_size = names_.size();
+
+        if (std::fseek(file_, 0, SEEK_SET) != 0) {
+            throw std::runtime_error("Cannot write workload trace");
+        }
+        Write(&header, sizeof(header));
+
+        if (std::fflush(file_) != 0) {
+            throw std::runtime_error("Cannot write workload trace");
+        }
+    }
+
+    ~WorkloadTraceConverter() { std::fclose(file_); }
+
+ private:
+    const sim::TimeInterval step_;
+    std::FILE* file_{};
+
+    std::vector<WorkloadTraceVM> vms_;
+    std::string names_;
+    std::unordered_set<std::string> seen_;
+    uint64_t samples_count_{};
+
+    /// The last sample of the current VM, it may be replaced by a later row
+    /// of the same cell
+    std::string current_name_;
+    WorkloadSample pending_{};
+    uint64_t pending_cell_{};
+    sim::TimeStamp last_ts_{};
+
+    void Write(const void* data, size_t size)
+    {
+        if (std::fwrite(data, 1, size, file_) != size) {
+            throw std::runtime_error("Cannot write workload trace");
+        }
+    }
+
+    void WriteSample(const WorkloadSample& sample)
+    {
+        Write(&sample, sizeof(sample));
+        ++samples_count_;
+        ++vms_.back().samples_count;
+    }
+
+    void Flush()
+    {
+        if (!vms_.empty()) {
+            WriteSample(pending_);
+        }
+    }
+};
+
+template <typename T>
+T
+ParseNumber(std::string_view field, size_t line)
+{
+    T value{};
+    auto [end, error] =
+        std::from_chars(field.data(), field.data() + field.size(), value);
+    if (error != std::errc{} || end != field.data() + field.size()) {
+        throw std::runtime_error("Invalid number \"" + std::string{field} +
+                                 "\" at line " + std::to_string(line));
+    }
+
+    return value;
+}
+
+}   // namespace
+
+int
+main(int argc, char** argv)
+{
+    if (argc != 4) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <input.csv> <output.trace> <step>\n";
+        return 1;
+    }
+
+    try {
+        std::ifstream input{argv[1]};
+        if (!input) {
+            throw std::runtime_error(std::string{"Cannot open "} + argv[1]);
+        }
+
+        WorkloadTraceConverter converter{argv[2], std::stoll(argv[3])};
+
+        std::string row;
+        std::getline(input, row);   // header
+
+        for (size_t line = 2; std::getline(input, row); ++line) {
+            if (!row.empty() && row.back() == '\r') {
+                row.pop_back();
+            }
+            if (row.empty()) {
+                continue;
+            }
+
+            std::string_view fields[5];
+            std::string_view rest = row;
+            for (size_t i = 0; i < 5; ++i) {
+                auto comma = rest.find(',');
+                if ((comma == std::string_view::npos) != (i == 4)) {
+                    throw std::runtime_error("Expected 5 fields at line " +
+                                             std::to_string(line));
+                }
+                fields[i] = rest.substr(0, comma);
+                rest.remove_prefix(i == 4 ? rest.size() : comma + 1);
+            }
+
+            converter.Add(
+                fields[0], ParseNumber<sim::TimeStamp>(fields[1], line),
+                {.ram = ParseNumber<uint64_t>(fields[2], line),
+                 .cpu = ParseNumber<uint32_t>(fields[3], line),
+                 .io_bandwidth = ParseNumber<uint32_t>(fields[4], line)});
+        }
+
+        converter.Finish();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
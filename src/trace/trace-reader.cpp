@@ -0,0 +1,138 @@
+#include "trace-reader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+
+sim::trace::TraceRecord
+sim::trace::TraceChunk::GetRecord(size_t i) const
+{
+    TraceRecord record{};
+
+    record.ts = ts[i];
+    record.actor = UnpackUUID(actor[i]);
+    record.subject = UnpackUUID(subject[i]);
+    record.type = static_cast<RecordType>(type[i]);
+    record.old_state = old_state[i];
+    record.new_state = new_state[i];
+    record.ram = ram[i];
+    record.cpu = cpu[i];
+    record.io_bandwidth = io_bandwidth[i];
+
+    return record;
+}
+
+sim::trace::TraceReader::TraceReader(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open trace file " + path);
+    }
+
+    struct stat file_stat{};
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot stat trace file " + path);
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+
+    if (size_ < sizeof(FileHeader)) {
+        close(fd);
+        throw std::runtime_error("Invalid trace file " + path);
+    }
+
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Cannot map trace file " + path);
+    }
+    data_ = static_cast<const std::byte*>(data);
+
+    const auto* header = reinterpret_cast<const FileHeader*>(data_);
+    if (std::memcmp(header->magic, kFileMagic, sizeof(kFileMagic)) != 0 ||
+        header->version != kFormatVersion) {
+        munmap(const_cast<std::byte*>(data_), size_);
+        throw std::runtime_error("Invalid trace file " + path);
+    }
+
+    ParseChunks();
+}
+
+std::string_view
+sim::trace::TraceReader::GetActorName(UUID actor) const
+{
+    if (auto it = names_.find(PackUUID(actor)); it != names_.end()) {
+        return it->second;
+    }
+
+    return {};
+}
+
+sim::trace::TraceReader::~TraceReader()
+{
+    munmap(const_cast<std::byte*>(data_), size_);
+}
+
+namespace {
+
+/// Takes the next column of count values and moves the position
+template <typename T>
+std::span<const T>
+TakeColumn(const std::byte*& position, size_t count)
+{
+    std::span<const T> column{reinterpret_cast<const T*>(position), count};
+    position += sim::trace::AlignedSize(count * sizeof(T));
+
+    return column;
+}
+
+}   // namespace
+
+void
+sim::trace::TraceReader::ParseChunks()
+{
+    size_t offset = sizeof(FileHeader);
+
+    while (offset + sizeof(ChunkHeader) <= size_) {
+        const auto* header =
+            reinterpret_cast<const ChunkHeader*>(data_ + offset);
+        // counts of a corrupted header may point past the chunk
+        if (header->magic != kChunkMagic ||
+            header->size > size_ - offset - sizeof(ChunkHeader) ||
+            ChunkColumnsSize(*header) > header->size) {
+            break;
+        }
+
+        const auto* position = data_ + offset + sizeof(ChunkHeader);
+        size_t count = header->records_count;
+
+        // the order should match TraceWriter::WriteChunk
+        auto& chunk = chunks_.emplace_back();
+        chunk.size = count;
+        chunk.ts = TakeColumn<int64_t>(position, count);
+        chunk.actor = TakeColumn<uint64_t>(position, count);
+        chunk.subject = TakeColumn<uint64_t>(position, count);
+        chunk.ram = TakeColumn<uint64_t>(position, count);
+        chunk.cpu = TakeColumn<uint32_t>(position, count);
+        chunk.io_bandwidth = TakeColumn<uint32_t>(position, count);
+        chunk.type = TakeColumn<uint8_t>(position, count);
+        chunk.old_state = TakeColumn<uint8_t>(position, count);
+        chunk.new_state = TakeColumn<uint8_t>(position, count);
+
+        auto entries = TakeColumn<NameEntry>(position, header->names_count);
+        const auto* names_data = reinterpret_cast<const char*>(position);
+
+        for (const auto& entry : entries) {
+            if (uint64_t{entry.offset} + entry.length <= header->names_size) {
+                names_[entry.actor] = {names_data + entry.offset, entry.length};
+            }
+        }
+
+        offset += sizeof(ChunkHeader) + header->size;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "trace.h"
+
+namespace sim::trace {
+
+/**
+ * Columns of one chunk, they point directly to the mapped file
+ */
+struct TraceChunk
+{
+    size_t size{};
+
+    std::span<const int64_t> ts;
+    std::span<const uint64_t> actor, subject, ram;
+    std::span<const uint32_t> cpu, io_bandwidth;
+    std::span<const uint8_t> type, old_state, new_state;
+
+    TraceRecord GetRecord(size_t i) const;
+};
+
+/**
+ * Maps the trace file into memory, reading stops at a truncated or corrupted
+ * chunk
+ */
+class TraceReader
+{
+ public:
+    explicit TraceReader(const std::string& path);
+
+    TraceReader(const TraceReader& other) = delete;
+    TraceReader& operator=(const TraceReader& other) = delete;
+
+    const std::vector<TraceChunk>& GetChunks() const { return chunks_; }
+
+    /// Empty if the actor is unknown
+    std::string_view GetActorName(UUID actor) const;
+
+    ~TraceReader();
+
+ private:
+    void ParseChunks();
+
+    const std::byte* data_{};
+    size_t size_{};
+
+    std::vector<TraceChunk> chunks_;
+    std::unordered_map<uint64_t, std::string_view> names_;
+};
+
+}   // namespace sim::trace
@@ -0,0 +1,45 @@
+#include <fmt/core.h>
+#include <fmt/os.h>
+
+#include <iostream>
+#include <stdexcept>
+
+#include "trace-reader.h"
+
+/**
+ * Exports binary trace to CSV: trace-to-csv <input.trace> <output.csv>
+ */
+int
+main(int argc, char** argv)
+{
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <input.trace> <output.csv>\n";
+        return 1;
+    }
+
+    try {
+        sim::trace::TraceReader reader{argv[1]};
+        auto output = fmt::output_file(argv[2]);
+
+        output.print(
+            "time,actor,name,type,subject,subject_name,old_state,new_state,"
+            "ram,cpu,io_bandwidth\n");
+
+        for (const auto& chunk : reader.GetChunks()) {
+            for (size_t i = 0; i < chunk.size; ++i) {
+                auto record = chunk.GetRecord(i);
+
+                output.print("{},{},{},{},{},{},{},{},{},{},{}\n", record.ts,
+                             record.actor, reader.GetActorName(record.actor),
+                             sim::trace::RecordTypeToString(record.type),
+                             record.subject,
+                             reader.GetActorName(record.subject),
+                             record.old_state, record.new_state, record.ram,
+                             record.cpu, record.io_bandwidth);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
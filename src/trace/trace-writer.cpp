@@ -0,0 +1,161 @@
+#include "trace-writer.h"
+
+#include <cstring>
+#include <stdexcept>
+
+sim::trace::TraceWriter::TraceWriter()
+    : ts_(new int64_t[kChunkCapacity]),
+      actor_(new uint64_t[kChunkCapacity]),
+      subject_(new uint64_t[kChunkCapacity]),
+      ram_(new uint64_t[kChunkCapacity]),
+      cpu_(new uint32_t[kChunkCapacity]),
+      io_bandwidth_(new uint32_t[kChunkCapacity]),
+      type_(new uint8_t[kChunkCapacity]),
+      old_state_(new uint8_t[kChunkCapacity]),
+      new_state_(new uint8_t[kChunkCapacity])
+{
+}
+
+void
+sim::trace::TraceWriter::Open(const std::string& path)
+{
+    Close();
+
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        throw std::runtime_error("Cannot open trace file " + path);
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+    header.version = kFormatVersion;
+
+    std::fwrite(&header, sizeof(header), 1, file_);
+}
+
+void
+sim::trace::TraceWriter::Close()
+{
+    if (!file_) {
+        return;
+    }
+
+    Flush();
+    std::fclose(file_);
+    file_ = nullptr;
+
+    named_.clear();
+}
+
+void
+sim::trace::TraceWriter::Write(const TraceRecord& record,
+                               std::string_view actor_name)
+{
+    if (thread_capture_) {
+        thread_capture_->records.emplace_back(record, actor_name);
+        return;
+    }
+
+    InternName(record.actor, actor_name);
+
+    ts_[size_] = record.ts;
+    actor_[size_] = PackUUID(record.actor);
+    subject_[size_] = PackUUID(record.subject);
+    ram_[size_] = record.ram;
+    cpu_[size_] = record.cpu;
+    io_bandwidth_[size_] = record.io_bandwidth;
+    type_[size_] = static_cast<uint8_t>(record.type);
+    old_state_[size_] = record.old_state;
+    new_state_[size_] = record.new_state;
+
+    if (++size_ == kChunkCapacity) {
+        WriteChunk();
+    }
+}
+
+void
+sim::trace::TraceWriter::Replay(TraceCapture& capture)
+{
+    for (const auto& [record, actor_name] : capture.records) {
+        Write(record, actor_name);
+    }
+    capture.records.clear();
+}
+
+void
+sim::trace::TraceWriter::Flush()
+{
+    if (!file_) {
+        return;
+    }
+
+    if (size_ > 0) {
+        WriteChunk();
+    }
+    std::fflush(file_);
+}
+
+sim::trace::TraceWriter::~TraceWriter()
+{
+    Close();
+}
+
+void
+sim::trace::TraceWriter::InternName(UUID actor, std::string_view name)
+{
+    auto index = actor.Index();
+    if (index < named_.size() && named_[index] == actor.Generation() + 1) {
+        return;
+    }
+
+    if (index >= named_.size()) {
+        named_.resize(index + 1);
+    }
+    named_[index] = actor.Generation() + 1;
+
+    names_.push_back({PackUUID(actor),
+                      static_cast<uint32_t>(names_data_.size()),
+                      static_cast<uint32_t>(name.size())});
+    names_data_.append(name);
+}
+
+template <typename T>
+void
+sim::trace::TraceWriter::WriteColumn(const T* data, size_t count)
+{
+    static constexpr char kPadding[8]{};
+
+    auto size = count * sizeof(T);
+    std::fwrite(data, 1, size, file_);
+    std::fwrite(kPadding, 1, AlignedSize(size) - size, file_);
+}
+
+void
+sim::trace::TraceWriter::WriteChunk()
+{
+    ChunkHeader header{};
+    header.magic = kChunkMagic;
+    header.records_count = size_;
+    header.names_count = static_cast<uint32_t>(names_.size());
+    header.names_size = static_cast<uint32_t>(names_data_.size());
+    header.size = ChunkColumnsSize(header);
+
+    std::fwrite(&header, sizeof(header), 1, file_);
+
+    // the order should match TraceReader
+    WriteColumn(ts_.get(), size_);
+    WriteColumn(actor_.get(), size_);
+    WriteColumn(subject_.get(), size_);
+    WriteColumn(ram_.get(), size_);
+    WriteColumn(cpu_.get(), size_);
+    WriteColumn(io_bandwidth_.get(), size_);
+    WriteColumn(type_.get(), size_);
+    WriteColumn(old_state_.get(), size_);
+    WriteColumn(new_state_.get(), size_);
+    WriteColumn(names_.data(), names_.size());
+    WriteColumn(names_data_.data(), names_data_.size());
+
+    size_ = 0;
+    names_.clear();
+    names_data_.clear();
+}
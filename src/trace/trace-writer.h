@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "trace.h"
+
+namespace sim::trace {
+
+/// Records of one thread kept aside to be written later
+struct TraceCapture
+{
+    std::vector<std::pair<TraceRecord, std::string_view>> records;
+};
+
+/**
+ * Appends records to the trace file in columnar chunks of kChunkCapacity
+ * records. Columns are allocated once, so writing a record does not allocate
+ * memory except for the first record of a new actor.
+ *
+ * Simulations running in parallel threads of one process should have own
+ * writers set with SetThreadWriter.
+ */
+class TraceWriter
+{
+ public:
+    TraceWriter();
+
+    TraceWriter(const TraceWriter& other) = delete;
+
+    /// Writer of the calling thread, the global one if it is not set
+    static TraceWriter& GetWriter()
+    {
+        if (thread_writer_) {
+            return *thread_writer_;
+        }
+
+        static TraceWriter writer{};
+
+        return writer;
+    }
+
+    /**
+     * GetWriter() of the calling thread returns the writer until it is reset
+     * with nullptr
+     */
+    static void SetThreadWriter(TraceWriter* writer)
+    {
+        thread_writer_ = writer;
+    }
+
+    /// Starts a new trace file, the previous one is flushed and closed
+    void Open(const std::string& path);
+    void Close();
+
+    bool IsOpen() const { return file_ != nullptr; }
+
+    void Write(const TraceRecord& record, std::string_view actor_name);
+
+    /**
+     * Records of the calling thread go to the capture until it is reset with
+     * nullptr, the actor should stay alive until the replay
+     */
+    static void SetThreadCapture(TraceCapture* capture)
+    {
+        thread_capture_ = capture;
+    }
+
+    /// Writes captured records and clears the capture
+    void Replay(TraceCapture& capture);
+
+    /// Writes the current chunk even if it is not full
+    void Flush();
+
+    ~TraceWriter();
+
+ private:
+    static constexpr uint32_t kChunkCapacity = 1 << 16;
+
+    void InternName(UUID actor, std::string_view name);
+    void WriteChunk();
+
+    template <typename T>
+    void WriteColumn(const T* data, size_t count);
+
+    static inline thread_local TraceWriter* thread_writer_{};
+    static inline thread_local TraceCapture* thread_capture_{};
+
+    std::FILE* file_{};
+
+    uint32_t size_{};
+    std::unique_ptr<int64_t[]> ts_;
+    std::unique_ptr<uint64_t[]> actor_, subject_, ram_;
+    std::unique_ptr<uint32_t[]> cpu_, io_bandwidth_;
+    std::unique_ptr<uint8_t[]> type_, old_state_, new_state_;
+
+    /// Generation + 1 of the actor whose name is written, by UUID index
+    std::vector<uint32_t> named_;
+
+    std::vector<NameEntry> names_;
+    std::string names_data_;
+};
+
+}   // namespace sim::trace
@@ -0,0 +1,20 @@
+#include "trace.h"
+
+std::string_view
+sim::trace::RecordTypeToString(RecordType type)
+{
+    switch (type) {
+        case RecordType::kVMState:
+            return "VM_STATE";
+        case RecordType::kPowerState:
+            return "POWER_STATE";
+        case RecordType::kVMProvisioned:
+            return "VM_PROVISIONED";
+        case RecordType::kVMUnprovisioned:
+            return "VM_UNPROVISIONED";
+        case RecordType::kServerWorkload:
+            return "SERVER_WORKLOAD";
+        default:
+            return "UNKNOWN";
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+#include "types.h"
+
+namespace sim::trace {
+
+/**
+ * Binary trace file layout (little-endian, all sections are 8-byte aligned):
+ *
+ *   FileHeader
+ *   ChunkHeader, columns of records_count values in the order of
+ *   TraceWriter::WriteChunk, names_count NameEntry, name characters
+ *   ChunkHeader, ...
+ *
+ * Each chunk is self-contained except actor names: the name of an actor is
+ * stored in the first chunk referencing it. Chunks are only appended, so a
+ * file being written can be read up to the last complete chunk.
+ */
+enum class RecordType : uint8_t
+{
+    kVMState,          // old_state, new_state are VMState values
+    kPowerState,       // old_state, new_state are PowerState values
+    kVMProvisioned,    // subject is the VM, resources are server workload
+    kVMUnprovisioned,  // subject is the VM, resources are server workload
+    kServerWorkload,   // resources are server workload
+};
+
+std::string_view RecordTypeToString(RecordType type);
+
+struct TraceRecord
+{
+    TimeStamp ts{};
+    UUID actor{};
+    UUID subject{};
+    RecordType type{};
+    uint8_t old_state{};
+    uint8_t new_state{};
+    uint64_t ram{};
+    uint32_t cpu{};
+    uint32_t io_bandwidth{};
+};
+
+inline constexpr char kFileMagic[8] = {'S', 'I', 'M', 'T', 'R', 'A', 'C', 'E'};
+inline constexpr uint32_t kFormatVersion = 1;
+inline constexpr uint32_t kChunkMagic = 0x434d4953;   // "SIMC"
+
+struct FileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+};
+
+struct ChunkHeader
+{
+    uint32_t magic;
+    uint32_t records_count;
+    uint32_t names_count;
+    uint32_t names_size;
+
+    /// Size of the chunk after the header
+    uint64_t size;
+};
+
+/// Actor handles are stored as (generation << 32 | index)
+struct NameEntry
+{
+    uint64_t actor;
+    uint32_t offset;
+    uint32_t length;
+};
+
+inline uint64_t
+PackUUID(UUID uuid)
+{
+    return static_cast<uint64_t>(uuid.Generation()) << 32 | uuid.Index();
+}
+
+inline UUID
+UnpackUUID(uint64_t packed)
+{
+    return UUID{static_cast<uint32_t>(packed),
+                static_cast<uint32_t>(packed >> 32)};
+}
+
+inline constexpr uint64_t
+AlignedSize(uint64_t size)
+{
+    return (size + 7) & ~uint64_t{7};
+}
+
+/// Bytes of the columns, entries and names of a chunk after its header
+inline uint64_t
+ChunkColumnsSize(const ChunkHeader& header)
+{
+    uint64_t count = header.records_count;
+
+    return AlignedSize(count * sizeof(int64_t)) +
+           3 * AlignedSize(count * sizeof(uint64_t)) +
+           2 * AlignedSize(count * sizeof(uint32_t)) +
+           3 * AlignedSize(count * sizeof(uint8_t)) +
+           AlignedSize(uint64_t{header.names_count} * sizeof(NameEntry)) +
+           AlignedSize(header.names_size);
+}
+
+}   // namespace sim::trace
@@ -0,0 +1,173 @@
+#include "workload-trace.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+sim::trace::WorkloadTrace::WorkloadTrace(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open workload trace " + path);
+    }
+
+    struct stat file_stat{};
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot stat workload trace " + path);
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+
+    if (size_ < sizeof(WorkloadTraceHeader)) {
+        close(fd);
+        throw std::runtime_error("Invalid workload trace " + path);
+    }
+
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Cannot map workload trace " + path);
+    }
+    data_ = static_cast<const std::byte*>(data);
+
+    // lookups jump between VM-s, read-ahead of neighbour pages is useless
+    madvise(data, size_, MADV_RANDOM);
+
+    const auto* header = reinterpret_cast<const WorkloadTraceHeader*>(data_);
+    auto samples_offset = sizeof(WorkloadTraceHeader);
+    auto vms_offset =
+        samples_offset + header->samples_count * sizeof(WorkloadSample);
+    auto names_offset =
+        vms_offset + header->vms_count * sizeof(WorkloadTraceVM);
+
+    // sizes are compared by subtraction, so corrupted ones do not wrap
+    if (std::memcmp(header->magic, kWorkloadFileMagic,
+                    sizeof(kWorkloadFileMagic)) != 0 ||
+        header->version != kWorkloadFormatVersion || header->step <= 0 ||
+        header->samples_count > size_ / sizeof(WorkloadSample) ||
+        header->vms_count > size_ / sizeof(WorkloadTraceVM) ||
+        names_offset > size_ || header->names_size > size_ - names_offset) {
+        munmap(const_cast<std::byte*>(data_), size_);
+        throw std::runtime_error("Invalid workload trace " + path);
+    }
+
+    step_ = header->step;
+    samples_ = {reinterpret_cast<const WorkloadSample*>(data_ + samples_offset),
+                header->samples_count};
+    vms_ = {reinterpret_cast<const WorkloadTraceVM*>(data_ + vms_offset),
+            header->vms_count};
+
+    const auto* names = reinterpret_cast<const char*>(data_ + names_offset);
+    for (uint32_t i = 0; i < vms_.size(); ++i) {
+        const auto& vm = vms_[i];
+        if (uint64_t{vm.name_offset} + vm.name_length > header->names_size ||
+            vm.samples_count == 0 ||
+            vm.first_sample > samples_.size() ||
+            vm.samples_count > samples_.size() - vm.first_sample) {
+            munmap(const_cast<std::byte*>(data_), size_);
+            throw std::runtime_error("Invalid workload trace " + path);
+        }
+        names_[{names + vm.name_offset, vm.name_length}] = i;
+    }
+}
+
+std::shared_ptr<const sim::trace::WorkloadTrace>
+sim::trace::WorkloadTrace::Open(const std::string& path)
+{
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::weak_ptr<const WorkloadTrace>>
+        traces;
+
+    std::lock_guard lock{mutex};
+
+    auto& trace = traces[path];
+    if (auto mapped = trace.lock()) {
+        return mapped;
+    }
+
+    auto mapped = std::make_shared<const WorkloadTrace>(path);
+    trace = mapped;
+
+    return mapped;
+}
+
+uint32_t
+sim::trace::WorkloadTrace::FindVM(std::string_view name) const
+{
+    if (auto it = names_.find(name); it != names_.end()) {
+        return it->second;
+    }
+
+    throw std::invalid_argument("VM " + std::string{name} +
+                                " not found in the workload trace");
+}
+
+sim::trace::WorkloadSample
+sim::trace::WorkloadTrace::GetSample(uint32_t vm, TimeStamp time,
+                                     bool interpolate) const
+{
+    const auto& entry = vms_[vm];
+    const auto* samples = samples_.data() + entry.first_sample;
+
+    if (time <= entry.start_ts) {
+        return samples[0];
+    }
+
+    auto offset = time - entry.start_ts;
+    auto index = static_cast<uint64_t>(offset / step_);
+    if (index + 1 >= entry.samples_count) {
+        return samples[entry.samples_count - 1];
+    }
+
+    const auto& sample = samples[index];
+    auto fraction = offset % step_;
+    if (!interpolate || fraction == 0) {
+        return sample;
+    }
+
+    const auto& next = samples[index + 1];
+    auto lerp = [fraction, this](auto from, auto to) {
+        auto delta = static_cast<int64_t>(to) - static_cast<int64_t>(from);
+        return static_cast<decltype(from)>(static_cast<int64_t>(from) +
+                                           delta * fraction / step_);
+    };
+
+    return {lerp(sample.ram, next.ram), lerp(sample.cpu, next.cpu),
+            lerp(sample.io_bandwidth, next.io_bandwidth)};
+}
+
+sim::TimeStamp
+sim::trace::WorkloadTrace::GetNextChange(uint32_t vm, TimeStamp time,
+                                         bool interpolate) const
+{
+    const auto& entry = vms_[vm];
+    if (entry.samples_count < 2) {
+        return 0;
+    }
+
+    auto last_ts = entry.start_ts +
+                   static_cast<TimeInterval>(entry.samples_count - 1) * step_;
+    if (time >= last_ts) {
+        return 0;
+    }
+
+    if (interpolate) {
+        return std::max(time, entry.start_ts) + 1;
+    }
+
+    // the sample of the time lasts until the next one
+    auto index = time <= entry.start_ts ? 0 : (time - entry.start_ts) / step_;
+    return entry.start_ts + (index + 1) * step_;
+}
+
+sim::trace::WorkloadTrace::~WorkloadTrace()
+{
+    munmap(const_cast<std::byte*>(data_), size_);
+}
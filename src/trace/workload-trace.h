@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "types.h"
+
+namespace sim::trace {
+
+/**
+ * Binary file of resource utilization of VM-s for replaying real workloads
+ * (little-endian, all sections are 8-byte aligned):
+ *
+ *   WorkloadTraceHeader
+ *   samples_count WorkloadSample, samples of each VM go together
+ *   vms_count WorkloadTraceVM
+ *   names_size name characters
+ *
+ * Samples of a VM are taken every step ticks from start_ts, so the sample of
+ * a time is found by its index without search. The file is written by
+ * csv-to-workload-trace.
+ */
+struct WorkloadSample
+{
+    uint64_t ram;
+    uint32_t cpu;
+    uint32_t io_bandwidth;
+};
+
+struct WorkloadTraceVM
+{
+    TimeStamp start_ts;
+
+    /// Index of the first sample of the VM in the samples section
+    uint64_t first_sample;
+    uint64_t samples_count;
+
+    uint32_t name_offset;
+    uint32_t name_length;
+};
+
+inline constexpr char kWorkloadFileMagic[8] = {'S', 'I', 'M', 'W',
+                                               'L', 'O', 'A', 'D'};
+inline constexpr uint32_t kWorkloadFormatVersion = 1;
+
+struct WorkloadTraceHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t vms_count;
+
+    /// Ticks between samples
+    TimeInterval step;
+
+    uint64_t samples_count;
+    uint64_t names_size;
+};
+
+/**
+ * Read-only mapping of a workload trace file. Open() shares one mapping of a
+ * file between all its users
+ */
+class WorkloadTrace
+{
+ public:
+    explicit WorkloadTrace(const std::string& path);
+
+    WorkloadTrace(const WorkloadTrace& other) = delete;
+    WorkloadTrace& operator=(const WorkloadTrace& other) = delete;
+
+    /// Maps the file or returns the mapping already used by someone
+    static std::shared_ptr<const WorkloadTrace> Open(const std::string& path);
+
+    /// Index of the VM with the given name, throws if it is absent
+    uint32_t FindVM(std::string_view name) const;
+
+    /**
+     * Utilization of the VM at the time, the first and the last samples
+     * last before and after the trace. Between samples it is the previous
+     * one or, if interpolate is set, a linear interpolation
+     */
+    WorkloadSample GetSample(uint32_t vm, TimeStamp time,
+                             bool interpolate) const;
+
+    /**
+     * The earliest time after the given one when the utilization of the VM
+     * differs from the one at the given time, 0 after the last sample
+     */
+    TimeStamp GetNextChange(uint32_t vm, TimeStamp time,
+                            bool interpolate) const;
+
+    TimeInterval GetStep() const { return step_; }
+
+    ~WorkloadTrace();
+
+ private:
+    const std::byte* data_{};
+    size_t size_{};
+
+    TimeInterval step_{};
+    std::span<const WorkloadSample> samples_;
+    std::span<const WorkloadTraceVM> vms_;
+    std::unordered_map<std::string_view, uint32_t> names_;
+};
+
+}   // namespace sim::trace
@@ -4,12 +4,33 @@
 #include <fmt/core.h>
 #include <fmt/os.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
 #include <ctime>
 #include <functional>
+#include <iterator>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
 #include "types.h"
 
+/**
+ * Messages with greater severity are compiled out by SIM_LOG,
+ * 0 - error, 1 - info, 2 - debug
+ */
+#ifndef SIM_LOG_MAX_SEVERITY
+#define SIM_LOG_MAX_SEVERITY 2
+#endif
+
 namespace sim {
 
 enum class LogSeverity : int32_t
@@ -38,30 +59,102 @@ typedef std::function<void(TimeStamp, LogSeverity, std::string_view,
                            std::string_view, std::string_view)>
     LoggingCallback;
 
+/**
+ * What a producer does when the log buffer is full
+ */
+enum class LogOverflowPolicy
+{
+    kBlock,
+    kDrop,
+};
+
+/**
+ * Log records of one thread kept aside to be written later, strings keep
+ * their capacity between uses
+ */
+struct LogCapture
+{
+    struct Entry
+    {
+        TimeStamp ts{};
+        LogSeverity severity{};
+        std::string caller_type, caller_name, text;
+    };
+
+    std::vector<Entry> entries;
+    size_t size{};
+};
+
+/**
+ * Log records are put into a lock-free single-producer ring buffer with
+ * unformatted arguments, a background writer thread formats them and passes
+ * to console, CSV-file and additional callbacks.
+ *
+ * Log and LogNow should be called from one thread at a time (the simulation
+ * thread), other threads should capture their records with SetThreadCapture.
+ * Everything written before Flush() call or logger destruction is guaranteed
+ * to reach all sinks.
+ *
+ * Simulations running in parallel threads of one process should have own
+ * loggers set with SetThreadLogger.
+ */
 class SimulatorLogger
 {
  public:
+    SimulatorLogger() : records_(kCapacity)
+    {
+        writer_ = std::thread([this] { WriterLoop(); });
+    }
+
+    SimulatorLogger(const SimulatorLogger& other) = delete;
+
+    /// Logger of the calling thread, the global one if it is not set
     static SimulatorLogger& GetLogger()
     {
+        if (thread_logger_) {
+            return *thread_logger_;
+        }
+
         static SimulatorLogger logger{};
 
         return logger;
     }
 
+    /**
+     * GetLogger() of the calling thread returns the logger until it is reset
+     * with nullptr
+     */
+    static void SetThreadLogger(SimulatorLogger* logger)
+    {
+        thread_logger_ = logger;
+    }
+
     void SetCSVFolder(std::string_view path_to_csv_folder)
     {
+        Flush();
+
+        std::lock_guard lock{sinks_mutex_};
         csv_file_name_ = std::string{path_to_csv_folder} + "/" +
                          std::to_string(time(nullptr)) + ".csv";
+        csv_file_stream_.reset();
+        UpdateMaxSeverityLocked();
     }
 
     void SetMaxConsoleSeverity(LogSeverity max_severity)
     {
-        max_console_severity = max_severity;
+        max_console_severity.store(max_severity, std::memory_order_relaxed);
+        UpdateMaxSeverity();
     }
 
     void SetMaxCSVSeverity(LogSeverity max_severity)
     {
-        max_csv_severity = max_severity;
+        max_csv_severity.store(max_severity, std::memory_order_relaxed);
+        UpdateMaxSeverity();
+    }
+
+    void SetOverflowPolicy(LogOverflowPolicy policy)
+    {
+        overflow_policy_ = policy;
     }
 
     void SetTimeCallback(NowFunction now_function)
@@ -69,12 +162,62 @@ class SimulatorLogger
         now = std::move(now_function);
     }
 
-    void PushLoggingCallback(LoggingCallback logging_callback)
+    /**
+     * Callbacks are called from the writer thread, the buffer is flushed
+     * before the list is changed, so a callback is never called after its
+     * removal
+     */
+    void PushLoggingCallback(LoggingCallback logging_callback,
+                             LogSeverity max_severity = LogSeverity::kDebug)
+    {
+        Flush();
+
+        std::lock_guard lock{sinks_mutex_};
+        callbacks_.push_back({std::move(logging_callback), max_severity});
+        UpdateMaxSeverityLocked();
+    }
+
+    void PopLoggingCallback()
+    {
+        Flush();
+
+        std::lock_guard lock{sinks_mutex_};
+        callbacks_.pop_back();
+        UpdateMaxSeverityLocked();
+    }
+
+    /**
+     * Records of the calling thread go to the capture instead of the buffer
+     * until the capture is reset with nullptr. Records are formatted by the
+     * calling thread
+     */
+    static void SetThreadCapture(LogCapture* capture)
+    {
+        thread_capture_ = capture;
+    }
+
+    /// Writes captured records and clears the capture
+    void Replay(LogCapture& capture)
+    {
+        for (size_t i = 0; i < capture.size; ++i) {
+            const auto& entry = capture.entries[i];
+            Log(entry.ts, entry.severity, entry.caller_type, entry.caller_name,
+                "{}", entry.text);
+        }
+        capture.size = 0;
+    }
+
+    /// Whether any sink accepts messages of this severity
+    bool ShouldLog(LogSeverity severity) const
     {
-        callbacks_.push_back(std::move(logging_callback));
+        return severity <= max_severity_.load(std::memory_order_relaxed);
     }
 
-    void PopLoggingCallback() { callbacks_.pop_back(); }
+    /// Number of records lost with LogOverflowPolicy::kDrop
+    uint64_t GetDroppedCount() const
+    {
+        return dropped_.load(std::memory_order_relaxed);
+    }
 
     template <typename... Args>
     void LogNow(LogSeverity severity, std::string_view caller_type,
@@ -85,75 +228,381 @@ class SimulatorLogger
             std::forward<Args>(args)...);
     }
 
+    /**
+     * @param format_string should outlive the record, e.g. be a literal
+     */
     template <typename... Args>
     void Log(TimeStamp ts, LogSeverity severity, std::string_view caller_type,
              std::string_view caller_name, std::string_view format_string,
              Args&&... args)
     {
-        auto text = fmt::format(format_string, std::forward<Args>(args)...);
+        if (!ShouldLog(severity)) {
+            return;
+        }
 
-        // standard callbacks
-        GetPrintToConsoleCallback()(ts, severity, caller_type, caller_name,
-                                    text);
-        GetWriteToCSVCallback()(ts, severity, caller_type, caller_name, text);
+        if (thread_capture_) {
+            auto& capture = *thread_capture_;
+            if (capture.size == capture.entries.size()) {
+                capture.entries.emplace_back();
+            }
 
-        // additional callbacks, e.g. passing to gRPC stream
-        for (const auto& cb : callbacks_) {
-            cb(ts, severity, caller_type, caller_name, text);
+            auto& entry = capture.entries[capture.size++];
+            entry.ts = ts;
+            entry.severity = severity;
+            entry.caller_type.assign(caller_type);
+            entry.caller_name.assign(caller_name);
+            entry.text.clear();
+            fmt::format_to(std::back_inserter(entry.text), format_string,
+                           std::forward<Args>(args)...);
+            return;
         }
+
+        auto record = AcquireRecord();
+        if (!record) {
+            return;
+        }
+
+        record->ts = ts;
+        record->severity = severity;
+        record->caller_type.assign(caller_type);
+        record->caller_name.assign(caller_name);
+        record->format_string = format_string;
+
+        using Captured = std::tuple<CapturedArg<Args>...>;
+
+        if constexpr (sizeof(Captured) <= kMaxCapturedSize &&
+                      alignof(Captured) <= alignof(std::max_align_t)) {
+            new (record->args) Captured(std::forward<Args>(args)...);
+            record->format = &FormatCaptured<Captured>;
+        } else {
+            record->text.clear();
+            fmt::format_to(std::back_inserter(record->text), format_string,
+                           std::forward<Args>(args)...);
+            record->format = nullptr;
+        }
+
+        Publish();
+    }
+
+    /// Waits until all written records are passed to sinks
+    void Flush()
+    {
+        auto target = head_.load(std::memory_order_relaxed);
+
+        WakeWriter(true);
+
+        auto flushed = flushed_.load(std::memory_order_acquire);
+        while (flushed < target) {
+            flushed_.wait(flushed, std::memory_order_acquire);
+            flushed = flushed_.load(std::memory_order_acquire);
+        }
+    }
+
+    ~SimulatorLogger()
+    {
+        stop_.store(true);
+        WakeWriter(true);
+
+        writer_.join();
     }
 
  private:
-    SimulatorLogger() = default;
+    static constexpr size_t kCapacity = 8192;
+    static constexpr size_t kMaxCapturedSize = 128;
+    static constexpr size_t kPollIterations = 64;
 
-    std::string csv_file_name_{};
+    /**
+     * Strings are copied, since names of actors may die before the record is
+     * written
+     */
+    template <typename T>
+    using CapturedArg =
+        std::conditional_t<std::is_convertible_v<const T&, std::string_view>,
+                           std::string, std::decay_t<T>>;
 
-    NowFunction now{};
+    struct Record
+    {
+        TimeStamp ts{};
+        LogSeverity severity{};
 
-    LogSeverity max_console_severity{LogSeverity::kDebug},
-        max_csv_severity{LogSeverity::kDebug};
+        // strings keep their capacity between records
+        std::string caller_type, caller_name;
+        std::string_view format_string;
+
+        /// Formats captured arguments and destroys them, nullptr if text is
+        /// already formatted
+        void (*format)(Record&, fmt::memory_buffer&){};
+        alignas(std::max_align_t) std::byte args[kMaxCapturedSize];
+
+        std::string text;
+    };
+
+    template <typename Captured>
+    static void FormatCaptured(Record& record, fmt::memory_buffer& out)
+    {
+        auto& captured =
+            *std::launder(reinterpret_cast<Captured*>(record.args));
+
+        try {
+            std::apply(
+                [&](const auto&... args) {
+                    fmt::format_to(std::back_inserter(out),
+                                   record.format_string, args...);
+                },
+                captured);
+        } catch (const std::exception& e) {
+            out.clear();
+            fmt::format_to(std::back_inserter(out), "<format error: {}> {}",
+                           e.what(), record.format_string);
+        }
+
+        captured.~Captured();
+    }
+
+    /// Returns nullptr if the record is dropped
+    Record* AcquireRecord()
+    {
+        auto head = head_.load(std::memory_order_relaxed);
+
+        while (head - cached_tail_ >= kCapacity) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head - cached_tail_ < kCapacity) {
+                break;
+            }
+
+            if (overflow_policy_ == LogOverflowPolicy::kDrop) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            WakeWriter(false);
+            std::this_thread::yield();
+        }
 
-    fmt::ostream& CSVFileStream()
+        return &records_[head & (kCapacity - 1)];
+    }
+
+    void Publish()
     {
-        static fmt::ostream csv_file_stream_ = fmt::output_file(csv_file_name_);
+        head_.store(head_.load(std::memory_order_relaxed) + 1);
 
-        return csv_file_stream_;
+        WakeWriter(false);
     }
 
-    LoggingCallback GetPrintToConsoleCallback()
+    /**
+     * Writer sleeps only after setting sleeping_ and checking the buffer, so
+     * it is enough to notify it when sleeping_ is set
+     */
+    void WakeWriter(bool force)
     {
-        return [this](TimeStamp ts, LogSeverity severity,
-                      std::string_view caller_type,
-                      std::string_view caller_name, std::string_view text) {
-            if (severity <= max_console_severity) {
-                if (severity == LogSeverity::kError) {
-                    fmt::print(fg(fmt::color::dark_red) | fmt::emphasis::bold,
-                               "[{:>5}] [{:>5}] [{:>15}] [{:>25}] {}\n", ts,
-                               SeverityToString(severity), caller_type,
-                               caller_name, text);
-                } else {
-                    fmt::print("[{:>5}] [{:>5}] [{:>15}] [{:>25}] {}\n", ts,
-                               SeverityToString(severity), caller_type,
-                               caller_name, text);
+        if (force || sleeping_.load()) {
+            wake_.fetch_add(1);
+            wake_.notify_one();
+        }
+    }
+
+    void WriterLoop()
+    {
+        fmt::memory_buffer buffer;
+
+        while (true) {
+            auto wake = wake_.load();
+
+            auto tail = tail_.load(std::memory_order_relaxed);
+            auto head = head_.load(std::memory_order_acquire);
+
+            if (tail != head) {
+                std::lock_guard lock{sinks_mutex_};
+
+                for (; tail != head; ++tail) {
+                    try {
+                        WriteRecord(records_[tail & (kCapacity - 1)], buffer);
+                    } catch (const std::exception& e) {
+                        fmt::print(stderr, "Failed to write log: {}\n",
+                                   e.what());
+                    }
+                    tail_.store(tail + 1, std::memory_order_release);
                 }
+                continue;
+            }
+
+            // short polling saves system calls on both sides when records are
+            // produced steadily
+            if (!stop_.load() && Poll(tail)) {
+                continue;
+            }
+
+            std::fflush(stdout);
+            if (csv_file_stream_) {
+                csv_file_stream_->flush();
+            }
+
+            flushed_.store(tail, std::memory_order_release);
+            flushed_.notify_all();
+
+            if (stop_.load()) {
+                return;
+            }
+
+            sleeping_.store(true);
+            if (head_.load() == tail && !stop_.load()) {
+                wake_.wait(wake);
+            }
+            sleeping_.store(false);
+        }
+    }
+
+    void UpdateMaxSeverity()
+    {
+        std::lock_guard lock{sinks_mutex_};
+        UpdateMaxSeverityLocked();
+    }
+
+    void UpdateMaxSeverityLocked()
+    {
+        auto max_severity =
+            max_console_severity.load(std::memory_order_relaxed);
+        if (!csv_file_name_.empty()) {
+            max_severity = std::max(
+                max_severity, max_csv_severity.load(std::memory_order_relaxed));
+        }
+        for (const auto& callback : callbacks_) {
+            max_severity = std::max(max_severity, callback.max_severity);
+        }
+
+        max_severity_.store(max_severity, std::memory_order_relaxed);
+    }
+
+    bool Poll(uint64_t tail)
+    {
+        for (size_t i = 0; i < kPollIterations; ++i) {
+            if (head_.load(std::memory_order_acquire) != tail) {
+                return true;
             }
-        };
+            std::this_thread::yield();
+        }
+
+        return false;
     }
 
-    LoggingCallback GetWriteToCSVCallback()
+    void WriteRecord(Record& record, fmt::memory_buffer& buffer)
     {
-        return [this](TimeStamp ts, LogSeverity severity,
-                      std::string_view caller_type,
-                      std::string_view caller_name, std::string_view text) {
-            if (!csv_file_name_.empty() && severity <= max_csv_severity) {
-                CSVFileStream().print("{},{},{},{},{}\n", ts,
-                                      SeverityToString(severity), caller_type,
-                                      caller_name, text);
+        std::string_view text = record.text;
+        if (record.format) {
+            buffer.clear();
+            record.format(record, buffer);
+            text = std::string_view{buffer.data(), buffer.size()};
+        }
+
+        PrintToConsole(record.ts, record.severity, record.caller_type,
+                       record.caller_name, text);
+        WriteToCSV(record.ts, record.severity, record.caller_type,
+                   record.caller_name, text);
+
+        // additional callbacks, e.g. passing to gRPC stream
+        for (const auto& [cb, max_severity] : callbacks_) {
+            if (record.severity <= max_severity) {
+                cb(record.ts, record.severity, record.caller_type,
+                   record.caller_name, text);
             }
-        };
+        }
     }
 
-    std::vector<LoggingCallback> callbacks_;
+    void PrintToConsole(TimeStamp ts, LogSeverity severity,
+                        std::string_view caller_type,
+                        std::string_view caller_name, std::string_view text)
+    {
+        if (severity > max_console_severity.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        if (severity == LogSeverity::kError) {
+            fmt::print(fg(fmt::color::dark_red) | fmt::emphasis::bold,
+                       "[{:>5}] [{:>5}] [{:>15}] [{:>25}] {}\n", ts,
+                       SeverityToString(severity), caller_type, caller_name,
+                       text);
+        } else {
+            fmt::print("[{:>5}] [{:>5}] [{:>15}] [{:>25}] {}\n", ts,
+                       SeverityToString(severity), caller_type, caller_name,
+                       text);
+        }
+    }
+
+    void WriteToCSV(TimeStamp ts, LogSeverity severity,
+                    std::string_view caller_type, std::string_view caller_name,
+                    std::string_view text)
+    {
+        if (csv_file_name_.empty() ||
+            severity > max_csv_severity.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        if (!csv_file_stream_) {
+            csv_file_stream_.emplace(fmt::output_file(csv_file_name_));
+        }
+
+        csv_file_stream_->print("{},{},{},{},{}\n", ts,
+                                SeverityToString(severity), caller_type,
+                                caller_name, text);
+    }
+
+    NowFunction now{};
+
+    static inline thread_local SimulatorLogger* thread_logger_{};
+    static inline thread_local LogCapture* thread_capture_{};
+
+    std::atomic<LogSeverity> max_console_severity{LogSeverity::kDebug},
+        max_csv_severity{LogSeverity::kDebug};
+
+    /// Maximum over all sinks
+    std::atomic<LogSeverity> max_severity_{LogSeverity::kDebug};
+
+    LogOverflowPolicy overflow_policy_{LogOverflowPolicy::kBlock};
+
+    std::vector<Record> records_;
+
+    /// Written by the producer
+    alignas(64) std::atomic<uint64_t> head_{0};
+    uint64_t cached_tail_{0};
+    std::atomic<uint64_t> dropped_{0};
+
+    /// Written by the writer thread
+    alignas(64) std::atomic<uint64_t> tail_{0};
+    std::atomic<uint64_t> flushed_{0};
+    std::atomic<bool> sleeping_{false};
+
+    alignas(64) std::atomic<uint32_t> wake_{0};
+    std::atomic<bool> stop_{false};
+
+    /// Guards sinks below, which are used by the writer thread
+    std::mutex sinks_mutex_;
+    std::string csv_file_name_{};
+    std::optional<fmt::ostream> csv_file_stream_;
+    struct Callback
+    {
+        LoggingCallback callback;
+        LogSeverity max_severity;
+    };
+
+    std::vector<Callback> callbacks_;
+
+    std::thread writer_;
 };
 
 }   // namespace sim
+
+/**
+ * Arguments are evaluated only if some sink accepts the severity, messages
+ * above SIM_LOG_MAX_SEVERITY are removed at compile time
+ */
+#define SIM_LOG(severity, caller_type, caller_name, ...)                    \
+    do {                                                                    \
+        if constexpr (static_cast<int32_t>(severity) <=                     \
+                      SIM_LOG_MAX_SEVERITY) {                               \
+            auto& sim_logger = SimulatorLogger::GetLogger();                \
+            if (sim_logger.ShouldLog(severity)) {                           \
+                sim_logger.LogNow(severity, caller_type, caller_name,       \
+                                  __VA_ARGS__);                             \
+            }                                                               \
+        }                                                                   \
+    } while (false)
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+namespace sim {
+
+/**
+ * Unbounded lock-free queue of many producers and one consumer.
+ *
+ * Nodes are linked in the order of the exchange of head_, so a producer
+ * takes its place with a single atomic operation and never waits for other
+ * producers or the consumer. The consumer owns the node before the first
+ * item and frees it when the item is taken.
+ */
+template <typename T>
+class MPSCQueue
+{
+ public:
+    MPSCQueue() : head_(new Node{}), tail_(head_.load()) {}
+
+    MPSCQueue(const MPSCQueue& other) = delete;
+
+    /// May be called from any thread
+    void Push(T value)
+    {
+        auto node = new Node{{}, std::move(value)};
+
+        auto prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+
+        pushed_.fetch_add(1, std::memory_order_release);
+        pushed_.notify_one();
+    }
+
+    /// Consumer only, returns nullopt if the queue is empty
+    std::optional<T> TryPop()
+    {
+        auto next = tail_->next.load(std::memory_order_acquire);
+        if (!next) {
+            return std::nullopt;
+        }
+
+        std::optional<T> value{std::move(next->value)};
+        delete tail_;
+        tail_ = next;
+
+        return value;
+    }
+
+    /// Consumer only, waits for an item
+    T Pop()
+    {
+        while (true) {
+            auto pushed = pushed_.load(std::memory_order_acquire);
+            if (auto value = TryPop()) {
+                return std::move(*value);
+            }
+            pushed_.wait(pushed, std::memory_order_acquire);
+        }
+    }
+
+    ~MPSCQueue()
+    {
+        while (TryPop()) {
+        }
+        delete tail_;
+    }
+
+ private:
+    struct Node
+    {
+        std::atomic<Node*> next{};
+        T value{};
+    };
+
+    /// The last pushed node, written by producers
+    alignas(64) std::atomic<Node*> head_;
+
+    /// Counts pushes to wake up the consumer
+    std::atomic<uint32_t> pushed_{0};
+
+    /// The node before the first item, owned by the consumer
+    alignas(64) Node* tail_;
+};
+
+}   // namespace sim
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+#include "types.h"
+
+namespace sim {
+
+/// SplitMix64 finalizer
+constexpr uint64_t
+Mix(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * Counter-based random generator: the n-th number is a hash of the key and n,
+ * so the stream has no state besides them and is created for free. Satisfies
+ * UniformRandomBitGenerator, so works with the standard distributions
+ */
+class RandomStream
+{
+ public:
+    typedef uint64_t result_type;
+
+    explicit RandomStream(uint64_t key = 0) : key_(key) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max()
+    {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    result_type operator()() { return At(key_, counter_++); }
+
+    /// Number of the stream with the given key at the given position
+    static constexpr result_type At(uint64_t key, uint64_t counter)
+    {
+        return Mix(key ^ Mix(counter));
+    }
+
+    /// Skips the next count numbers
+    void Discard(uint64_t count) { counter_ += count; }
+
+    uint64_t Key() const { return key_; }
+    uint64_t Counter() const { return counter_; }
+
+ private:
+    uint64_t key_;
+    uint64_t counter_{};
+};
+
+/**
+ * Hands out independent random streams derived from the simulation seed. A
+ * stream depends only on the seed and the key it is asked for, not on the
+ * order of requests or the thread asking
+ */
+class SeedManager
+{
+ public:
+    explicit SeedManager(uint64_t seed = 0) : seed_(Mix(seed)) {}
+
+    RandomStream MakeStream(uint64_t key) const
+    {
+        return RandomStream{Mix(seed_ ^ Mix(key))};
+    }
+
+    RandomStream MakeStream(UUID uuid) const
+    {
+        return MakeStream(uint64_t{uuid.Generation()} << 32 | uuid.Index());
+    }
+
+ private:
+    uint64_t seed_;
+};
+
+}   // namespace sim
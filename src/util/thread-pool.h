@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sim {
+
+/**
+ * Fixed set of threads running parallel loops.
+ *
+ * The index range of a loop is cut into chunks which are dealt to per-thread
+ * deques. A thread takes chunks from the back of its own deque and, when it
+ * is empty, steals from the front of other deques, so uneven chunks are
+ * balanced between threads. The calling thread takes part in the loop as
+ * thread 0.
+ */
+class WorkStealingPool
+{
+ public:
+    /// Loop body, gets the index and the number of the thread
+    typedef std::function<void(size_t, size_t)> LoopFunction;
+
+    explicit WorkStealingPool(size_t threads_count)
+        : queues_(std::max<size_t>(threads_count, 1))
+    {
+        for (size_t i = 1; i < queues_.size(); ++i) {
+            threads_.emplace_back([this, i] { WorkerLoop(i); });
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool& other) = delete;
+
+    size_t Size() const { return queues_.size(); }
+
+    /**
+     * Calls function for each index of [0, count) and waits for completion.
+     * The first exception thrown by the function is rethrown here after all
+     * indices are processed
+     */
+    void ParallelFor(size_t count, const LoopFunction& function)
+    {
+        if (count == 0) {
+            return;
+        }
+
+        // a worker still looking for chunks of the previous loop may take a
+        // chunk as soon as it is dealt
+        function_ = &function;
+        remaining_.store(count);
+
+        // several chunks per thread leave something to steal
+        size_t grain = std::max<size_t>(1, count / (queues_.size() * 4));
+
+        size_t queue = 0;
+        for (size_t begin = 0; begin < count; begin += grain) {
+            std::lock_guard lock{queues_[queue].mutex};
+            queues_[queue].chunks.emplace_back(begin,
+                                               std::min(begin + grain, count));
+            queue = (queue + 1) % queues_.size();
+        }
+
+        {
+            std::lock_guard lock{mutex_};
+            ++generation_;
+        }
+        wake_workers_.notify_all();
+
+        RunChunks(0);
+
+        std::unique_lock lock{mutex_};
+        loop_done_.wait(lock, [this] { return remaining_.load() == 0; });
+
+        function_ = nullptr;
+
+        if (auto exception = std::exchange(exception_, nullptr)) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    ~WorkStealingPool()
+    {
+        {
+            std::lock_guard lock{mutex_};
+            stop_ = true;
+        }
+        wake_workers_.notify_all();
+
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+ private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::pair<size_t, size_t>> chunks;
+    };
+
+    bool TakeChunk(size_t thread, std::pair<size_t, size_t>& chunk)
+    {
+        {
+            auto& own = queues_[thread];
+            std::lock_guard lock{own.mutex};
+            if (!own.chunks.empty()) {
+                chunk = own.chunks.back();
+                own.chunks.pop_back();
+                return true;
+            }
+        }
+
+        for (size_t i = 1; i < queues_.size(); ++i) {
+            auto& victim = queues_[(thread + i) % queues_.size()];
+            std::lock_guard lock{victim.mutex};
+            if (!victim.chunks.empty()) {
+                chunk = victim.chunks.front();
+                victim.chunks.pop_front();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void RunChunks(size_t thread)
+    {
+        std::pair<size_t, size_t> chunk;
+
+        while (TakeChunk(thread, chunk)) {
+            for (size_t i = chunk.first; i < chunk.second; ++i) {
+                try {
+                    (*function_)(i, thread);
+                } catch (...) {
+                    std::lock_guard lock{mutex_};
+                    if (!exception_) {
+                        exception_ = std::current_exception();
+                    }
+                }
+            }
+
+            auto size = chunk.second - chunk.first;
+            if (remaining_.fetch_sub(size) == size) {
+                std::lock_guard lock{mutex_};
+                loop_done_.notify_one();
+            }
+        }
+    }
+
+    void WorkerLoop(size_t thread)
+    {
+        uint64_t generation = 0;
+
+        while (true) {
+            {
+                std::unique_lock lock{mutex_};
+                wake_workers_.wait(lock, [this, generation] {
+                    return stop_ || generation_ != generation;
+                });
+
+                if (stop_) {
+                    return;
+                }
+                generation = generation_;
+            }
+
+            RunChunks(thread);
+        }
+    }
+
+    std::vector<Queue> queues_;
+    std::vector<std::thread> threads_;
+
+    const LoopFunction* function_{};
+    std::atomic<size_t> remaining_{0};
+    std::exception_ptr exception_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_workers_, loop_done_;
+    uint64_t generation_{0};
+    bool stop_{false};
+};
+
+}   // namespace sim
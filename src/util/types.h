@@ -31,33 +31,45 @@ using CPUUtilizationPercent =
 
 using IOBandwidthMBpS = NamedType<uint32_t, struct IOBandwidthMBpSTag>;
 
+/**
+ * Handle of an actor: index of its slot in ActorRegister and generation of the
+ * slot. Generation is increased when the slot is freed, so handles of removed
+ * actors do not match actors that reuse the slot
+ */
 class UUID
 {
  public:
     UUID() = default;
 
+    UUID(uint32_t index, uint32_t generation)
+        : index_(index), generation_(generation)
+    {
+    }
+
     UUID(const UUID& other) = default;
 
     UUID& operator=(const UUID& other) = default;
 
     UUID(UUID&& other) = default;
 
-    static UUID Generate()
+    bool operator==(const UUID& other) const
     {
-        static uint32_t serial{1};
-        return UUID{serial++};
+        return index_ == other.index_ && generation_ == other.generation_;
     }
 
-    bool operator==(const UUID& other) const { return value_ == other.value_; }
+    bool operator<(const UUID& other) const
+    {
+        return index_ < other.index_ ||
+               (index_ == other.index_ && generation_ < other.generation_);
+    }
 
-    explicit operator bool() const { return value_ != 0; }
+    explicit operator bool() const { return index_ != 0; }
 
-    explicit operator uint32_t() const { return value_; }
+    uint32_t Index() const { return index_; }
+    uint32_t Generation() const { return generation_; }
 
  private:
-    explicit UUID(uint32_t value) : value_(value) {}
-
-    uint32_t value_{};
+    uint32_t index_{}, generation_{};
 };
 
 }   // namespace sim
@@ -70,7 +82,11 @@ struct fmt::formatter<sim::UUID>
     template <typename FormatContext>
     auto format(const sim::UUID& uuid, FormatContext& ctx)
     {
-        return format_to(ctx.out(), "{}", static_cast<uint32_t>(uuid));
+        if (uuid.Generation()) {
+            return format_to(ctx.out(), "{}.{}", uuid.Index(),
+                             uuid.Generation());
+        }
+        return format_to(ctx.out(), "{}", uuid.Index());
     }
 };
 
@@ -79,6 +95,7 @@ struct std::hash<sim::UUID>
 {
     size_t operator()(const sim::UUID& uuid) const
     {
-        return hash<uint32_t>()(static_cast<uint32_t>(uuid));
+        return hash<uint64_t>()(uint64_t{uuid.Generation()} << 32 |
+                                uuid.Index());
     }
 };